@@ -1,6 +1,8 @@
 #include "Embedder.hpp"
 #include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <QDebug>
 
 // #define DEBUG
@@ -19,27 +21,123 @@ Embedder::Embedder(const Options& opt) : opt_(opt)
 		return;
 	}
 
+	// 모델 바이트는 한 번만 읽고 인스턴스마다 그 버퍼로 Net 생성
+	std::vector<uchar> bytes;
+	{
+		std::ifstream in(path, std::ios::binary);
+		bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	}
+	if (bytes.empty()) {
+		std::cerr << "[ERR] Model file read failed: " << path << "\n";
+		return;
+	}
+
+	const int k = std::max(1, opt_.instances);
 	try {
-		net_ = dnn::readNetFromONNX(path);
-		net_.setPreferableBackend(dnn::DNN_BACKEND_OPENCV);
-		net_.setPreferableTarget(dnn::DNN_TARGET_CPU);
+		for (int i = 0; i < k; ++i) {
+			auto slot = std::make_unique<Slot>();
+			slot->net = dnn::readNetFromONNX(bytes);
+			slot->net.setPreferableBackend(dnn::DNN_BACKEND_OPENCV);
+			slot->net.setPreferableTarget(dnn::DNN_TARGET_CPU);
+			slots_.push_back(std::move(slot));
+		}
 		ready_ = true;
 
 		// 출력 레이어/ID 로그
-		auto names = net_.getUnconnectedOutLayersNames();
+		auto names = slots_.front()->net.getUnconnectedOutLayersNames();
 		QStringList qn; 
 		for (auto& s : names) 
 			qn << QString::fromStdString(s);
-		qDebug() << "[Embedder] out names =" << qn;
+		qDebug() << "[Embedder] out names =" << qn << "instances=" << k;
 
 	} catch (const cv::Exception& e) {
 		std::cerr << "[ERR] readNetFromONNX failed: " << e.what() << "\n";
-		ready_ = false;
+		// 일부만 만들어졌으면 그만큼으로 동작
+		ready_ = !slots_.empty();
+	}
+
+	// 배치 보조 스레드: 인스턴스 수 - 1 (호출 스레드가 나머지 하나)
+	pool_ = std::make_unique<Pool>();
+	for (size_t i = 1; i < slots_.size(); ++i) pool_->threads.emplace_back([this] { poolLoop(); });
+}
+
+Embedder::~Embedder()
+{
+	if (!pool_) return;
+	{
+		std::lock_guard<std::mutex> lk(pool_->mtx);
+		pool_->stop = true;
 	}
+	pool_->wake.notify_all();
+	for (auto& t : pool_->threads) t.join();
 }
 
 bool Embedder::isReady() const { return ready_; }
 
+// 보조 스레드: task 가 올라오면 한 번 실행하고 다시 대기
+void Embedder::poolLoop()
+{
+	std::unique_lock<std::mutex> lk(pool_->mtx);
+	for (;;) {
+		pool_->wake.wait(lk, [&] { return pool_->stop || pool_->want > 0; });
+		if (pool_->stop) return;
+
+		--pool_->want;
+		++pool_->running;
+		const std::function<void()>* task = pool_->task;
+		lk.unlock();
+		(*task)();
+		lk.lock();
+		if (--pool_->running == 0) pool_->idle.notify_all();
+	}
+}
+
+// fn 을 호출 스레드와 보조 스레드 helpers 개에서 동시에 돌리고 모두 끝날 때까지 대기
+//  fn 은 공유 카운터에서 일을 꺼내 가는 형태여야 함 (늦게 깬 보조 스레드는 할 일 없이 바로 끝남)
+void Embedder::runParallel(size_t helpers, const std::function<void()>& fn) const
+{
+	helpers = std::min(helpers, pool_ ? pool_->threads.size() : 0);
+	std::unique_lock<std::mutex> busy;
+	if (helpers > 0) busy = std::unique_lock<std::mutex>(pool_->run, std::try_to_lock);
+	if (!busy.owns_lock()) {			// 보조 없음 / 다른 배치가 풀 사용 중
+		fn();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lk(pool_->mtx);
+		pool_->task = &fn;
+		pool_->want = helpers;
+	}
+	pool_->wake.notify_all();
+
+	fn();
+
+	// 아직 못 집어간 몫은 취소하고 실행 중인 보조 스레드만 기다림
+	std::unique_lock<std::mutex> lk(pool_->mtx);
+	pool_->want = 0;
+	pool_->idle.wait(lk, [&] { return pool_->running == 0; });
+	pool_->task = nullptr;
+}
+
+// 시작 위치부터 try_lock 으로 빈 인스턴스를 찾고, 모두 사용 중이면 시작 위치에서 대기
+Embedder::Slot& Embedder::acquire(std::unique_lock<std::mutex>& lk) const
+{
+	const size_t k	   = slots_.size();
+	const size_t start = nextSlot_.fetch_add(1, std::memory_order_relaxed) % k;
+	for (size_t i = 0; i < k; ++i) {
+		Slot& s = *slots_[(start + i) % k];
+		std::unique_lock<std::mutex> l(s.mtx, std::try_to_lock);
+		if (l.owns_lock()) {
+			lk = std::move(l);
+			return s;
+		}
+	}
+	Slot& s = *slots_[start];
+	lk = std::unique_lock<std::mutex>(s.mtx);
+	return s;
+}
+
 bool Embedder::isTrivialFrame(const cv::Mat& rgb, double meanMin, double stdMin) 
 {
 	if (rgb.empty() || rgb.type() != CV_8UC3) return true;
@@ -70,32 +168,10 @@ cv::Mat Embedder::preprocess(const cv::Mat& src) const
 #endif
 
 	    // ── 3) blob 생성 (모델 규약 확인: size/scale/mean/swapRB) ─────────────
-    //   ArcFace/MobileFaceNet 계열: 보통 (img-127.5)/128, RGB 입력, 112x112 또는 128x128
-	//   output: (N,C,H,W) 배치, 채널, 높이, 너비)`
-	cv::Mat in = src;
-	bool swapRB = opt_.useRGB;
-    const int S = 112; // 모델 고정 크기
-	double scale;
-	bool crop = false;
-	cv::Scalar mean;
-	if (opt_.externalNorm) {
-		scale = 1.0/128;
-		mean = cv::Scalar(127.5, 127.5, 127.5);
-	}
-	else {
-		scale = 1.0;
-		mean = cv::Scalar(0, 0, 0);
-	}
-
-    cv::Mat blob = cv::dnn::blobFromImage(
-        in,                           // 단일 입력
-        scale,                    
-        cv::Size(S, S),               
-		mean, 
-        swapRB,                      
-		crop,
-        CV_32F
-    );
+    const int S = inputSize();
+    const int shape[4] = { 1, 3, S, S };
+    cv::Mat blob(4, shape, CV_32F);
+    packFace(src, blob, 0);
 
     // ── 4) blob 형태/채널별 범위 안전 로그 ────────────────────────────────
     if (blob.dims != 4) {
@@ -126,6 +202,78 @@ cv::Mat Embedder::preprocess(const cv::Mat& src) const
     return blob; // NCHW 1x3xSxS
 }
 
+// 인스턴스 전용 입력 버퍼. 같은 N 이면 create 가 재할당하지 않음
+cv::Mat& Embedder::slotBlob(Slot& s, int n) const
+{
+	const int S = inputSize();
+	const int shape[4] = { n, 3, S, S };
+	s.blob.create(4, shape, CV_32F);
+	return s.blob;
+}
+
+// blobFromImages(scale, mean, swapRB) 와 같은 값을 한 번의 읽기로 채움 (flip / 중간 Mat 없음)
+//   ArcFace/MobileFaceNet 계열: 보통 (img-127.5)/128, RGB 입력, 112x112 또는 128x128
+void Embedder::packFace(const cv::Mat& face, cv::Mat& blob, int n, int m) const
+{
+	const int S = inputSize();
+	cv::Mat src = face;
+	if (src.cols != S || src.rows != S) cv::resize(face, src, cv::Size(S, S), 0, 0, cv::INTER_LINEAR);
+
+	const float scale = opt_.externalNorm ? 1.0f / 128 : 1.0f;
+	const float mean  = opt_.externalNorm ? 127.5f : 0.0f;
+	const int	c0	  = opt_.useRGB ? 2 : 0;		// 출력 채널 0 으로 갈 입력(BGR) 채널
+	const int	c2	  = 2 - c0;
+	const size_t plane = static_cast<size_t>(S) * S;
+
+	float* o = n >= 0 ? blob.ptr<float>(n) : nullptr;
+	float* f = m >= 0 ? blob.ptr<float>(m) : nullptr;
+	for (int y = 0; y < S; ++y) {
+		const uchar* p = src.ptr<uchar>(y);
+		const size_t row = static_cast<size_t>(y) * S;
+		for (int x = 0; x < S; ++x, p += 3) {
+			const float v0 = (p[c0] - mean) * scale;
+			const float v1 = (p[1]	- mean) * scale;
+			const float v2 = (p[c2] - mean) * scale;
+			if (o) {
+				o[row + x]			   = v0;
+				o[plane + row + x]	   = v1;
+				o[2 * plane + row + x] = v2;
+			}
+			if (f) {
+				const size_t xm = row + static_cast<size_t>(S - 1 - x);
+				f[xm]			  = v0;
+				f[plane + xm]	  = v1;
+				f[2 * plane + xm] = v2;
+			}
+		}
+	}
+}
+
+// blob 1회 추론 -> NxD 행렬. 출력 행 수가 n 과 다르면 실패
+bool Embedder::forward(Slot& s, const cv::Mat& blob, int n, cv::Mat& rows) const
+{
+	cv::Mat o;
+	try {
+		s.net.setInput(blob);
+		o = s.net.forward();
+	} catch (const cv::Exception& e) {
+		qWarning() << "[Embedder] forward N=" << n << "failed:" << e.what();
+		return false;
+	}
+	if (o.empty() || o.total() == 0 || o.total() % static_cast<size_t>(n) != 0) return false;
+	if (o.dims >= 2 && o.size[0] != n) return false;
+
+	rows = o.reshape(1, n).clone();
+	if (rows.type() != CV_32F) rows.convertTo(rows, CV_32F);
+	return true;
+}
+
+void Embedder::toVector(const cv::Mat& row, std::vector<float>& out)
+{
+	out.resize(static_cast<size_t>(row.cols));
+	std::memcpy(out.data(), row.ptr<float>(0), static_cast<size_t>(row.cols) * sizeof(float));
+}
+
 void Embedder::l2normalize(Mat& row) 
 {
 		double n = norm(row, NORM_L2);
@@ -133,46 +281,75 @@ void Embedder::l2normalize(Mat& row)
 }
 
 bool Embedder::extract(const cv::Mat& face_rgb, std::vector<float>& out) const
+{
+	return extract(face_rgb, out, NeedTta());
+}
+
+bool Embedder::extract(const cv::Mat& face_rgb, std::vector<float>& out, const NeedTta& needTta) const
 {
     if (!ready_) return false;
-    std::lock_guard<std::mutex> lk(mtx_);
+    std::unique_lock<std::mutex> lk;
+    Slot& s = acquire(lk);
+    return extractLocked(s, face_rgb, out, needTta);
+}
+
+// s.mtx 를 잡은 상태에서 호출
+bool Embedder::extractLocked(Slot& s, const cv::Mat& face_rgb, std::vector<float>& out, const NeedTta& needTta) const
+{
+    if (face_rgb.empty() || face_rgb.type() != CV_8UC3) {
+        qWarning() << "[extract] invalid face input type=" << face_rgb.type();
+        return false;
+    }
 
     try {
-        // ── 1) 원본 전처리 (BGR → preprocess 내부에서 RGB, 112x112, (x-127.5)/128) ──
-        cv::Mat blob1 = preprocess(face_rgb);
-        if (blob1.empty()) {
-            qWarning() << "[extract] empty blob (orig).";
-            return false;
+        Options::Tta mode = opt_.tta;
+        if (mode == Options::Tta::OnDemand && !needTta) mode = Options::Tta::Always;
+
+        // ── 2) Always: 원본+반전을 2장 blob 으로 한 번에 추론 (한 번 읽어 두 장 동시 기록) ──
+        if (mode == Options::Tta::Always && batchOk_) {
+            cv::Mat& blob = slotBlob(s, 2);
+            packFace(face_rgb, blob, 0, 1);
+            cv::Mat embs;
+            if (forward(s, blob, 2, embs)) {
+                cv::Mat emb = 0.5f * (embs.row(0) + embs.row(1));
+                l2normalize(emb);
+                toVector(emb, out);
+                return true;
+            }
+            // 배치 고정(N=1) 모델 -> 이후로는 순차 2회
+            qWarning() << "[extract] model rejected N=2 batch -> sequential flip-TTA";
+            batchOk_ = false;
         }
 
-        // ── 2) 추론 #1: 원본 ────────────────────────────────────────────────
-        net_.setInput(blob1);
-        cv::Mat emb1 = net_.forward();
-        if (emb1.empty() || emb1.total() == 0) {
+        // ── 3) 추론 #1: 원본 (BGR → packFace 에서 RGB, S x S) ────────────────
+        cv::Mat& blob1 = slotBlob(s, 1);
+        packFace(face_rgb, blob1, 0);
+        cv::Mat emb1;
+        if (!forward(s, blob1, 1, emb1)) {
             qCritical() << "[extract] forward empty (orig).";
             return false;
         }
 
-        // ── 3) 좌우반전 이미지 전처리 & 추론 #2 ─────────────────────────────
-        cv::Mat flipped_rgb; cv::flip(face_rgb, flipped_rgb, 1);
-        cv::Mat blob2 = preprocess(flipped_rgb);
-        if (blob2.empty()) {
-            qWarning() << "[extract] empty blob (flip).";
-            return false;
+        if (mode == Options::Tta::Off) {
+            l2normalize(emb1);
+            toVector(emb1, out);
+            return true;
+        }
+        if (mode == Options::Tta::OnDemand) {
+            cv::Mat first = emb1.clone();
+            l2normalize(first);
+            toVector(first, out);
+            if (!needTta(out)) return true;		// 1차 결과가 분명함 -> 반전 생략
         }
-        net_.setInput(blob2);
-        cv::Mat emb2 = net_.forward();
-        if (emb2.empty() || emb2.total() == 0) {
+
+        // ── 4) 좌우반전 이미지 추론 #2 ──────────────────────────────────────
+        cv::Mat& blob2 = slotBlob(s, 1);
+        packFace(face_rgb, blob2, -1, 0);
+        cv::Mat emb2;
+        if (!forward(s, blob2, 1, emb2)) {
             qCritical() << "[extract] forward empty (flip).";
             return false;
         }
-
-        // ── 4) 1xD로 평탄화 & dtype 보정 ───────────────────────────────────
-        emb1 = emb1.reshape(1, 1).clone();
-        if (emb1.type() != CV_32F) emb1.convertTo(emb1, CV_32F);
-        emb2 = emb2.reshape(1, 1).clone();
-        if (emb2.type() != CV_32F) emb2.convertTo(emb2, CV_32F);
-
         if (emb1.cols != emb2.cols) {
             qCritical() << "[extract] dim mismatch:" << emb1.cols << "vs" << emb2.cols;
             return false;
@@ -180,7 +357,7 @@ bool Embedder::extract(const cv::Mat& face_rgb, std::vector<float>& out) const
 
         // ── 5) Flip-TTA 평균 후 L2 정규화 ───────────────────────────────────
         cv::Mat emb = 0.5f * (emb1 + emb2);
-        l2normalize(emb);  // 이미 프로젝트에 있는 L2 정규화 유틸 사용
+        l2normalize(emb);
 
 #ifdef DEBUG
         double l2 = cv::norm(emb, cv::NORM_L2);
@@ -188,9 +365,7 @@ bool Embedder::extract(const cv::Mat& face_rgb, std::vector<float>& out) const
         qDebug() << "[extract] L2=" << l2 << " min/max=" << minv << maxv << " dim=" << emb.cols;
 #endif
 
-        // ── 6) std::vector<float> 로 복사 ──────────────────────────────────
-        out.resize(static_cast<size_t>(emb.cols));
-        std::memcpy(out.data(), emb.ptr<float>(0), static_cast<size_t>(emb.cols) * sizeof(float));
+        toVector(emb, out);
         return true;
     }
     catch (const cv::Exception& e) {
@@ -199,6 +374,97 @@ bool Embedder::extract(const cv::Mat& face_rgb, std::vector<float>& out) const
     }
 }
 
+std::vector<std::vector<float>> Embedder::extractBatch(const std::vector<cv::Mat>& faces) const
+{
+	std::vector<std::vector<float>> out(faces.size());
+	if (!ready_ || faces.empty()) return out;
+
+	// 인스턴스가 여럿이면 청크를 잘게 나눠 모두 일하게 함
+	const size_t k	  = slots_.size();
+	const size_t per  = (faces.size() + k - 1) / k;
+	const size_t step = std::max<size_t>(1, std::min<size_t>(static_cast<size_t>(std::max(1, opt_.maxBatch)), per));
+	const size_t nChunks = (faces.size() + step - 1) / step;
+
+	std::atomic<size_t> next{0};
+	auto worker = [&] {
+		for (size_t c = next.fetch_add(1); c < nChunks; c = next.fetch_add(1)) {
+			const size_t b = c * step;
+			const size_t e = std::min(faces.size(), b + step);
+
+			std::unique_lock<std::mutex> lk;
+			Slot& s = acquire(lk);
+			if (batchOk_ && extractChunk(s, faces, b, e, out)) continue;
+
+			// 배치 불가 모델 / 실패 청크 -> 얼굴별 추론
+			for (size_t i = b; i < e; ++i) {
+				if (!extractLocked(s, faces[i], out[i], NeedTta())) out[i].clear();
+			}
+		}
+	};
+
+	// 호출 스레드 + 상주 보조 스레드 (청크 수 - 1 개까지)
+	runParallel(std::min(k, nChunks) - 1, worker);
+	return out;
+}
+
+// faces[begin, end) 를 blob 하나로 (TTA 시 [원본..., 반전...] 순서) 추론
+bool Embedder::extractChunk(Slot& s, const std::vector<cv::Mat>& faces, size_t begin, size_t end,
+							std::vector<std::vector<float>>& out) const
+{
+	const bool tta = (opt_.tta != Options::Tta::Off);
+
+	std::vector<size_t>  idx;			// 유효한 입력의 원래 위치
+	for (size_t i = begin; i < end; ++i) {
+		if (faces[i].empty() || faces[i].type() != CV_8UC3) {
+			qWarning() << "[extractBatch] invalid face input #" << i << "type=" << faces[i].type();
+			out[i].clear();
+			continue;
+		}
+		idx.push_back(i);
+	}
+	if (idx.empty()) return true;
+
+	const int n = static_cast<int>(idx.size());
+	const int rowsN = tta ? 2 * n : n;
+	cv::Mat embs;
+	try {
+		cv::Mat& blob = slotBlob(s, rowsN);
+		for (int k = 0; k < n; ++k) packFace(faces[idx[k]], blob, k, tta ? k + n : -1);
+		if (!forward(s, blob, rowsN, embs)) {
+			if (rowsN > 1) {
+				qWarning() << "[extractBatch] model rejected N=" << rowsN << "batch -> per-face extract";
+				batchOk_ = false;
+			}
+			return false;
+		}
+	} catch (const cv::Exception& e) {
+		qWarning() << "[extractBatch] blob failed:" << e.what();
+		return false;
+	}
+
+	for (int k = 0; k < n; ++k) {
+		cv::Mat emb = tta ? cv::Mat(0.5f * (embs.row(k) + embs.row(k + n))) : embs.row(k).clone();
+		l2normalize(emb);
+		toVector(emb, out[idx[k]]);
+	}
+	dim_.store(embs.cols, std::memory_order_relaxed);
+	return true;
+}
+
+int Embedder::embeddingDim() const
+{
+	if (!ready_) return 0;
+	if (int d = dim_.load(std::memory_order_relaxed); d > 0) return d;
+
+	// 빈 회색 얼굴 1장 추론으로 출력 차원 확인
+	std::unique_lock<std::mutex> lk;
+	Slot& s = acquire(lk);
+	cv::Mat probe(inputSize(), inputSize(), CV_8UC3, cv::Scalar(127, 127, 127));
+	cv::Mat blob = preprocess(probe);
+	cv::Mat row;
+	if (!blob.empty() && forward(s, blob, 1, row)) dim_.store(row.cols, std::memory_order_relaxed);
+	return dim_.load(std::memory_order_relaxed);
+}
 
 float Embedder::cosine(const std::vector<float>& a, const std::vector<float>& b)
 {
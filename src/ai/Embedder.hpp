@@ -4,37 +4,110 @@
 #include <QString>
 #include <vector>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <functional>
 
 class Embedder {
 public:
 		struct Options {
 				QString modelPath;
 				QString detectorModel;
-				int inputSize = 128;		// 128x128 입력
+				int inputSize = 112;		// 정방 입력 한 변 (정렬기가 이 크기로 바로 warp)
 				bool useRGB = true;			// 모델이 RGB 입력 모델
                 bool externalNorm = false;  // 내부에서 강제 크롭 여부
                 enum class Norm { ZeroToOne, MinusOneToOne } norm = Norm::ZeroToOne;
 
+				// Flip-TTA: Off = 원본만 / Always = 원본+반전 한 번에(N=2) /
+				//           OnDemand = 원본 결과가 애매할 때만 반전 추가 (판단 콜백 필요)
+				enum class Tta { Off, Always, OnDemand } tta = Tta::Always;
+
+				int maxBatch = 16;			// extractBatch 1회 forward 당 최대 얼굴 수 (반전 포함 시 x2 행)
+
+				// Net 인스턴스 풀: 인스턴스마다 잠금이 따로라 서로 다른 스레드의 추론이 병렬로 돈다
+				//  extractBatch 보조 스레드(인스턴스 수 - 1)는 생성 시 한 번 띄워 재사용
+				//  OpenCV 전역 스레드 수는 건드리지 않음 (앱 전체 설정)
+				int instances = 1;			// Net 개수 (모델 바이트는 한 번만 읽어 공유)
+
 		};
 
 		explicit Embedder(const Options& opt);
+		~Embedder();
+
+		Embedder(const Embedder&) = delete;
+		Embedder& operator=(const Embedder&) = delete;
+
 		bool isReady() const;
 
+		// 1차(원본) 임베딩을 받아 반전 TTA 가 필요한지 판단
+		using NeedTta = std::function<bool(const std::vector<float>& firstPass)>;
+
 		// 얼굴 이미지에서 256차원 백터 추출
 		bool extract(const cv::Mat& face_rgb, std::vector<float>& out) const;
+		bool extract(const cv::Mat& face_rgb, std::vector<float>& out, const NeedTta& needTta) const;
+
+		// 여러 얼굴을 maxBatch 단위 NCHW blob 으로 묶어 forward 1회씩 (갤러리 재임베딩용)
+		//  - 청크는 공유 카운터에서 꺼내 가므로 먼저 끝난 인스턴스가 남은 청크를 가져감
+		//  - 결과는 faces 와 같은 순서/개수. 실패한 얼굴은 빈 벡터
+		//  - OnDemand 는 판단 콜백이 없으므로 Always 로 처리
+		std::vector<std::vector<float>> extractBatch(const std::vector<cv::Mat>& faces) const;
+
+		// 모델 출력 차원 (첫 호출 시 1회 추론으로 확인 후 캐시, 실패 시 0)
+		int embeddingDim() const;
+		// 모델 입력 한 변. 이 크기의 얼굴이면 blob 만들 때 resize 없음
+		int inputSize() const { return opt_.inputSize; }
 
 		// 코사인 유사도 계산
 		static float cosine(const std::vector<float>& a, const std::vector<float>& b);
 		bool isTrivialFrame(const cv::Mat& rgb, double meanMin=1.0, double stdMin=1.0);
 
+		int instanceCount() const { return static_cast<int>(slots_.size()); }
+
 private:
+		// Net 1개 + 전용 잠금
+		struct Slot {
+			std::mutex   mtx;
+			cv::dnn::Net net;
+			cv::Mat		 blob;			// 입력 blob (모양이 같으면 재사용, mtx 보호)
+		};
+
+		// extractBatch 보조 스레드 풀 (한 번에 배치 하나, 사용 중이면 호출 스레드 혼자 처리)
+		struct Pool {
+			std::mutex				 run;			// 배치 하나가 풀을 점유
+			std::mutex				 mtx;
+			std::condition_variable	 wake;
+			std::condition_variable	 idle;
+			const std::function<void()>* task = nullptr;
+			size_t					 want	 = 0;	// 아직 task 를 집어가지 않은 보조 스레드 수
+			size_t					 running = 0;	// task 실행 중인 보조 스레드 수
+			bool					 stop	 = false;
+			std::vector<std::thread> threads;
+		};
+
 		Options opt_;
-		mutable std::mutex mtx_;
-		mutable cv::dnn::Net net_;
+		std::vector<std::unique_ptr<Slot>> slots_;
+		std::unique_ptr<Pool> pool_;
+		mutable std::atomic<size_t> nextSlot_{0};		// 획득 시작 위치 (라운드로빈)
 		bool ready_ = false;
+		mutable std::atomic<bool> batchOk_{true};		// 모델이 N>1 배치를 받는지 (첫 실패 시 false)
+		mutable std::atomic<int>  dim_{0};				// embeddingDim 캐시
 
+		Slot& acquire(std::unique_lock<std::mutex>& lk) const;		// 비어 있는 인스턴스 우선
+		void poolLoop();
+		void runParallel(size_t helpers, const std::function<void()>& fn) const;		// 호출 스레드 + 보조 helpers 개
 		cv::Mat preprocess(const cv::Mat& src) const;
+		bool extractLocked(Slot& s, const cv::Mat& face_rgb, std::vector<float>& out, const NeedTta& needTta) const;
+		bool extractChunk(Slot& s, const std::vector<cv::Mat>& faces, size_t begin, size_t end,
+						  std::vector<std::vector<float>>& out) const;
+		// 얼굴(BGR) 한 장을 blob 의 n 번째 이미지로: 정규화 + RB 교환 + NCHW 를 한 번에
+		//  m >= 0 이면 같은 루프에서 좌우 반전본을 m 번째에 (n < 0 이면 반전본만)
+		void packFace(const cv::Mat& face, cv::Mat& blob, int n, int m = -1) const;
+		cv::Mat& slotBlob(Slot& s, int n) const;			// s.blob 을 N x 3 x S x S 로
+		bool forward(Slot& s, const cv::Mat& blob, int n, cv::Mat& rows) const;		// 출력 NxD (CV_32F)
 		static void l2normalize(cv::Mat& row);
+		static void toVector(const cv::Mat& row, std::vector<float>& out);
 };
 
 
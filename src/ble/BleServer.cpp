@@ -557,77 +557,84 @@ void BleServer::handleCommand_(const QString& s)
 	}
 	*/
 	if (s == "USERS\n") {
-		// 1) 파일 경로 조합
-		const QString filePath =
-			QDir(QCoreApplication::applicationDirPath())
-			.filePath(EMBEDDING_JSON_PATH) + EMBEDDING_JSON;
-
-		QFile f(filePath);
-		if (!f.exists()) {
+		// 갤러리 메모리 스냅샷 (파일 파싱 없음)
+		if (!gallery_) {
 			sendJsonLine(QJsonObject{
 					{"type","users"}, {"entries", QJsonArray()},
-					{"error", QString("embedding not found: %1").arg(filePath)}
+					{"error", "gallery service not ready"}
 					});
 			return;
 		}
-		if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
-			sendJsonLine(QJsonObject{
-					{"type","users"}, {"entries", QJsonArray()},
-					{"error", QString("open failed: %1").arg(f.errorString())}
-					});
-			return;
-		}
-
-		const QByteArray raw = f.readAll();
-		f.close();
-
-		QJsonParseError perr;
-		const QJsonDocument doc = QJsonDocument::fromJson(raw, &perr);
-		if (perr.error != QJsonParseError::NoError || !doc.isObject()) {
-			sendJsonLine(QJsonObject{
-					{"type","users"}, {"entries", QJsonArray()},
-					{"error", QString("json parse error: %1").arg(perr.errorString())}
-					});
-			return;
-		}
-
-		const QJsonObject root = doc.object();
-		const QJsonArray items = root.value("items").toArray();
+		const GalleryService::ViewPtr v = gallery_->view();
 
 		QJsonArray entries;
-
-		// (선택) 이미지 유무 판단 규칙이 있으면 여기서 체크
-		// 예: /var/lib/doorlock/faces/<id>.jpg 같은 규칙이 있다면 hasImage 계산 가능
-		auto hasImageFor = [](int /*id*/, const QString& /*name*/) -> bool {
-			// TODO: 규칙이 정해지면 파일 존재 검사로 바꾸세요.
-			return false;
-		};
-
-		for (const QJsonValue& v : items) {
-			const QJsonObject o = v.toObject();
-			const int id = o.value("id").toInt(-1);
-			const QString name = o.value("name").toString(QStringLiteral("Unknown"));
-
-			// role은 일단 기본 "user"로, 필요 시 매핑
-			const bool hasImg = hasImageFor(id, name);
-
+		for (const GalleryUserInfo& u : v->users) {
 			entries.append(QJsonObject{
-					{"id", id},
-					{"name", name},
-					{"role", "user"},
-					{"hasImage", hasImg},
-					// 클라이언트 포맷 호환 유지용(없으면 생략해도 OK)
-					{"ts", QDateTime::currentDateTimeUtc().toString(Qt::ISODate)}
+					{"id", u.id},
+					{"name", u.name},
+					{"role", "user"},		// role 은 일단 기본 "user"
+					{"hasImage", !u.images.isEmpty()},
+					// 마지막 변경 시각 (등록/재등록/이름/이미지)
+					{"ts", QDateTime::fromMSecsSinceEpoch(u.changedMs, Qt::UTC).toString(Qt::ISODate)}
 					});
 		}
 
 		sendJsonLine(QJsonObject{
 				{"type", "users"},
 				{"entries", entries},
-				{"count", entries.size()}
+				{"count", entries.size()},
+				{"version", static_cast<qint64>(v->version)},
+				{"epoch", static_cast<qint64>(v->epoch)}
 				});
 		return;
 	}
+	// USERS_SINCE <version> <epoch> : 폰 쪽 사본 이후의 변경분만
+	//  {"type":"users_delta","v":현재 버전,"e":epoch,"full":0|1,"u":[[id,name,flags,ts],..],"d":[id,..]}
+	//  flags bit0 = 이미지 있음, ts = 변경 시각(UTC 초). full 이면 u 가 전체 목록 (사본을 통째로 교체)
+	//  버전은 재부팅하면 처음부터 -> epoch 가 없거나 다르면 버전 체계가 달라 전체 목록
+	if (s.startsWith("USERS_SINCE")) {
+		QStringList toks = s.split(' ', Qt::SkipEmptyParts);
+		bool ok = toks.size() >= 2;
+		const quint64 since = ok ? toks[1].trimmed().toULongLong(&ok) : 0;
+		if (!ok) {
+			sendJsonLine(QJsonObject{{"type","users_delta"},{"error","invalid version"}});
+			return;
+		}
+		if (!gallery_) {
+			sendJsonLine(QJsonObject{{"type","users_delta"},{"error","gallery service not ready"}});
+			return;
+		}
+		const GalleryService::ViewPtr v = gallery_->view();
+
+		bool sameEpoch = false;
+		if (toks.size() >= 3) {
+			bool epochOk = false;
+			sameEpoch = toks[2].trimmed().toULongLong(&epochOk) == v->epoch && epochOk;
+		}
+		const GalleryService::Delta d = v->since(sameEpoch ? since : 0);
+
+		QJsonArray upd;
+		for (const GalleryUserInfo* u : d.users) {
+			upd.append(QJsonArray{
+					u->id, u->name,
+					u->images.isEmpty() ? 0 : 1,
+					static_cast<qint64>(u->changedMs / 1000)
+					});
+		}
+		QJsonArray del;
+		for (int id : d.removed) del.append(id);
+
+		QJsonObject out{
+				{"type", "users_delta"},
+				{"v", static_cast<qint64>(v->version)},
+				{"e", static_cast<qint64>(v->epoch)},
+				{"full", d.full ? 1 : 0},
+				{"u", upd}
+				};
+		if (!del.isEmpty()) out.insert("d", del);
+		sendJsonLine(out);
+		return;
+	}
     if (s == "SNAP\n") {
         const QString tmp = "/tmp/snap.jpg";
         QFile f(tmp);
@@ -682,6 +689,28 @@ void BleServer::handleCommand_(const QString& s)
     if (s == "OPEN\n")         { bool ok= service->staticDoorStateChange(true); sendCmdResult("OPEN", ok,  ok?"도어 열기 성공":"도어 열기 실패"); return; }
     if (s == "LOCK\n")         { bool ok= service->staticDoorStateChange(false); sendCmdResult("LOCK", ok,  ok?"도어 잠금 성공":"도어 잠금 실패"); return; }
     if (s == "RET_RECOG\n")    { int rc=0; sendCmdResult("RET_RECOG", rc==0, rc==0?"재학습 완료":"재학습 실패"); return; }
+    // DEL_USER <id> <이름> : 사용자 한 명 삭제 (갤러리 + 저널 + 등록 이미지)
+    //  확인용으로 이름까지 받아 갤러리의 이름과 같을 때만 삭제 (ID 오타로 다른 사람 삭제 방지)
+    if (s.startsWith("DEL_USER")) {
+        const QString args = s.mid(QStringLiteral("DEL_USER").size()).trimmed();
+        const int sp = args.indexOf(' ');
+        bool ok = sp > 0;
+        const int id = ok ? args.left(sp).toInt(&ok) : -1;
+        const QString name = ok ? args.mid(sp + 1).trimmed() : QString();
+        if (!ok || id < 0 || name.isEmpty()) { sendCmdResult("DEL_USER", false, "형식: DEL_USER <id> <이름>"); return; }
+
+        QString current;
+        if (gallery_) {
+            const GalleryService::ViewPtr v = gallery_->view();
+            for (const GalleryUserInfo& u : v->users) if (u.id == id) { current = u.name; break; }
+        }
+        if (current.isEmpty()) { sendCmdResult("DEL_USER", false, "없는 사용자", QJsonObject{{"id", id}}); return; }
+        if (current != name)   { sendCmdResult("DEL_USER", false, "이름 불일치", QJsonObject{{"id", id}}); return; }
+
+        ok = service && service->deleteUser(id);
+        sendCmdResult("DEL_USER", ok, ok ? "사용자 삭제 완료" : "사용자 삭제 실패", QJsonObject{{"id", id}});
+        return;
+    }
 
     if (s == "LOG_EXPORT\n") {
         if (!g_auth_ || !g_auth_->open()) { sendCmdResult("LOG_EXPORT", false, "DB 열기 실패"); return; }
@@ -27,6 +27,7 @@
 
 #include "AuthLogRepo.h"
 #include "services/FaceRecognitionService.hpp"
+#include "services/GalleryService.hpp"
 #include "include/states.hpp"
 
 #include <opencv2/core.hpp>
@@ -72,6 +73,7 @@ class BleServer : public QObject {
 	public:
 		void setInterfaceName(const QString& ifname) { hciName_ = ifname; }
 		void setDbPath(const QString& p) { dbPath_ = p; }
+		void setGalleryService(GalleryService* g) { gallery_ = g; }
 
 signals:
 		void ready();			// 광고까지 시작 완료
@@ -119,6 +121,7 @@ signals:
 		QScopedPointer<QLowEnergyController> g_peripheral_;
 		QLowEnergyService*									 g_service_ = nullptr;
 		std::unique_ptr<AuthLogRepo>				 g_auth_;
+		GalleryService*								 gallery_ = nullptr;		// 사용자 목록 (메모리 스냅샷)
 
 		// 상태
 		bool started_ = false;
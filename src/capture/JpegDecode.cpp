@@ -0,0 +1,132 @@
+#include "capture/JpegDecode.hpp"
+
+#include <QtCore/QDebug>
+#include <csetjmp>
+#include <cstdio>
+#include <jpeglib.h>
+
+namespace {
+// libjpeg 기본 에러 핸들러는 exit() -> longjmp 로 돌려받는다
+struct ErrMgr {
+	jpeg_error_mgr pub;
+	jmp_buf		   jb;
+};
+
+void onError(j_common_ptr c)
+{
+	longjmp(reinterpret_cast<ErrMgr*>(c->err)->jb, 1);
+}
+
+void onMessage(j_common_ptr) {}		// 손상 프레임 경고 로그 폭주 방지
+
+bool validJpeg(const cv::Mat& jpg)
+{
+	return !jpg.empty() && jpg.type() == CV_8UC1 && jpg.isContinuous() && jpg.total() > 4;
+}
+} // namespace
+
+namespace jpeg {
+
+int denomForWidth(int width, int maxWidth)
+{
+	int d = 1;
+	while (d < 8 && width / d > maxWidth) d *= 2;
+	return d;
+}
+
+bool decode(const cv::Mat& jpg, int denom, Color color, cv::Mat& out)
+{
+	if (!validJpeg(jpg)) return false;
+
+	jpeg_decompress_struct cinfo;
+	ErrMgr err;
+	cinfo.err			= jpeg_std_error(&err.pub);
+	err.pub.error_exit	= onError;
+	err.pub.output_message = onMessage;
+
+	if (setjmp(err.jb)) {
+		jpeg_destroy_decompress(&cinfo);
+		return false;
+	}
+
+	jpeg_create_decompress(&cinfo);
+	jpeg_mem_src(&cinfo, jpg.data, static_cast<unsigned long>(jpg.total()));
+	jpeg_read_header(&cinfo, TRUE);
+
+	cinfo.scale_num			= 1;
+	cinfo.scale_denom		= static_cast<unsigned int>(denom);
+	cinfo.out_color_space	= (color == Color::Gray) ? JCS_GRAYSCALE : JCS_EXT_BGR;
+	cinfo.dct_method		= JDCT_IFAST;
+	cinfo.do_fancy_upsampling = FALSE;		// 축소 출력에선 품질 차이 미미
+
+	jpeg_start_decompress(&cinfo);
+	out.create(static_cast<int>(cinfo.output_height), static_cast<int>(cinfo.output_width),
+			   color == Color::Gray ? CV_8UC1 : CV_8UC3);
+
+	while (cinfo.output_scanline < cinfo.output_height) {
+		JSAMPROW row = out.ptr<uchar>(static_cast<int>(cinfo.output_scanline));
+		jpeg_read_scanlines(&cinfo, &row, 1);
+	}
+
+	jpeg_finish_decompress(&cinfo);
+	jpeg_destroy_decompress(&cinfo);
+	return true;
+}
+
+bool decodeRoi(const cv::Mat& jpg, const cv::Rect& roi, cv::Mat& bgr, cv::Rect* usedRoi)
+{
+	if (usedRoi) *usedRoi = cv::Rect();
+	if (!validJpeg(jpg)) return false;
+
+	jpeg_decompress_struct cinfo;
+	ErrMgr err;
+	cinfo.err			= jpeg_std_error(&err.pub);
+	err.pub.error_exit	= onError;
+	err.pub.output_message = onMessage;
+
+	if (setjmp(err.jb)) {
+		jpeg_destroy_decompress(&cinfo);
+		return false;
+	}
+
+	jpeg_create_decompress(&cinfo);
+	jpeg_mem_src(&cinfo, jpg.data, static_cast<unsigned long>(jpg.total()));
+	jpeg_read_header(&cinfo, TRUE);
+
+	cinfo.out_color_space = JCS_EXT_BGR;
+	cinfo.dct_method	  = JDCT_ISLOW;		// 정렬/임베딩 입력은 정확도 우선
+
+	jpeg_start_decompress(&cinfo);
+
+	const cv::Rect r = roi & cv::Rect(0, 0, static_cast<int>(cinfo.output_width),
+									  static_cast<int>(cinfo.output_height));
+	if (r.width <= 0 || r.height <= 0) {
+		jpeg_abort_decompress(&cinfo);
+		jpeg_destroy_decompress(&cinfo);
+		return false;
+	}
+
+	// 열: iMCU 경계로 맞춰 해당 열만 IDCT / 행: 위쪽은 건너뛰고 아래쪽은 읽지 않음
+	JDIMENSION xoff = static_cast<JDIMENSION>(r.x);
+	JDIMENSION w	= static_cast<JDIMENSION>(r.width);
+	jpeg_crop_scanline(&cinfo, &xoff, &w);
+	if (r.y > 0) jpeg_skip_scanlines(&cinfo, static_cast<JDIMENSION>(r.y));
+
+	const JDIMENSION y0 = cinfo.output_scanline;
+	const JDIMENSION y1 = static_cast<JDIMENSION>(r.y + r.height);
+	bgr.create(static_cast<int>(y1 - y0), static_cast<int>(w), CV_8UC3);
+
+	while (cinfo.output_scanline < y1) {
+		JSAMPROW row = bgr.ptr<uchar>(static_cast<int>(cinfo.output_scanline - y0));
+		jpeg_read_scanlines(&cinfo, &row, 1);
+	}
+
+	jpeg_abort_decompress(&cinfo);		// 남은 행은 디코드하지 않음
+	jpeg_destroy_decompress(&cinfo);
+
+	if (usedRoi) *usedRoi = cv::Rect(static_cast<int>(xoff), static_cast<int>(y0),
+									 static_cast<int>(w), static_cast<int>(y1 - y0));
+	return true;
+}
+
+} // namespace jpeg
@@ -0,0 +1,20 @@
+#pragma once
+#include <opencv2/core.hpp>
+
+// MJPEG 프레임 디코드 (libjpeg-turbo)
+//  - 검출기 입력은 DCT 도메인 축소 디코드 (scale 1/2, 1/4, 1/8: IDCT 자체를 작게 수행)
+//  - 정렬용 얼굴은 원본 배율로 ROI 행/열만 디코드
+namespace jpeg {
+
+enum class Color { Bgr, Gray };
+
+// jpg: 1xN CV_8UC1 바이트열. denom = 1/2/4/8
+bool decode(const cv::Mat& jpg, int denom, Color color, cv::Mat& out);
+
+// 원본 배율 ROI 디코드. x/width 는 iMCU 경계로 넓어질 수 있음 (실제 영역 usedRoi)
+bool decodeRoi(const cv::Mat& jpg, const cv::Rect& roi, cv::Mat& bgr, cv::Rect* usedRoi = nullptr);
+
+// width / denom <= maxWidth 를 만족하는 최소 denom (최대 8)
+int denomForWidth(int width, int maxWidth);
+
+} // namespace jpeg
@@ -0,0 +1,260 @@
+#include "capture/V4l2Capture.hpp"
+
+#include <QtCore/QDebug>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <linux/videodev2.h>
+
+namespace {
+int xioctl(int fd, unsigned long req, void* arg)
+{
+	int r;
+	do { r = ::ioctl(fd, req, arg); } while (r == -1 && errno == EINTR);
+	return r;
+}
+} // namespace
+
+// fd + mmap 버퍼 묶음. 마지막 lease 가 사라질 때까지 살아 있어야 munmap 이 안전하다.
+struct V4l2Capture::Device {
+	struct Buffer {
+		void*  start  = MAP_FAILED;
+		size_t length = 0;
+	};
+
+	int					fd = -1;
+	std::vector<Buffer> buffers;
+	std::atomic<bool>	streaming{false};
+	std::atomic<int>	held{0};
+
+	~Device()
+	{
+		if (fd >= 0 && streaming.exchange(false)) {
+			v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+			xioctl(fd, VIDIOC_STREAMOFF, &type);
+		}
+		for (auto& b : buffers) {
+			if (b.start != MAP_FAILED) ::munmap(b.start, b.length);
+		}
+		if (fd >= 0) ::close(fd);
+	}
+
+	bool queue(uint32_t index)
+	{
+		v4l2_buffer buf{};
+		buf.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		buf.memory = V4L2_MEMORY_MMAP;
+		buf.index  = index;
+		return xioctl(fd, VIDIOC_QBUF, &buf) == 0;
+	}
+
+	// 버퍼 하나에 대한 참조. 소멸 시 드라이버 큐로 반환
+	struct Lease {
+		std::shared_ptr<Device> dev;
+		uint32_t index = 0;
+
+		~Lease()
+		{
+			if (!dev) return;
+			dev->held.fetch_sub(1, std::memory_order_relaxed);
+			if (dev->streaming.load(std::memory_order_acquire) && !dev->queue(index)) {
+				qWarning() << "[V4l2Capture] re-queue failed idx=" << index << "errno=" << errno;
+			}
+		}
+	};
+};
+
+V4l2Capture::~V4l2Capture()
+{
+	close();
+}
+
+std::string V4l2Capture::deviceForIndex(int cam)
+{
+	// CAM_NUM(-1) 은 첫 번째 장치
+	return "/dev/video" + std::to_string(cam < 0 ? 0 : cam);
+}
+
+bool V4l2Capture::open(const Options& opt)
+{
+	close();
+
+	auto dev = std::make_shared<Device>();
+	dev->fd = ::open(opt.device.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+	if (dev->fd < 0) {
+		qWarning() << "[V4l2Capture] open failed:" << opt.device.c_str() << std::strerror(errno);
+		return false;
+	}
+
+	v4l2_capability cap{};
+	if (xioctl(dev->fd, VIDIOC_QUERYCAP, &cap) < 0 ||
+		!(cap.capabilities & V4L2_CAP_VIDEO_CAPTURE) ||
+		!(cap.capabilities & V4L2_CAP_STREAMING)) {
+		qWarning() << "[V4l2Capture] device has no streaming capture:" << opt.device.c_str();
+		return false;
+	}
+
+	// 포맷 설정
+	v4l2_format fmt{};
+	fmt.type				= V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	fmt.fmt.pix.width		= static_cast<uint32_t>(opt.width);
+	fmt.fmt.pix.height		= static_cast<uint32_t>(opt.height);
+	fmt.fmt.pix.pixelformat = opt.fourcc;
+	fmt.fmt.pix.field		= V4L2_FIELD_NONE;
+	if (xioctl(dev->fd, VIDIOC_S_FMT, &fmt) < 0) {
+		qWarning() << "[V4l2Capture] S_FMT failed:" << std::strerror(errno);
+		return false;
+	}
+	if (fmt.fmt.pix.pixelformat != opt.fourcc) {
+		qWarning() << "[V4l2Capture] requested pixel format not supported";
+		return false;
+	}
+
+	// 프레임레이트 (실패해도 진행)
+	v4l2_streamparm parm{};
+	parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	parm.parm.capture.timeperframe.numerator   = 1;
+	parm.parm.capture.timeperframe.denominator = static_cast<uint32_t>(opt.fps > 0 ? opt.fps : 30);
+	if (xioctl(dev->fd, VIDIOC_S_PARM, &parm) < 0) {
+		qDebug() << "[V4l2Capture] S_PARM ignored:" << std::strerror(errno);
+	}
+
+	// 버퍼 요청 + mmap
+	v4l2_requestbuffers req{};
+	req.count  = static_cast<uint32_t>(std::max(2, opt.bufferCount));
+	req.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	req.memory = V4L2_MEMORY_MMAP;
+	if (xioctl(dev->fd, VIDIOC_REQBUFS, &req) < 0 || req.count < 2) {
+		qWarning() << "[V4l2Capture] REQBUFS failed count=" << req.count << std::strerror(errno);
+		return false;
+	}
+
+	dev->buffers.resize(req.count);
+	for (uint32_t i = 0; i < req.count; ++i) {
+		v4l2_buffer buf{};
+		buf.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		buf.memory = V4L2_MEMORY_MMAP;
+		buf.index  = i;
+		if (xioctl(dev->fd, VIDIOC_QUERYBUF, &buf) < 0) {
+			qWarning() << "[V4l2Capture] QUERYBUF failed idx=" << i;
+			return false;
+		}
+		void* p = ::mmap(nullptr, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, dev->fd, buf.m.offset);
+		if (p == MAP_FAILED) {
+			qWarning() << "[V4l2Capture] mmap failed idx=" << i << std::strerror(errno);
+			return false;
+		}
+		dev->buffers[i].start  = p;
+		dev->buffers[i].length = buf.length;
+	}
+
+	for (uint32_t i = 0; i < req.count; ++i) {
+		if (!dev->queue(i)) {
+			qWarning() << "[V4l2Capture] initial QBUF failed idx=" << i;
+			return false;
+		}
+	}
+
+	v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	if (xioctl(dev->fd, VIDIOC_STREAMON, &type) < 0) {
+		qWarning() << "[V4l2Capture] STREAMON failed:" << std::strerror(errno);
+		return false;
+	}
+	dev->streaming.store(true, std::memory_order_release);
+
+	width_	   = static_cast<int>(fmt.fmt.pix.width);
+	height_	   = static_cast<int>(fmt.fmt.pix.height);
+	stride_	   = static_cast<int>(fmt.fmt.pix.bytesperline);
+	fourcc_	   = fmt.fmt.pix.pixelformat;
+	timeoutMs_ = opt.timeoutMs;
+	dev_	   = std::move(dev);
+
+	qInfo() << "[V4l2Capture] streaming" << opt.device.c_str()
+			<< width_ << "x" << height_ << "stride=" << stride_
+			<< "buffers=" << req.count;
+	return true;
+}
+
+void V4l2Capture::close()
+{
+	if (!dev_) return;
+
+	// STREAMOFF 이후 lease 소멸은 QBUF 를 생략한다. munmap 은 마지막 lease 가 사라질 때
+	if (dev_->streaming.exchange(false)) {
+		v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		xioctl(dev_->fd, VIDIOC_STREAMOFF, &type);
+	}
+	if (dev_->held.load() > 0) {
+		qDebug() << "[V4l2Capture] close with" << dev_->held.load() << "buffers still referenced";
+	}
+	dev_.reset();
+	width_ = height_ = stride_ = 0;
+	fourcc_ = 0;
+}
+
+int V4l2Capture::heldBuffers() const
+{
+	return dev_ ? dev_->held.load(std::memory_order_relaxed) : 0;
+}
+
+bool V4l2Capture::read(CapturedFrame& out)
+{
+	if (!dev_) return false;
+
+	pollfd pfd{};
+	pfd.fd	   = dev_->fd;
+	pfd.events = POLLIN;
+	const int pr = ::poll(&pfd, 1, timeoutMs_);
+	if (pr <= 0) {
+		if (pr == 0 && dev_->held.load() >= static_cast<int>(dev_->buffers.size())) {
+			qWarning() << "[V4l2Capture] all buffers held downstream -> ring starved";
+		}
+		return false;
+	}
+
+	v4l2_buffer buf{};
+	buf.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	buf.memory = V4L2_MEMORY_MMAP;
+	if (xioctl(dev_->fd, VIDIOC_DQBUF, &buf) < 0) {
+		if (errno != EAGAIN) qWarning() << "[V4l2Capture] DQBUF failed:" << std::strerror(errno);
+		return false;
+	}
+
+	// 손상 프레임은 즉시 반환
+	if ((buf.flags & V4L2_BUF_FLAG_ERROR) || buf.bytesused == 0) {
+		dev_->queue(buf.index);
+		return false;
+	}
+
+	auto lease = std::make_shared<Device::Lease>();
+	lease->dev	 = dev_;
+	lease->index = buf.index;
+	dev_->held.fetch_add(1, std::memory_order_relaxed);
+
+	void* data = dev_->buffers[buf.index].start;
+
+	out.reset();
+	out.fourcc	 = fourcc_;
+	out.width	 = width_;
+	out.height	 = height_;
+	out.sequence = buf.sequence;
+	// 단조 시계 타임스탬프만 (COPY/UNKNOWN 은 0 -> 호출 측이 steady_clock 으로 채움)
+	out.tsUs	 = (buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC
+				 ? static_cast<int64_t>(buf.timestamp.tv_sec) * 1000000 + buf.timestamp.tv_usec : 0;
+	if (fourcc_ == capfmt::YUYV) {
+		out.raw = cv::Mat(height_, width_, CV_8UC2, data, static_cast<size_t>(stride_));
+	}
+	else {
+		// 압축 포맷(MJPEG 등): 바이트열 그대로
+		out.raw = cv::Mat(1, static_cast<int>(buf.bytesused), CV_8UC1, data);
+	}
+	out.lease = std::move(lease);
+	return true;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <opencv2/core.hpp>
+
+// 픽셀 포맷 코드 (v4l2_fourcc / cv::VideoWriter::fourcc 와 같은 패킹)
+namespace capfmt {
+constexpr uint32_t code(char a, char b, char c, char d) {
+	return  uint32_t(uint8_t(a))        | (uint32_t(uint8_t(b)) << 8) |
+		   (uint32_t(uint8_t(c)) << 16) | (uint32_t(uint8_t(d)) << 24);
+}
+constexpr uint32_t YUYV = code('Y','U','Y','V');
+constexpr uint32_t MJPG = code('M','J','P','G');
+} // namespace capfmt
+
+// 드라이버 버퍼를 직접 가리키는 캡처 프레임
+//  - raw 는 mmap 된 드라이버 버퍼의 뷰 (복사 없음)
+//  - lease 의 마지막 참조가 사라지는 순간 버퍼가 드라이버 큐로 반환된다
+//  - fourcc == 0 이면 cv::VideoCapture 폴백에서 온 BGR 프레임 (raw 가 자체 소유)
+struct CapturedFrame {
+	cv::Mat		raw;				// YUYV: HxW CV_8UC2 / MJPEG: 1xN CV_8UC1 / 폴백: BGR
+	uint32_t	fourcc		= 0;
+	int			width		= 0;
+	int			height		= 0;
+	uint32_t	sequence	= 0;	// 드라이버 프레임 순번
+	int64_t		tsUs		= 0;	// 커널 캡처 타임스탬프 (CLOCK_MONOTONIC, us, 단조 시계가 아니면 0)
+
+	std::shared_ptr<const void> lease;
+
+	bool empty() const { return raw.empty(); }
+	void reset() { raw.release(); lease.reset(); fourcc = 0; width = height = 0; }
+};
+
+// V4L2 streaming(mmap) 캡처 백엔드
+//  - N 개의 드라이버 버퍼를 mmap 해서 링으로 돌린다
+//  - read() 는 DQBUF 한 버퍼를 CapturedFrame 으로 넘기고, 참조가 모두 풀리면 QBUF
+//  - 하위 스테이지/인증 로그/프리뷰가 같은 버퍼를 참조만 하므로 프레임 deep copy 가 없다
+class V4l2Capture {
+	public:
+		struct Options {
+			std::string device		= "/dev/video0";
+			int			width		= 640;
+			int			height		= 480;
+			int			fps			= 30;
+			uint32_t	fourcc		= capfmt::YUYV;
+			int			bufferCount	= 8;		// 파이프라인 큐 깊이 + 단계별 처리 중 1씩 + 여유분
+			int			timeoutMs	= 200;		// read() 최대 대기
+		};
+
+		V4l2Capture() = default;
+		~V4l2Capture();
+
+		V4l2Capture(const V4l2Capture&) = delete;
+		V4l2Capture& operator=(const V4l2Capture&) = delete;
+
+		bool open(const Options& opt);
+		void close();
+		bool isOpened() const { return dev_ != nullptr; }
+
+		// 한 프레임 가져오기 (timeout 또는 에러면 false)
+		bool read(CapturedFrame& out);
+
+		int		 width()  const { return width_; }
+		int		 height() const { return height_; }
+		uint32_t fourcc() const { return fourcc_; }
+
+		// 하위 스테이지가 붙잡고 있는 버퍼 수 (링 고갈 진단용)
+		int heldBuffers() const;
+
+		static std::string deviceForIndex(int cam);
+
+	private:
+		struct Device;
+		std::shared_ptr<Device> dev_;
+
+		int		 width_  = 0;
+		int		 height_ = 0;
+		int		 stride_ = 0;
+		uint32_t fourcc_ = 0;
+		int		 timeoutMs_ = 200;
+};
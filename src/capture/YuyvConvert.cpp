@@ -0,0 +1,70 @@
+#include "capture/YuyvConvert.hpp"
+
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+// BT.601 limited range (OpenCV COLOR_YUV2BGR_YUYV 와 같은 계수)
+inline uint8_t clamp8(int v) { return static_cast<uint8_t>(v < 0 ? 0 : (v > 255 ? 255 : v)); }
+
+inline void yuvToBgr(int y, int u, int v, uint8_t* dst)
+{
+	const int c = (y - 16) * 298;
+	const int d = u - 128;
+	const int e = v - 128;
+	dst[0] = clamp8((c + 516 * d + 128) >> 8);				// B
+	dst[1] = clamp8((c - 100 * d - 208 * e + 128) >> 8);	// G
+	dst[2] = clamp8((c + 409 * e + 128) >> 8);				// R
+}
+} // namespace
+
+namespace yuyv {
+
+void toBgrHalf(const cv::Mat& src, cv::Mat& bgr)
+{
+	CV_Assert(src.type() == CV_8UC2);
+	const int outW = src.cols / 2;
+	const int outH = src.rows / 2;
+	bgr.create(outH, outW, CV_8UC3);
+
+	// 출력 1픽셀 = 입력 2행 x 매크로픽셀 1개 (Y0 U Y1 V)
+	cv::parallel_for_(cv::Range(0, outH), [&](const cv::Range& r) {
+		for (int oy = r.start; oy < r.end; ++oy) {
+			const uint8_t* a = src.ptr<uint8_t>(oy * 2);
+			const uint8_t* b = src.ptr<uint8_t>(oy * 2 + 1);
+			uint8_t*	   o = bgr.ptr<uint8_t>(oy);
+
+			for (int ox = 0; ox < outW; ++ox) {
+				const int i = ox * 4;
+				const int y = (a[i] + a[i + 2] + b[i] + b[i + 2] + 2) >> 2;
+				const int u = (a[i + 1] + b[i + 1] + 1) >> 1;
+				const int v = (a[i + 3] + b[i + 3] + 1) >> 1;
+				yuvToBgr(y, u, v, o + ox * 3);
+			}
+		}
+	});
+}
+
+cv::Mat roiToBgr(const cv::Mat& src, const cv::Rect& roi, cv::Rect* usedRoi)
+{
+	CV_Assert(src.type() == CV_8UC2);
+
+	// U/V 는 2픽셀 단위로 공유 -> x 짝수, width 짝수
+	cv::Rect r = roi & cv::Rect(0, 0, src.cols, src.rows);
+	const int x0 = r.x & ~1;
+	r.width += r.x - x0;
+	r.x		 = x0;
+	r.width	 = std::min(src.cols - r.x, (r.width + 1) & ~1);
+	if (r.width < 2 || r.height < 1) {
+		if (usedRoi) *usedRoi = cv::Rect();
+		return cv::Mat();
+	}
+
+	cv::Mat out;
+	cv::cvtColor(src(r), out, cv::COLOR_YUV2BGR_YUYV);
+	if (usedRoi) *usedRoi = r;
+	return out;
+}
+
+} // namespace yuyv
@@ -0,0 +1,14 @@
+#pragma once
+#include <opencv2/core.hpp>
+
+// YUYV(4:2:2 packed, CV_8UC2) 원본 버퍼에서 필요한 만큼만 꺼내는 변환 모음
+//  - 전체 프레임 BGR 변환 없이 축소 BGR/ROI BGR 을 바로 만든다
+namespace yuyv {
+
+// 2x2 평균 + 색변환을 한 패스로: (H/2)x(W/2) BGR. 검출기 입력
+void toBgrHalf(const cv::Mat& src, cv::Mat& bgr);
+
+// 얼굴 ROI 만 BGR 로 (x/width 는 매크로픽셀 경계로 맞춤). 실제 사용된 영역은 usedRoi
+cv::Mat roiToBgr(const cv::Mat& src, const cv::Rect& roi, cv::Rect* usedRoi = nullptr);
+
+} // namespace yuyv
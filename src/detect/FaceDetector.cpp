@@ -1,5 +1,6 @@
 #include "detect/FaceDetector.hpp"
 #include <QtCore/QDebug>
+#include <algorithm>
 
 
 bool FaceDetector::init(const std::string& modelPath,
@@ -7,6 +8,7 @@ bool FaceDetector::init(const std::string& modelPath,
 												float scoreThr, float nmsThr, int topK,
 												int backend, int target)
 {
+	std::lock_guard<std::mutex> lk(net_);
 	modelPath_ = modelPath;
 	inW_ = inputW; inH_ = inputH;
 	scoreThr_ = scoreThr; nmsThr_ = nmsThr;
@@ -70,15 +72,69 @@ std::vector<FaceDet> FaceDetector::parseYuNet(const cv::Mat& dets, float scoreTh
 	return out;
 }
 
-std::vector<FaceDet> FaceDetector::detectAll(const cv::Mat& bgr) const
+// === 검출 정책: 창/배율 ===
+cv::Rect FaceDetector::detectWindow(const cv::Size& img, const DetectPolicy& pol)
+{
+	const cv::Rect full(0, 0, img.width, img.height);
+	if (!pol.centerWindow) return full;
+
+	// 중심 허용 범위 + 가장 큰 얼굴의 반만큼 여유
+	const float margin = 0.5f * pol.maxFaceFrac * img.height;
+	const float hw = 0.5f * img.width  * pol.centerOffset + margin;
+	const float hh = 0.5f * img.height * pol.centerOffset + margin;
+	const float cx = img.width  * 0.5f;
+	const float cy = img.height * 0.5f;
+
+	return cv::Rect(cvRound(cx - hw), cvRound(cy - hh), cvRound(2 * hw), cvRound(2 * hh)) & full;
+}
+
+float FaceDetector::inputScale(const cv::Size& view, float scaleToFrame, const DetectPolicy& pol) const
+{
+	switch (pol.scale) {
+	case DetectPolicy::Scale::Native:
+		return 1.0f;
+	case DetectPolicy::Scale::Fixed:
+		return std::min(1.0f, std::min(float(inW_) / view.width, float(inH_) / view.height));
+	case DetectPolicy::Scale::Auto: {
+		// 원본 minFacePx 얼굴이 입력(= 원본 / scaleToFrame)에서 detMinFacePx 가 되는 배율
+		const float s = pol.detMinFacePx * scaleToFrame / float(std::max(1, pol.minFacePx));
+		return std::clamp(s, 0.05f, 1.0f);
+	}
+	}
+	return 1.0f;
+}
+
+std::vector<FaceDet> FaceDetector::detectAll(const cv::Mat& bgr)
+{
+	return detectIn(bgr, 1.0f, policy_);
+}
+
+// 정책(창 + 축소)을 적용해 검출하고 결과는 입력(bgr) 좌표로 돌려준다
+std::vector<FaceDet> FaceDetector::detectIn(const cv::Mat& bgr, float scaleToFrame, const DetectPolicy& pol)
 {
 	std::vector<FaceDet> out;
 	if (!ready_) return out;
 	if (bgr.empty()) return out;
 
-	// YuNet 입력 크기 갱신 (프레임 크기 변경 시 필수)
+	const cv::Rect win = detectWindow(bgr.size(), pol);
+	if (win.width <= 0 || win.height <= 0) return out;
+
+	const float s = inputScale(win.size(), scaleToFrame, pol);
+	cv::Mat input = bgr(win);
+	if (s < 1.0f) {
+		cv::Mat scaled;
+		cv::resize(input, scaled,
+				   cv::Size(std::max(1, cvRound(win.width * s)), std::max(1, cvRound(win.height * s))),
+				   0, 0, cv::INTER_AREA);
+		input = scaled;
+	}
+
+	// 입력 크기 갱신과 검출은 같은 net 상태를 쓰므로 한 번에 잠근다
+	std::lock_guard<std::mutex> lk(net_);
+
+	// YuNet 입력 크기 갱신 (입력 크기 변경 시에만)
 	try {
-		const cv::Size cur = bgr.size();
+		const cv::Size cur = input.size();
 		if (yunet_ && cur != yunet_InputSize_) {
 			yunet_->setInputSize(cur);
 			yunet_InputSize_ = cur;
@@ -91,7 +147,7 @@ std::vector<FaceDet> FaceDetector::detectAll(const cv::Mat& bgr) const
 	// -- YuNet detect ---
 	cv::Mat dets;
 	try {
-		yunet_->detect(bgr, dets);		// BGR 그대로 입력 같능
+		yunet_->detect(input, dets);		// BGR 그대로 입력 같능
 	} catch (const cv::Exception& e) {
 		qWarning() << "[FaceDetector] detect failed:" << e.what();
 		return out;
@@ -112,10 +168,10 @@ std::vector<FaceDet> FaceDetector::detectAll(const cv::Mat& bgr) const
   for (size_t i = 0; i < out.size(); ++i) {
       const auto& f = out[i];
       bool boxOk = (f.box.x >= 0 && f.box.y >= 0 &&
-                    f.box.x + f.box.width  <= bgr.cols &&
-                    f.box.y + f.box.height <= bgr.rows);
+                    f.box.x + f.box.width  <= input.cols &&
+                    f.box.y + f.box.height <= input.rows);
       auto inRange = [&](const cv::Point2f& p) {
-          return (p.x >= 0 && p.y >= 0 && p.x < bgr.cols && p.y < bgr.rows);
+          return (p.x >= 0 && p.y >= 0 && p.x < input.cols && p.y < input.rows);
       };
       bool lmOk = true; for (int k=0;k<5;k++) lmOk = lmOk && inRange(f.lmk[k]);
       qDebug() << "[FaceDetector] face" << (int)i
@@ -124,12 +180,25 @@ std::vector<FaceDet> FaceDetector::detectAll(const cv::Mat& bgr) const
   }
 #endif
 
+	// 검출 입력 좌표 -> bgr 좌표
+	const cv::Point2f off(float(win.x), float(win.y));
+	for (auto& f : out) {
+		if (s < 1.0f) scaleDet(f, 1.0f / s);
+		f.box += win.tl();
+		for (auto& p : f.lmk) p += off;
+	}
+
     return out;
 }
 
-std::optional<FaceDet> FaceDetector::detectBest(const cv::Mat& bgr) const
+std::optional<FaceDet> FaceDetector::detectBest(const cv::Mat& bgr)
+{
+	return detectBest(bgr, 1.0f);
+}
+
+// 후보 중 1개 선택 (중앙+큰 얼굴 선호)
+std::optional<FaceDet> FaceDetector::pickBest(std::vector<FaceDet>& faces, const cv::Mat& bgr)
 {
-	auto faces = detectAll(bgr);
 	if (faces.empty()) return std::nullopt;
 
 	if (faces.size() > 1) {
@@ -156,7 +225,31 @@ std::optional<FaceDet> FaceDetector::detectBest(const cv::Mat& bgr) const
 	return faces.front();
 }
 
+void FaceDetector::scaleDet(FaceDet& d, float s)
+{
+	if (s == 1.0f) return;
+	d.box = cv::Rect(cv::Point(cvRound(d.box.x * s), cvRound(d.box.y * s)),
+					 cv::Size(cvRound(d.box.width * s), cvRound(d.box.height * s)));
+	for (auto& p : d.lmk) p *= s;
+}
 
+std::vector<FaceDet> FaceDetector::detectAll(const cv::Mat& bgr, float scaleToFrame)
+{
+	auto faces = detectIn(bgr, scaleToFrame, policy_);
+	for (auto& f : faces) scaleDet(f, scaleToFrame);
+	return faces;
+}
 
+std::optional<FaceDet> FaceDetector::detectBest(const cv::Mat& bgr, float scaleToFrame)
+{
+	return detectBest(bgr, scaleToFrame, policy_);
+}
 
-
+std::optional<FaceDet> FaceDetector::detectBest(const cv::Mat& bgr, float scaleToFrame, const DetectPolicy& pol)
+{
+	// 랭킹(면적 * 중심거리 비율)은 균일 스케일에 불변 -> 입력 좌표로 고른 뒤 환산
+	auto faces = detectIn(bgr, scaleToFrame, pol);
+	auto best = pickBest(faces, bgr);
+	if (best) scaleDet(*best, scaleToFrame);
+	return best;
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <mutex>
 #include <optional>
 #include <string>
 #include <vector>
@@ -7,6 +8,22 @@
 #include <opencv2/objdetect.hpp>  // cv::FaceDetectorYN
 #include "include/types.hpp"			// FaceDet
 
+// 검출 입력 정책
+//  - Native: 입력 이미지 크기 그대로 (기존 동작)
+//  - Fixed : init() 의 inputW x inputH 안에 들어오도록 비율 유지 축소
+//  - Auto  : "허용되는 최소 얼굴(minFacePx)" 이 검출기 입력에서 detMinFacePx 가 되도록 축소
+//  - centerWindow: 중앙 오프셋 규칙(LivenessGate) 밖에 중심이 올 얼굴은 어차피 탈락 -> 그 영역은 검출 안 함
+struct DetectPolicy {
+	enum class Scale { Native, Fixed, Auto };
+
+	Scale scale			= Scale::Fixed;
+	bool  centerWindow	= false;
+	float centerOffset	= 0.30f;	// 프레임 반폭/반높이 대비 허용 중심 오프셋
+	float maxFaceFrac	= 0.6f;		// 창 여유분: 가장 큰 얼굴 = 프레임 높이 * maxFaceFrac
+	int   minFacePx		= 96;		// 허용되는 최소 얼굴 (원본 프레임 px)
+	int   detMinFacePx	= 32;		// 검출기 입력에서 최소 얼굴이 이 크기 이상 유지
+};
+
 // YuNet/UltraFace 등 어떤 백엔드든 래핑 가능하도록 최소 인터페이스만 둠
 class FaceDetector {
 	public:
@@ -21,16 +38,39 @@ class FaceDetector {
 							int target  = cv::dnn::DNN_TARGET_CPU);
 
 
+		// 검출 호출은 내부 YuNet 의 입력 크기를 바꾸므로 non-const.
+		// 같은 인스턴스를 여러 스레드가 부르면 net_ 잠금으로 직렬화 (병렬이 필요하면 스레드별 인스턴스)
+
 		// 네 랭킹 규칙(중앙+큰 얼굴 선호)으로 1개만 선택
-		std::optional<FaceDet> detectBest(const cv::Mat& bgr) const;
+		std::optional<FaceDet> detectBest(const cv::Mat& bgr);
 
 		// 프레임에서 전체 후보 반환 (원본 좌표계)
-		std::vector<FaceDet> detectAll(const cv::Mat& bgr) const;
+		std::vector<FaceDet> detectAll(const cv::Mat& bgr);
+
+		// 축소 입력에서 검출 후 원본 프레임 좌표로 환산 (scaleToFrame = 원본 / 입력)
+		std::vector<FaceDet> detectAll(const cv::Mat& bgr, float scaleToFrame);
+		std::optional<FaceDet> detectBest(const cv::Mat& bgr, float scaleToFrame);
+
+		// 기본 정책 대신 호출마다 정책 지정 (예: 등록 모드는 전체 프레임)
+		std::optional<FaceDet> detectBest(const cv::Mat& bgr, float scaleToFrame, const DetectPolicy& pol);
+
+		// 박스/랜드마크 좌표 스케일
+		static void scaleDet(FaceDet& d, float s);
+
+		// 기본 검출 정책 (검출 스레드 시작 전에 설정)
+		void setPolicy(const DetectPolicy& p) { policy_ = p; }
+		const DetectPolicy& policy() const { return policy_; }
 
 	private:
 		// YuNet 출력 파서 (네 parseYuNet 그대로)
 		static std::vector<FaceDet> parseYuNet(const cv::Mat& dets, float scoreThresh);
 
+		// 정책에 따른 검출 창(입력 좌표)과 축소 배율
+		static cv::Rect detectWindow(const cv::Size& img, const DetectPolicy& pol);
+		float	 inputScale(const cv::Size& view, float scaleToFrame, const DetectPolicy& pol) const;
+		std::vector<FaceDet> detectIn(const cv::Mat& bgr, float scaleToFrame, const DetectPolicy& pol);
+		static std::optional<FaceDet> pickBest(std::vector<FaceDet>& faces, const cv::Mat& bgr);
+
 	private:
 		bool ready_ = false;
 		int inW_ = 320; 
@@ -40,10 +80,12 @@ class FaceDetector {
 		int topK_ = 500;
 		int backend_  = cv::dnn::DNN_BACKEND_OPENCV;
 		int target_   = cv::dnn::DNN_TARGET_CPU;
+		DetectPolicy policy_;
 
 
 		std::string modelPath_;
+		std::mutex net_;						// yunet_ 의 setInputSize + detect 를 한 묶음으로
 		cv::Ptr<cv::FaceDetectorYN> yunet_;		// Yunet 핸들
-		mutable cv::Size yunet_InputSize_{0, 0};  // setInputSize chache
+		cv::Size yunet_InputSize_{0, 0};  // setInputSize chache
 };
 
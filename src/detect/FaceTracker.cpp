@@ -0,0 +1,136 @@
+#include "detect/FaceTracker.hpp"
+
+#include <QtCore/QDebug>
+#include <algorithm>
+#include <opencv2/imgproc.hpp>
+
+bool FaceTracker::init(const std::string& modelPath, const Options& opt)
+{
+	opt_ = opt;
+	ready_ = roiDet_.init(modelPath, opt_.roiInput, opt_.roiInput,
+						  /*scoreThr*/0.6f, /*nmsThr*/0.3f, /*topK*/50);
+
+	// ROI 입력은 이미 고정 크기 크롭 -> 창/축소 없이 그대로
+	DetectPolicy pol;
+	pol.scale = DetectPolicy::Scale::Native;
+	roiDet_.setPolicy(pol);
+	reset();
+
+	if (!ready_) {
+		qWarning() << "[FaceTracker] ROI detector init failed -> full-frame detection only";
+		return false;
+	}
+	qDebug() << "[FaceTracker] init Ok fullEveryN=" << opt_.fullEveryN
+			 << "roiInput=" << opt_.roiInput << "pad=" << opt_.roiPad;
+	return true;
+}
+
+void FaceTracker::reset()
+{
+	active_	   = false;
+	last_	   = FaceDet{};
+	vel_	   = cv::Point2f(0.f, 0.f);
+	sinceFull_ = 0;
+}
+
+float FaceTracker::iou(const cv::Rect& a, const cv::Rect& b)
+{
+	const int inter = (a & b).area();
+	const int uni	= a.area() + b.area() - inter;
+	return uni > 0 ? float(inter) / float(uni) : 0.f;
+}
+
+std::optional<FaceDet> FaceTracker::update(const cv::Size& frameSize,
+										   const FullDetect& fullDetect,
+										   const RoiFetch& fetchRoi)
+{
+	// 1) 추적 중이고 주기 안이면 ROI 만
+	if (ready_ && active_ && sinceFull_ < opt_.fullEveryN) {
+		if (auto d = trackInRoi(frameSize, fetchRoi)) {
+			++stats_.roi;
+			++sinceFull_;
+			accept(*d, false);
+			return last_;
+		}
+		++stats_.lost;
+	}
+
+	// 2) 전체 프레임 검출 (주기 도래 / 추적 실패 / 트랙 없음)
+	++stats_.full;
+	sinceFull_ = 0;
+	auto best = fullDetect();
+	if (!best) {
+		active_ = false;
+		vel_	= cv::Point2f(0.f, 0.f);
+		return std::nullopt;
+	}
+	accept(*best, true);
+	return last_;
+}
+
+std::optional<FaceDet> FaceTracker::trackInRoi(const cv::Size& frameSize, const RoiFetch& fetchRoi)
+{
+	// 등속 예측 박스
+	cv::Rect pred = last_.box + cv::Point(cvRound(vel_.x), cvRound(vel_.y));
+
+	// 패딩 정사각 ROI
+	const cv::Point2f c(pred.x + pred.width * 0.5f, pred.y + pred.height * 0.5f);
+	const float half = 0.5f * opt_.roiPad * std::max(pred.width, pred.height);
+	cv::Rect want(cvRound(c.x - half), cvRound(c.y - half), cvRound(2 * half), cvRound(2 * half));
+	want &= cv::Rect(0, 0, frameSize.width, frameSize.height);
+	if (want.width < 16 || want.height < 16) return std::nullopt;
+
+	cv::Rect used;
+	cv::Mat crop = fetchRoi(want, &used);
+	if (crop.empty() || used.area() <= 0) return std::nullopt;
+
+	// 비율 유지 축소 후 우/하단 패딩 -> 항상 roiInput x roiInput
+	const int   side = opt_.roiInput;
+	const float s	 = float(side) / float(std::max(crop.cols, crop.rows));
+	cv::Mat scaled;
+	cv::resize(crop, scaled, cv::Size(std::max(1, cvRound(crop.cols * s)), std::max(1, cvRound(crop.rows * s))),
+			   0, 0, cv::INTER_AREA);
+	cv::Mat input;
+	cv::copyMakeBorder(scaled, input, 0, side - scaled.rows, 0, side - scaled.cols,
+					   cv::BORDER_CONSTANT, cv::Scalar(0, 0, 0));
+
+	auto faces = roiDet_.detectAll(input, 1.0f / s);
+	if (faces.empty()) return std::nullopt;
+
+	// 예측 박스와 가장 많이 겹치는 후보
+	const cv::Point off = used.tl();
+	float bestIou = 0.f;
+	std::optional<FaceDet> bestDet;
+	for (auto& f : faces) {
+		f.box += off;
+		for (auto& p : f.lmk) p += cv::Point2f(off);
+		const float v = iou(f.box, pred);
+		if (v > bestIou) { bestIou = v; bestDet = f; }
+	}
+
+	if (!bestDet || bestIou < opt_.minIou || bestDet->score < opt_.minScore) return std::nullopt;
+	return bestDet;
+}
+
+void FaceTracker::accept(const FaceDet& d, bool fromFull)
+{
+	FaceDet cur = d;
+
+	// ROI 추적 결과는 trackInRoi 에서 이미 예측 박스와 대조됨
+	const bool same = active_ && (!fromFull || iou(cur.box, last_.box) >= opt_.minIou);
+	if (same) {
+		const cv::Point2f c0(last_.box.x + last_.box.width * 0.5f, last_.box.y + last_.box.height * 0.5f);
+		const cv::Point2f c1(cur.box.x + cur.box.width * 0.5f, cur.box.y + cur.box.height * 0.5f);
+		// 추적 실패 직후의 전체 검출 결과는 튈 수 있어 속도는 ROI 추적에서만 갱신
+		if (!fromFull) vel_ = 0.5f * vel_ + 0.5f * (c1 - c0);
+		cur.trackId = last_.trackId;
+	}
+	else {
+		vel_		= cv::Point2f(0.f, 0.f);
+		cur.trackId = nextId_++;
+		qDebug() << "[FaceTracker] new track id=" << cur.trackId;
+	}
+
+	last_	= cur;
+	active_ = true;
+}
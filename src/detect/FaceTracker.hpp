@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <opencv2/core.hpp>
+
+#include "detect/FaceDetector.hpp"
+#include "include/types.hpp"		// FaceDet
+
+// 검출 보조 트래커
+//  - 전체 프레임 검출은 N 프레임마다 또는 추적 신뢰도가 떨어졌을 때만
+//  - 그 사이엔 직전 박스(+등속 예측) 주변 패딩 ROI 만 고정 크기로 잘라 YuNet 실행
+//  - 같은 얼굴이 이어지는 동안 trackId 유지 (새 얼굴이면 새 ID)
+// detect 스테이지 스레드 전용 (동기화 없음)
+class FaceTracker {
+	public:
+		struct Options {
+			int		fullEveryN	= 10;		// 최소 이 주기로 전체 검출
+			float	roiPad		= 2.0f;		// 박스 대비 ROI 크기 배율
+			int		roiInput	= 160;		// ROI 검출 입력 한 변 (고정 -> setInputSize 재계산 없음)
+			float	minScore	= 0.7f;		// ROI 검출 점수가 이보다 낮으면 전체 검출로
+			float	minIou		= 0.3f;		// 예측 박스와의 IoU 하한 (같은 얼굴 판정)
+		};
+
+		// 원본 좌표 ROI -> BGR (used: 실제로 잘린 영역)
+		using RoiFetch	 = std::function<cv::Mat(const cv::Rect& want, cv::Rect* used)>;
+		// 전체 프레임 검출 (원본 좌표)
+		using FullDetect = std::function<std::optional<FaceDet>()>;
+
+		struct Stats {
+			uint64_t full  = 0;			// 전체 검출 횟수
+			uint64_t roi   = 0;			// ROI 검출 성공 횟수
+			uint64_t lost  = 0;			// ROI 실패 -> 전체 검출 전환 횟수
+		};
+
+		bool init(const std::string& modelPath, const Options& opt);
+		bool init(const std::string& modelPath) { return init(modelPath, Options{}); }
+		void reset();
+
+		std::optional<FaceDet> update(const cv::Size& frameSize,
+									  const FullDetect& fullDetect,
+									  const RoiFetch& fetchRoi);
+
+		const Stats& stats() const { return stats_; }
+
+	private:
+		std::optional<FaceDet> trackInRoi(const cv::Size& frameSize, const RoiFetch& fetchRoi);
+		void accept(const FaceDet& d, bool fromFull);
+
+		static float iou(const cv::Rect& a, const cv::Rect& b);
+
+		Options		 opt_;
+		FaceDetector roiDet_;				// ROI 전용 YuNet 인스턴스 (입력 roiInput^2 고정)
+		bool		 ready_ = false;
+
+		// 트랙 상태
+		bool		 active_	= false;
+		FaceDet		 last_{};
+		cv::Point2f	 vel_{0.f, 0.f};		// 박스 중심 속도 (px/frame)
+		int			 sinceFull_	= 0;
+		int			 nextId_	= 1;
+
+		Stats		 stats_;
+};
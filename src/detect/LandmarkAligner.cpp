@@ -1,6 +1,10 @@
 #include "LandmarkAligner.hpp"
 #include <algorithm>
 #include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 const std::array<cv::Point2f, 5> LandmarkAligner::kDst5_112 = {{
 	{38.2946f, 51.6963f},			// LE
@@ -10,12 +14,107 @@ const std::array<cv::Point2f, 5> LandmarkAligner::kDst5_112 = {{
 	{70.7299f, 92.2041f}			// RM
 }};
 
-cv::Mat LandmarkAligner::alignBy5pts(const cv::Mat& srcBgr, 
+// === 디버그 덤프 (비동기 PNG 저장) ===
+// 큐는 몇 장만, 넘치면 새 프레임을 버린다
+struct LandmarkAligner::DebugDump {
+	static constexpr size_t kMaxQueue = 4;
+
+	std::string				dir;
+	int						everyN = 30;
+	std::mutex				mtx;
+	std::condition_variable cond;
+	std::deque<std::pair<std::string, cv::Mat>> queue;
+	bool					stop = false;
+	std::thread				th;
+
+	DebugDump(const std::string& d, int n) : dir(d), everyN(std::max(1, n))
+	{
+		if (!dir.empty() && dir.back() != '/') dir.push_back('/');
+		th = std::thread([this] { run(); });
+	}
+
+	~DebugDump()
+	{
+		{
+			std::lock_guard<std::mutex> lk(mtx);
+			stop = true;
+		}
+		cond.notify_one();
+		if (th.joinable()) th.join();
+	}
+
+	void push(std::string name, const cv::Mat& img)
+	{
+		{
+			std::lock_guard<std::mutex> lk(mtx);
+			if (queue.size() >= kMaxQueue) return;
+			queue.emplace_back(dir + name, img.clone());
+		}
+		cond.notify_one();
+	}
+
+	void run()
+	{
+		std::unique_lock<std::mutex> lk(mtx);
+		for (;;) {
+			cond.wait(lk, [this] { return stop || !queue.empty(); });
+			if (queue.empty()) return;			// stop
+			auto item = std::move(queue.front());
+			queue.pop_front();
+			lk.unlock();
+			cv::imwrite(item.first, item.second);
+			lk.lock();
+		}
+	}
+};
+
+LandmarkAligner::LandmarkAligner() = default;
+LandmarkAligner::~LandmarkAligner() = default;
+
+void LandmarkAligner::setDebugDump(const std::string& dir, int everyN)
+{
+	dump_.reset();
+	if (!dir.empty()) dump_ = std::make_unique<DebugDump>(dir, everyN);
+}
+
+// 중심 이동 후 교차항 두 개로 c = s*cosθ, d = s*sinθ 를 바로 구함 (2D 에서 Umeyama 의 SVD 가 이 식으로 풀림)
+//  [x']   [c -d] [x]   [tx]
+//  [y'] = [d  c] [y] + [ty]
+cv::Mat LandmarkAligner::similarity5(const std::array<cv::Point2f,5>& src,
+									 const std::array<cv::Point2f,5>& dst)
+{
+	double msx = 0, msy = 0, mdx = 0, mdy = 0;
+	for (int i = 0; i < 5; ++i) {
+		msx += src[i].x; msy += src[i].y;
+		mdx += dst[i].x; mdy += dst[i].y;
+	}
+	msx /= 5; msy /= 5; mdx /= 5; mdy /= 5;
+
+	double var = 0, a = 0, b = 0;
+	for (int i = 0; i < 5; ++i) {
+		const double sx = src[i].x - msx, sy = src[i].y - msy;
+		const double dx = dst[i].x - mdx, dy = dst[i].y - mdy;
+		var += sx * sx + sy * sy;
+		a	+= sx * dx + sy * dy;
+		b	+= sx * dy - sy * dx;
+	}
+	if (var < 1e-6) return cv::Mat();
+
+	const double c = a / var;
+	const double d = b / var;
+	cv::Mat M(2, 3, CV_64F);
+	double* m = M.ptr<double>();
+	m[0] = c;  m[1] = -d; m[2] = mdx - (c * msx - d * msy);
+	m[3] = d;  m[4] =  c; m[5] = mdy - (d * msx + c * msy);
+	return M;
+}
+
+cv::Mat LandmarkAligner::alignBy5pts(const cv::Mat& srcBgr,
 																		 const std::array<cv::Point2f,5>& src5_in,
 																		 const cv::Size& outSize)
 {
 	// 입력/출력 크기 가드
-	if (srcBgr.empty() || outSize.width <= 0 || outSize.height <= 0) 
+	if (srcBgr.empty() || outSize.width <= 0 || outSize.height <= 0)
 		return cv::Mat();
 
 	 // [LE, RE, Nose, LM, RM] 순서 유지 + 좌우 정합 보정
@@ -23,22 +122,24 @@ cv::Mat LandmarkAligner::alignBy5pts(const cv::Mat& srcBgr,
 	if (s[0].x > s[1].x) std::swap(s[0], s[1]);
 	if (s[3].x > s[4].x) std::swap(s[3], s[4]);
 
+	// 템플릿을 출력 크기로 스케일 -> 중간 112 이미지 없이 한 번에 warp
+	std::array<cv::Point2f, 5> d = kDst5_112;
+	const float sx = outSize.width  / 112.0f;
+	const float sy = outSize.height / 112.0f;
+	for (auto& p : d) { p.x *= sx; p.y *= sy; }
 
-	std::vector<cv::Point2f> src(s.begin(), s.end());
-	std::vector<cv::Point2f> dst(kDst5_112.begin(), kDst5_112.end());	// 112x112 기준 타겟
-
-	const cv::Size warpSize(112, 112);
-	cv::Mat M = cv::estimateAffinePartial2D(src, dst, cv::noArray(), cv::RANSAC, 3.0, 2000, 0.99);
+	cv::Mat M = similarity5(s, d);
 	if (M.empty()) return {};
 
-	cv::Mat aligned112;
-	cv::warpAffine(srcBgr, aligned112, M, warpSize,
+	cv::Mat out;
+	cv::warpAffine(srcBgr, out, M, outSize,
 								 cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(127, 127, 127));
 
-	if (outSize == warpSize) return aligned112;
-
-	cv::Mat out;
-	cv::resize(aligned112, out, outSize, 0, 0, cv::INTER_LINEAR);
-	imwrite("alignBy5pt.png", aligned112);
+	if (dump_) {
+		const unsigned n = frames_.fetch_add(1, std::memory_order_relaxed);
+		if (n % static_cast<unsigned>(dump_->everyN) == 0) {
+			dump_->push("align_" + std::to_string(n) + ".png", out);
+		}
+	}
 	return out;
 }
@@ -1,19 +1,36 @@
 #pragma once
 #include <array>
+#include <atomic>
+#include <memory>
+#include <string>
 #include <opencv2/opencv.hpp>
 
 class LandmarkAligner {
 	public:
-		LandmarkAligner()  = default;
-		~LandmarkAligner() = default;
+		LandmarkAligner();
+		~LandmarkAligner();
 
 		// 5점 기준 정렬. 성공 시 정렬된 BGR 얼굴(출력 크기 outSize), 실패 시 빈 Mat
     // lmk 순서: [LE, RE, Nose, LM, RM]  (YuNet/네 계약과 동일)
+		// outSize 는 임베더 입력 크기 그대로 (warpAffine 한 번, 추가 resize 없음)
 		cv::Mat alignBy5pts(const cv::Mat& srcBgr,
 										  const std::array<cv::Point2f,5>& src5_in,
 											const cv::Size& outSize = {112, 112});
 
+		// 5점 -> 템플릿 최소제곱 닮음 변환 (Umeyama 닫힌 해, 회전+균일 스케일+이동)
+		//  2x3 CV_64F. 점들이 한 곳에 모여 퇴화하면 빈 Mat
+		static cv::Mat similarity5(const std::array<cv::Point2f,5>& src,
+								   const std::array<cv::Point2f,5>& dst);
+
+		// 디버깅용 정렬 결과 저장 (기본 꺼짐). everyN 프레임마다 한 장, 별도 스레드에서 PNG 쓰기
+		//  쓰기가 밀리면 버림 -> 정렬 경로는 디스크 I/O 를 기다리지 않음. dir 이 비면 끔
+		void setDebugDump(const std::string& dir, int everyN = 30);
+
 	private:
 		// 기준 좌표(ArcFace 112x112 계열). outSize에 맞춰 스케일링해서 사용.
     static const std::array<cv::Point2f,5> kDst5_112;
+
+		struct DebugDump;
+		std::unique_ptr<DebugDump> dump_;
+		std::atomic<unsigned>	   frames_{0};
 };
@@ -27,7 +27,10 @@
 #define SFACE_RECOGNIZER						"face_recognizer_fast.onnx"
 
 #define EMBEDDING_JSON_PATH						ASSERT "embedding/"
-#define EMBEDDING_JSON							"embeddings.json"
+#define EMBEDDING_JSON							"embeddings.json"		// 구버전 이관 / 디버깅 내보내기 전용
+#define EMBEDDING_STORE							"embeddings.bin"		// 바이너리 갤러리 저장소 (EmbeddingStore)
+#define EMBEDDING_ANN							"gallery.hnsw"			// 대규모 갤러리용 HNSW 그래프
+#define EMBEDDING_JOURNAL						"embeddings.journal"	// embeddings.bin 이후 추가/삭제 저널
 
 
 // Images
@@ -6,4 +6,5 @@ namespace recog {
 	inline constexpr double UNK_THR	   = 0.80;
 	inline constexpr double BLUR_THR	 = 60.0;
 	inline constexpr int	  STREAK_N   = 3;
+	inline constexpr float  TTA_MARGIN = 0.08f;	// 1차 유사도가 임계값 +-이 범위면 flip-TTA 추가
 }
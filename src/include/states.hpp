@@ -33,7 +33,11 @@ enum class DetectedStatus {
 	TooSmall,			// 얼굴 박스가 너무 작음/멀다
 	TooBlurry,			// 흔들림/초점 불량
 	TooDark,			// 조도 부족
-	LowContrast			// 중앙부 대비 약함(얼굴 중앙이 흐릿)
+	LowContrast,		// 중앙부 대비 약함(얼굴 중앙이 흐릿)
+
+	// Liveness
+	LivenessCheck,		// 라이브니스 판정 대기 (움직임 필요)
+	Spoof				// 화면/사진 의심
 };
 
 
@@ -9,6 +9,19 @@ struct FaceDet {
 	cv::Rect box;
 	std::array<cv::Point2f, 5> lmk;				// leftEye, right Eye, nose, mouthL, mouthR
 	float score;
+	int trackId = -1;							// FaceTracker 트랙 ID (-1 = 추적 안 함)
+};
+
+// 얼굴 1개 단위 샘플: 정렬 크롭 + 임베딩(프레임당 1회만 계산) + 품질 메타
+//  - embedding 이 비어 있으면 아직 추출 전 -> 처음 필요한 곳에서 채우고 이후는 재사용
+struct FaceSample {
+	FaceDet				det{};				// 검출 결과 (box/lmk/score/trackId)
+	cv::Mat				aligned;			// 정렬된 얼굴 (BGR)
+	std::vector<float>	embedding;			// L2 정규화 임베딩
+	bool				qualityOk = false;	// 인식용 품질 게이트 통과 여부
+
+	bool empty() const { return aligned.empty(); }
+	bool hasEmbedding() const { return !embedding.empty(); }
 };
 
 struct DetOut {
@@ -40,8 +53,8 @@ struct GalleryEntry {
 struct UserEmbedding {
     int                 id = -1;
     QString             name;
-    std::vector<float>  embedding; // L2 정규화된 벡터
-		cv::Mat							proto;				   // 1xD, CV_32F, L2=1 고정 클론
+    std::vector<float>  embedding; // L2 정규화된 벡터 (검색용 사본은 GalleryIndex 가 보관)
+    std::vector<std::vector<float>> prototypes;	// 포즈별 대표 벡터 (L2 정규화). 비어 있으면 embedding 하나로 매칭
 };
 
 
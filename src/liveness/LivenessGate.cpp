@@ -2,63 +2,220 @@
 #include "util/textDrawUtil.hpp"
 #include <QtCore/QDebug>
 #include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__aarch64__) && defined(__ARM_NEON)		// vaddvq/vaddlvq: AArch64 전용
+#include <arm_neon.h>
+#define QUALITY_NEON 1
+#endif
 
 
 #define DEBUG
 #define DEMO
 
 
-DetectedStatus LivenessGate::passQualityForRecog(const cv::Rect& box, cv::Mat& bgr)
+namespace {
+
+// 행 단위 정수 누산 (행 끝에서 64비트로 옮김)
+struct Acc {
+	uint64_t sum = 0, sq = 0, c0 = 0, c255 = 0;
+	void add(const Acc& o) { sum += o.sum; sq += o.sq; c0 += o.c0; c255 += o.c255; }
+};
+
+// ROI 한 행 -> 연속 휘도 행
+void loadRow(const cv::Mat& img, int y, int x0, int w, uint8_t* dst)
+{
+	const uint8_t* p = img.ptr<uint8_t>(y);
+	int i = 0;
+	switch (img.type()) {
+	case CV_8UC1:
+		std::memcpy(dst, p + x0, static_cast<size_t>(w));
+		return;
+	case CV_8UC2:							// YUYV: 짝수 바이트가 Y
+		p += x0 * 2;
+#if defined(QUALITY_NEON)
+		for (; i + 16 <= w; i += 16) vst1q_u8(dst + i, vld2q_u8(p + i * 2).val[0]);
+#endif
+		for (; i < w; ++i) dst[i] = p[i * 2];
+		return;
+	default:								// BGR: Y = (29B + 150G + 77R + 128) >> 8
+		p += x0 * 3;
+#if defined(QUALITY_NEON)
+		for (; i + 8 <= w; i += 8) {
+			const uint8x8x3_t v = vld3_u8(p + i * 3);
+			uint16x8_t y16 = vmull_u8(v.val[0], vdup_n_u8(29));
+			y16 = vmlal_u8(y16, v.val[1], vdup_n_u8(150));
+			y16 = vmlal_u8(y16, v.val[2], vdup_n_u8(77));
+			vst1_u8(dst + i, vrshrn_n_u16(y16, 8));
+		}
+#endif
+		for (; i < w; ++i) {
+			const uint8_t* q = p + i * 3;
+			dst[i] = static_cast<uint8_t>((29 * q[0] + 150 * q[1] + 77 * q[2] + 128) >> 8);
+		}
+		return;
+	}
+}
+
+// 합 / 제곱합 / 0·255 개수
+void rowStats(const uint8_t* r, int w, Acc& a)
+{
+	int i = 0;
+	uint32_t sum = 0, sq = 0, c0 = 0, c255 = 0;
+#if defined(QUALITY_NEON)
+	uint32x4_t vs = vdupq_n_u32(0), vq = vs, v0 = vs, v255 = vs;
+	for (; i + 16 <= w; i += 16) {
+		const uint8x16_t v = vld1q_u8(r + i);
+		vs = vpadalq_u16(vs, vpaddlq_u8(v));
+		vq = vpadalq_u16(vq, vmull_u8(vget_low_u8(v), vget_low_u8(v)));
+		vq = vpadalq_u16(vq, vmull_u8(vget_high_u8(v), vget_high_u8(v)));
+		v0	 = vpadalq_u16(v0,	 vpaddlq_u8(vshrq_n_u8(vceqq_u8(v, vdupq_n_u8(0)), 7)));
+		v255 = vpadalq_u16(v255, vpaddlq_u8(vshrq_n_u8(vceqq_u8(v, vdupq_n_u8(255)), 7)));
+	}
+	sum = vaddvq_u32(vs); sq = vaddvq_u32(vq); c0 = vaddvq_u32(v0); c255 = vaddvq_u32(v255);
+#endif
+	for (; i < w; ++i) {
+		const uint32_t v = r[i];
+		sum += v;
+		sq	+= v * v;
+		c0	 += (v == 0);
+		c255 += (v == 255);
+	}
+	a.sum += sum; a.sq += sq; a.c0 += c0; a.c255 += c255;
+}
+
+// b 행의 4-이웃 Laplacian (a: 위, c: 아래), 내부 열만. 합/제곱합 누적
+void lapRow(const uint8_t* a, const uint8_t* b, const uint8_t* c, int w, int64_t& sum, uint64_t& sq)
 {
-    if (bgr.empty() || bgr.cols < 64 || bgr.rows < 64) return DetectedStatus::FaceNotDetected;
+	int x = 1;
+	int32_t s = 0;
+	uint64_t q = 0;
+#if defined(QUALITY_NEON)
+	int32x4_t vs = vdupq_n_s32(0);
+	uint32x4_t vq = vdupq_n_u32(0);			// 차선당 최대 1020^2 * 2 * (w/8) -> 행 폭 2000 까지 안전
+	for (; x + 8 <= w - 1; x += 8) {
+		const int16x8_t up = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(a + x)));
+		const int16x8_t dn = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(c + x)));
+		const int16x8_t lf = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(b + x - 1)));
+		const int16x8_t rt = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(b + x + 1)));
+		const int16x8_t ce = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(b + x)));
+		const int16x8_t l  = vsubq_s16(vaddq_s16(vaddq_s16(up, dn), vaddq_s16(lf, rt)), vshlq_n_s16(ce, 2));
+		vs = vpadalq_s16(vs, l);
+		const int16x4_t lo = vget_low_s16(l), hi = vget_high_s16(l);
+		vq = vaddq_u32(vq, vreinterpretq_u32_s32(vmull_s16(lo, lo)));
+		vq = vaddq_u32(vq, vreinterpretq_u32_s32(vmull_s16(hi, hi)));
+	}
+	s = vaddvq_s32(vs);
+	q = vaddlvq_u32(vq);
+#endif
+	for (; x < w - 1; ++x) {
+		const int l = a[x] + c[x] + b[x - 1] + b[x + 1] - 4 * b[x];
+		s += l;
+		q += static_cast<uint64_t>(l * l);
+	}
+	sum += s;
+	sq	+= q;
+}
+
+double variance(uint64_t sum, uint64_t sq, uint64_t n)
+{
+	if (n == 0) return 0.0;
+	const double m = static_cast<double>(sum) / n;
+	return std::max(0.0, static_cast<double>(sq) / n - m * m);
+}
+
+} // namespace
+
+void LivenessGate::lumaRow(const cv::Mat& img, int y, int x0, int w, uint8_t* dst)
+{
+	loadRow(img, y, x0, w, dst);
+}
+
+// === 얼굴 ROI 통계 ===
+// 한 행씩 휘도로 읽어(링 버퍼 3행) 같은 패스에서 밝기/대비/클리핑 + 한 행 뒤의 Laplacian 누적
+//  중앙 대비는 ROI 가운데 절반(가로/세로 각 1/4 안쪽) 영역
+bool LivenessGate::faceStats(const cv::Mat& img, const cv::Rect& roiIn, FaceStats& out)
+{
+	out = FaceStats();
+	if (img.empty() || img.depth() != CV_8U || img.channels() > 3) return false;
+	const cv::Rect roi = roiIn & cv::Rect(0, 0, img.cols, img.rows);
+	if (roi.width < 3 || roi.height < 3) return false;
+
+	const int w = roi.width, h = roi.height;
+	const int cx0 = w / 4, cw = std::max(1, w / 2);
+	const int cy0 = h / 4, cy1 = cy0 + std::max(1, h / 2);
+
+	rows_.resize(static_cast<size_t>(w) * 3);
+	uint8_t* ring[3] = { rows_.data(), rows_.data() + w, rows_.data() + 2 * w };
+
+	Acc all, center;
+	int64_t	 lapSum = 0;
+	uint64_t lapSq	= 0;
+	for (int y = 0; y < h; ++y) {
+		uint8_t* r = ring[y % 3];
+		loadRow(img, roi.y + y, roi.x, w, r);
+		rowStats(r, w, all);
+		if (y >= cy0 && y < cy1) rowStats(r + cx0, cw, center);
+		if (y >= 2) lapRow(ring[(y - 2) % 3], ring[(y - 1) % 3], r, w, lapSum, lapSq);
+	}
+
+	const uint64_t n	= static_cast<uint64_t>(w) * h;
+	const uint64_t nc	= static_cast<uint64_t>(cw) * (cy1 - cy0);
+	const uint64_t nl	= static_cast<uint64_t>(w - 2) * (h - 2);
+	const double   lm	= static_cast<double>(lapSum) / nl;
+
+	out.pixels	  = static_cast<int>(n);
+	out.mean	  = static_cast<double>(all.sum) / n;
+	out.std		  = std::sqrt(variance(all.sum, all.sq, n));
+	out.centerStd = std::sqrt(variance(center.sum, center.sq, nc));
+	out.blurVar	  = std::max(0.0, static_cast<double>(lapSq) / nl - lm * lm);
+	out.clip0	  = static_cast<double>(all.c0) / n;
+	out.clip255	  = static_cast<double>(all.c255) / n;
+	return true;
+}
+
+DetectedStatus LivenessGate::passQualityForRecog(const cv::Rect& box, const cv::Size& frameSize,
+												 const cv::Mat& img, cv::Point org, FaceStats* stats)
+{
+    if (img.empty() || frameSize.width < 64 || frameSize.height < 64) return DetectedStatus::FaceNotDetected;
     // === 0) 중앙 위치 체크 ===
     {
-        const int frameCx = bgr.cols / 2;
-        const int frameCy = bgr.rows / 2;
+        const int frameCx = frameSize.width  / 2;
+        const int frameCy = frameSize.height / 2;
         const int faceCx  = box.x + box.width  / 2;
         const int faceCy  = box.y + box.height / 2;
-        double dx = std::abs(frameCx - faceCx) / static_cast<double>(bgr.cols / 2);
-        double dy = std::abs(frameCy - faceCy) / static_cast<double>(bgr.rows / 2);
-        const double kMaxCenterOffset = 0.30; // 30% 이상 벗어나면 경고
-
+        double dx = std::abs(frameCx - faceCx) / static_cast<double>(frameSize.width  / 2);
+        double dy = std::abs(frameCy - faceCy) / static_cast<double>(frameSize.height / 2);
+        // 30% 이상 벗어나면 경고 (kMaxCenterOffset)
         if (dx > kMaxCenterOffset || dy > kMaxCenterOffset) {
            return DetectedStatus::CenterOff; // 발표용으로는 계속 통과
         }
     }
 
     // === 1) 얼굴 박스 크기 체크 ===
-    const int kMinBoxW = 96, kMinBoxH = 96;
+    const int kMinBoxW = kMinFaceBox, kMinBoxH = kMinFaceBox;
     if (box.width < kMinBoxW || box.height < kMinBoxH) {
         return DetectedStatus::TooSmall;
     }
 
-    // === 2) 흐림 체크 (블러) ===
-    cv::Mat gray;
-    if (bgr.channels() == 3) cv::cvtColor(bgr, gray, cv::COLOR_BGR2GRAY);
-    cv::Mat lap;
-    cv::Laplacian(gray, lap, CV_64F);
-    cv::Scalar mu, sigma;
-    cv::meanStdDev(lap, mu, sigma);
-    const double lapVar = sigma[0] * sigma[0];
-    if (lapVar < 25.0) {
+    // === 2) 얼굴 박스 통계 (한 패스) ===
+    FaceStats st;
+    if (!faceStats(img, box - org, st)) return DetectedStatus::FaceNotDetected;
+    if (stats) *stats = st;
+
+    // 흐림 (블러)
+    if (st.blurVar < 25.0) {
         return DetectedStatus::TooBlurry;
     }
 
-    // === 3) 노출(밝기) 체크 ===
-    cv::Scalar mean, stddev;
-    cv::meanStdDev(gray, mean, stddev);
-    if (mean[0] < 40.0) {
+    // === 3) 노출(밝기) 체크 === (얼굴 절반 가까이 0 이면 어두움)
+    if (st.mean < 40.0 || st.clip0 > 0.30) {
         return DetectedStatus::TooDark;
     }
 
-    // === 4) 중앙부 대비 체크 ===
-    int cx = std::max(0, std::min(gray.cols/2 - 32, gray.cols - 64));
-    int cy = std::max(0, std::min(gray.rows/2 - 32, gray.rows - 64));
-    cv::Rect cR(cx, cy, 64, 64);
-    cv::Mat center = gray(cR);
-    cv::Scalar cm, cs;
-    cv::meanStdDev(center, cm, cs);
-    if (cs[0] < 10.0) {
+    // === 4) 얼굴 중앙부 대비 체크 === (포화로 질감이 날아간 경우 포함)
+    if (st.centerStd < 10.0 || st.clip255 > 0.30) {
          return DetectedStatus::LowContrast;
     }
 
@@ -93,28 +250,23 @@ QualResult LivenessGate::checkQuality(const cv::Rect& box, const cv::Mat& rgb)
 		return qr;
 	}
 
-	 // 1) ROI 자르기 (항상 원본 프레임에서)
+	 // 1) ROI (항상 원본 프레임에서) -> 통계 한 패스
 	const cv::Rect full(0, 0, rgb.cols, rgb.rows);
 	const cv::Rect roi = box & full;
-	if (roi.width <= 0 || roi.height <= 0) {
+	FaceStats st;
+	if (!faceStats(rgb, roi, st)) {
 		qr.reason = QualResult::Reason::InvalidInput;
 		return qr;
 	}
-	cv::Mat face = rgb(roi);
 	qr.usedRoi = roi;
-
-	  // === 그레이스케일 변환 ===
-	cv::Mat gray;
-	if (face.channels() == 3) cv::cvtColor(face, gray, cv::COLOR_RGB2GRAY);
-	else if (face.channels() == 4) cv::cvtColor(face, gray, cv::COLOR_RGBA2GRAY);
-	else gray = face;
+	qr.mean	   = st.mean;
+	qr.std	   = st.std;
+	qr.blurVar = st.blurVar;
+	qr.clip0   = st.clip0;
+	qr.clip255 = st.clip255;
 
 	 // === 블러(샤프니스) 체크: Laplacian variance ===
-	cv::Mat lap; 
-	cv::Laplacian(gray, lap, CV_64F);
-	cv::Scalar mu, sigma;
-	cv::meanStdDev(lap, mu, sigma);
-	const double lapVar = sigma[0] * sigma[0];
+	const double lapVar = st.blurVar;
 	if (lapVar < kBlurThr) {
 		qDebug() << "[Qual:FAIL] too blur var=" << lapVar << "thr=" << kBlurThr;
 		qr.reason = QualResult::Reason::TooBlur;
@@ -122,10 +274,8 @@ QualResult LivenessGate::checkQuality(const cv::Rect& box, const cv::Mat& rgb)
 	}
 
    // === 전체 노출/대비 체크 ===
-	cv::Scalar mean, stddev;
-	cv::meanStdDev(gray, mean, stddev);
-	const double m = mean[0];
-	const double s = stddev[0];
+	const double m = st.mean;
+	const double s = st.std;
 
 	bool exposureBad = (m < kMinMean || m > kMaxMean);
 	if (exposureBad) {
@@ -139,50 +289,21 @@ QualResult LivenessGate::checkQuality(const cv::Rect& box, const cv::Mat& rgb)
 		return qr;
 	}
 
-	 // === 히스토그램 클리핑 비율 체크 (0/255 바깥쪽 과다 몰림) ===
-	{
-		int histSize = 256;
-		float range[] = {0, 256};
-		const float* ranges = { range };
-
-		// OpenCV C++ API는 배열 포인터 시그니처를 요구하므로 래핑 배열 준비
-		int histSizes[]					 = { histSize };
-		const float* rangesArr[]		 = { ranges };
-		int channels[]					 = { 0 };
-
-		cv::Mat hist;
-		cv::calcHist(&gray, 1, channels, cv::Mat(), hist, 1, histSizes, rangesArr, true, false);
-		const double total			= static_cast<double>(gray.total());
-		const double clip0		  = hist.at<float>(0)	/ total;
-		const double clip255    = hist.at<float>(255)	/ total;
-		qr.clip0	= clip0;
-		qr.clip255  = clip255;
-
-		if (clip0 > kClipRatioMax || clip255 > kClipRatioMax) {
-			qDebug() << "[Qual:FAIL] clipping"
-							 << "clip0=" << clip0 << "clip255=" << clip255
-							 << "limit=" << kClipRatioMax;
-			qr.reason = QualResult::Reason::HistClipping;
-			return qr;
-		}
+	 // === 클리핑 비율 체크 (0/255 바깥쪽 과다 몰림) ===
+	if (st.clip0 > kClipRatioMax || st.clip255 > kClipRatioMax) {
+		qDebug() << "[Qual:FAIL] clipping"
+						 << "clip0=" << st.clip0 << "clip255=" << st.clip255
+						 << "limit=" << kClipRatioMax;
+		qr.reason = QualResult::Reason::HistClipping;
+		return qr;
 	}
 
-	// === 중앙 64x64 영역 대비 체크 ===
-	{
-		int cx = std::max(0, std::min(face.cols/2 - 32, face.cols - 64));
-		int cy = std::max(0, std::min(face.rows/2 - 32, face.rows - 64));
-		cv::Rect cR(cx, cy, 64, 64);
-
-		cv::Mat center = gray(cR);
-		cv::Scalar cm, cs;
-		cv::meanStdDev(center, cm, cs);
-
-		if (cs[0] < (kMinStd - 2)) {
-			qDebug() << "[Qual:FAIL] low center contrast std=" << cs[0]
-							 << "need >= " << (kMinStd - 2);
-			qr.reason = QualResult::Reason::LowCenterContrast;
-			return qr;
-		}
+	// === 얼굴 중앙 영역 대비 체크 ===
+	if (st.centerStd < (kMinStd - 2)) {
+		qDebug() << "[Qual:FAIL] low center contrast std=" << st.centerStd
+						 << "need >= " << (kMinStd - 2);
+		qr.reason = QualResult::Reason::LowCenterContrast;
+		return qr;
 	}
 
 	{
@@ -1,4 +1,6 @@
 #pragma once
+#include <cstdint>
+#include <vector>
 #include <opencv2/opencv.hpp>
 #include "include/states.hpp"
 
@@ -26,9 +28,39 @@ struct QualResult {
 	cv::Rect usedRoi;
 };
 
+// 얼굴 ROI 휘도 통계 (정수 누적 한 패스)
+struct FaceStats {
+	double mean		 = 0.0;			// 휘도 평균
+	double std		 = 0.0;			// 휘도 표준편차 (대비)
+	double centerStd = 0.0;			// 얼굴 중앙 절반 영역 표준편차
+	double blurVar	 = 0.0;			// 4-이웃 Laplacian 분산 (ROI 내부 픽셀)
+	double clip0	 = 0.0;			// 0 비율
+	double clip255	 = 0.0;			// 255 비율
+	int	   pixels	 = 0;
+};
+
 class LivenessGate {
 	public:
-		DetectedStatus passQualityForRecog(const cv::Rect& box, cv::Mat& face);
+		// 인식 품질 게이트 기준 (검출 정책도 같은 값을 사용)
+		static constexpr double kMaxCenterOffset = 0.30;	// 프레임 반폭/반높이 대비 중심 오프셋
+		static constexpr int	kMinFaceBox		 = 96;		// 최소 얼굴 박스 (px)
+
+		// box: 프레임 좌표 얼굴 박스, frameSize: 프레임 크기 (중앙 위치 체크)
+		// img: 얼굴을 담은 영상, org: img 좌상단의 프레임 좌표 (ROI 만 디코드한 경우)
+		//  Y 평면(CV_8UC1) / YUYV 원본(CV_8UC2, Y 만 읽음) / BGR(CV_8UC3, 정수 BT.601 휘도)
+		//  얼굴 박스 안만 읽음 -> 배경/프레임 크기와 무관
+		// stats: 통계까지 계산했으면 채움 (위치/크기에서 먼저 걸리면 그대로)
+		DetectedStatus passQualityForRecog(const cv::Rect& box, const cv::Size& frameSize,
+										   const cv::Mat& img, cv::Point org = cv::Point(0, 0),
+										   FaceStats* stats = nullptr);
 		QualResult checkQuality(const cv::Rect& box, const cv::Mat& rgb);
-		
+
+		// img 의 roi 에서 밝기/대비/클리핑/블러를 한 번에. roi 가 3x3 미만이면 false
+		bool faceStats(const cv::Mat& img, const cv::Rect& roi, FaceStats& out);
+
+		// img 의 y 행 [x0, x0+w) -> 휘도 (포맷은 passQualityForRecog 와 동일, 범위 검사 없음)
+		static void lumaRow(const cv::Mat& img, int y, int x0, int w, uint8_t* dst);
+
+	private:
+		std::vector<uint8_t> rows_;			// 휘도 3행 링 버퍼 (Laplacian 용)
 };
@@ -0,0 +1,208 @@
+#include "liveness/TemporalLiveness.hpp"
+#include "liveness/LivenessGate.hpp"
+#include "detect/LandmarkAligner.hpp"
+#include <QtCore/QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 8비트 LBP 코드 -> 균일 패턴(원형 0/1 전환 2회 이하) 여부
+const std::array<uint8_t, 256> kUniform = [] {
+	std::array<uint8_t, 256> t{};
+	for (int c = 0; c < 256; ++c) {
+		const int rot = ((c << 1) | (c >> 7)) & 0xff;
+		int n = 0;
+		for (int x = c ^ rot; x; x &= x - 1) ++n;
+		t[c] = n <= 2 ? 1 : 0;
+	}
+	return t;
+}();
+
+const char* verdictName(LiveVerdict v)
+{
+	switch (v) {
+	case LiveVerdict::Live:  return "live";
+	case LiveVerdict::Spoof: return "spoof";
+	default:				 return "pending";
+	}
+}
+
+} // namespace
+
+void TemporalLiveness::setOptions(const Options& opt)
+{
+	opt_ = opt;
+	opt_.window	   = std::clamp(opt_.window, 2, kMaxWindow);
+	opt_.minFrames = std::clamp(opt_.minFrames, 2, opt_.window);
+	opt_.patch	   = std::max(8, opt_.patch);
+	opt_.fallbackFrames = std::max(0, opt_.fallbackFrames);
+	reset();
+}
+
+void TemporalLiveness::reset()
+{
+	head_  = 0;
+	count_ = 0;
+	sumAx_ = sumAx2_ = sumAy_ = sumAy2_ = 0;
+	sumMotion_ = sumNonUni_ = 0;
+	trackId_ = -1;
+	lastTs_	 = 0;
+	pending_ = 0;
+	res_	 = Result();
+}
+
+// 링에 한 샘플: 가득 차 있으면 가장 오래된 샘플의 기여를 빼고 덮어씀
+void TemporalLiveness::push(const Sample& s)
+{
+	if (count_ == opt_.window) {
+		const Sample& old = ring_[head_];
+		sumAx_	   -= old.ax;  sumAx2_ -= double(old.ax) * old.ax;
+		sumAy_	   -= old.ay;  sumAy2_ -= double(old.ay) * old.ay;
+		sumMotion_ -= old.motion;
+		sumNonUni_ -= old.nonUniform;
+	}
+	else {
+		++count_;
+	}
+	ring_[head_] = s;
+	head_ = (head_ + 1) % opt_.window;
+
+	sumAx_	   += s.ax;  sumAx2_ += double(s.ax) * s.ax;
+	sumAy_	   += s.ay;  sumAy2_ += double(s.ay) * s.ay;
+	sumMotion_ += s.motion;
+	sumNonUni_ += s.nonUniform;
+}
+
+// 얼굴 중앙 패치(원본 해상도, 한 변 최대 opt_.patch)의 LBP 비균일 비율
+//  축소하면 모아레/픽셀 격자가 사라지므로 리샘플 없이 원본 픽셀 그대로. 패치가 작으면 -1
+float TemporalLiveness::textureNonUniform(const cv::Mat& img, const cv::Rect& box)
+{
+	const int side = std::min({ opt_.patch, box.width / 2, box.height / 2 });
+	const cv::Rect want(box.x + (box.width - side) / 2, box.y + (box.height - side) / 2, side, side);
+	const cv::Rect r = want & cv::Rect(0, 0, img.cols, img.rows);
+	if (r.width < 8 || r.height < 8) return -1.0f;
+
+	const int w = r.width;
+	rows_.resize(static_cast<size_t>(w) * 3);
+
+	int total = 0, nonUni = 0;
+	for (int y = 0; y < r.height; ++y) {
+		LivenessGate::lumaRow(img, r.y + y, r.x, w, rows_.data() + (y % 3) * w);
+		if (y < 2) continue;
+
+		const uint8_t* a = rows_.data() + ((y - 2) % 3) * w;		// 위
+		const uint8_t* b = rows_.data() + ((y - 1) % 3) * w;		// 중심 행
+		const uint8_t* c = rows_.data() + (y % 3) * w;			// 아래
+		for (int x = 1; x + 1 < w; ++x) {
+			const uint8_t v = b[x];
+			const int code = (a[x - 1] >= v)		| (a[x] >= v) << 1	  | (a[x + 1] >= v) << 2
+						   | (b[x + 1] >= v) << 3 | (c[x + 1] >= v) << 4 | (c[x] >= v) << 5
+						   | (c[x - 1] >= v) << 6 | (b[x - 1] >= v) << 7;
+			nonUni += 1 - kUniform[code];
+		}
+		total += w - 2;
+	}
+	return total > 0 ? static_cast<float>(nonUni) / total : -1.0f;
+}
+
+// 현재 창 통계(res_)와 직전 판정으로 이번 판정
+//  Live 는 래치하지 않음: 창이 움직임/텍스처 조건을 잃으면 바로 내려감 (리플레이를 이어 붙여도 창마다 검사)
+LiveVerdict TemporalLiveness::decide()
+{
+	if (count_ < opt_.minFrames) return LiveVerdict::Pending;
+	if (res_.nonUniform > opt_.maxNonUniform) {
+		pending_ = 0;
+		res_.fallback = false;
+		return LiveVerdict::Spoof;
+	}
+
+	const bool moving = res_.motion >= opt_.minMotion;
+	// 텍스처로 들어온 Live 는 그 엄격한 기준도 계속 지켜야 유지
+	const bool wasLive = res_.verdict == LiveVerdict::Live
+					  && (!res_.fallback || res_.nonUniform <= opt_.fallbackNonUniform);
+
+	// 진입은 시차까지, 유지는 미세 움직임만 (텍스처는 위에서 통과)
+	if (moving && (res_.parallax >= opt_.minParallax || wasLive)) {
+		pending_ = 0;
+		if (!wasLive) res_.fallback = false;
+		return LiveVerdict::Live;
+	}
+
+	// 고개를 돌리지 않는 사용자: 일정 프레임 뒤 더 엄격한 텍스처 기준으로 결정 (다음 결정은 다시 그만큼 뒤)
+	if (opt_.fallbackFrames > 0 && ++pending_ >= opt_.fallbackFrames) {
+		pending_ = 0;
+		res_.fallback = true;
+		return (moving && res_.nonUniform <= opt_.fallbackNonUniform) ? LiveVerdict::Live : LiveVerdict::Spoof;
+	}
+
+	// 직전 Spoof 는 다음 결정 시점까지 유지 (프레임마다 Spoof/Pending 이 번갈지 않게)
+	return res_.verdict == LiveVerdict::Spoof ? LiveVerdict::Spoof : LiveVerdict::Pending;
+}
+
+const TemporalLiveness::Result& TemporalLiveness::update(const FaceDet& fd, int64_t tsMs,
+														 const cv::Mat& img, cv::Point org)
+{
+	// 다른 얼굴이거나 샘플이 끊겼으면 처음부터
+	if (fd.trackId != trackId_ || (count_ > 0 && tsMs - lastTs_ > opt_.maxGapMs)) {
+		reset();
+		trackId_ = fd.trackId;
+	}
+	lastTs_ = tsMs;
+
+	Sample s;
+	s.lmk = fd.lmk;
+	const cv::Point2f& le = s.lmk[0];
+	const cv::Point2f& re = s.lmk[1];
+	const cv::Point2f  mm = (s.lmk[3] + s.lmk[4]) * 0.5f;
+	const float iod = std::hypot(re.x - le.x, re.y - le.y);
+
+	// 코 = LE + ax*(RE-LE) + ay*(MM-LE). 세 점이 한 줄에 가까우면 이 프레임은 건너뜀
+	const cv::Point2f e1 = re - le, e2 = mm - le, v = s.lmk[2] - le;
+	const float det = e1.x * e2.y - e1.y * e2.x;
+	if (iod < 8.0f || std::abs(det) < 0.05f * iod * iod) return res_;
+	s.ax = (v.x * e2.y - v.y * e2.x) / det;
+	s.ay = (e1.x * v.y - e1.y * v.x) / det;
+
+	// 직전 샘플 -> 현재 닮음 변환 잔차 (평행 이동/회전/크기 변화는 제외)
+	if (count_ > 0) {
+		const Sample& prev = ring_[(head_ + opt_.window - 1) % opt_.window];
+		const cv::Mat M = LandmarkAligner::similarity5(prev.lmk, s.lmk);
+		if (!M.empty()) {
+			const double* m = M.ptr<double>();
+			double err = 0.0;
+			for (int i = 0; i < 5; ++i) {
+				const cv::Point2f& p = prev.lmk[i];
+				const double dx = m[0] * p.x + m[1] * p.y + m[2] - s.lmk[i].x;
+				const double dy = m[3] * p.x + m[4] * p.y + m[5] - s.lmk[i].y;
+				err += dx * dx + dy * dy;
+			}
+			s.motion = static_cast<float>(std::sqrt(err / 5.0) / iod);
+		}
+	}
+
+	const float nu = textureNonUniform(img, fd.box - org);
+	s.nonUniform = nu >= 0.0f ? nu : (count_ > 0 ? static_cast<float>(sumNonUni_ / count_) : 0.0f);
+
+	push(s);
+
+	// 창 통계 -> 판정
+	const double n = count_;
+	const double varAx = std::max(0.0, sumAx2_ / n - (sumAx_ / n) * (sumAx_ / n));
+	const double varAy = std::max(0.0, sumAy2_ / n - (sumAy_ / n) * (sumAy_ / n));
+	res_.frames		= count_;
+	res_.parallax	= static_cast<float>(std::sqrt(varAx + varAy));
+	res_.motion		= static_cast<float>(sumMotion_ / n);
+	res_.nonUniform = static_cast<float>(sumNonUni_ / n);
+
+	const LiveVerdict prevVerdict = res_.verdict;
+	res_.verdict = decide();
+
+	if (res_.verdict != prevVerdict) {
+		qDebug() << "[TemporalLiveness] track=" << trackId_ << verdictName(res_.verdict)
+				 << (res_.fallback ? "(texture fallback)" : "")
+				 << "frames=" << res_.frames << "parallax=" << res_.parallax
+				 << "motion=" << res_.motion << "lbpNonUniform=" << res_.nonUniform;
+	}
+	return res_;
+}
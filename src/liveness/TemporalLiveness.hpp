@@ -0,0 +1,95 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "include/types.hpp"		// FaceDet
+
+enum class LiveVerdict {
+	Pending,		// 아직 근거 부족 (인식은 하되 출입 허용 안 함)
+	Live,			// 실제 얼굴
+	Spoof			// 화면/인쇄물 의심
+};
+
+// 시간축 라이브니스 (위조 방지)
+//  - 추적 중인 얼굴의 프레임별 샘플(랜드마크 + 얼굴 중앙 텍스처)을 고정 크기 링에 쌓고
+//    창 통계는 링에 들어오고 빠지는 샘플만큼 합을 더하고 빼서 갱신 (창 재계산 없음)
+//  - 신호
+//    . 시차(parallax): 코를 두 눈 + 입 중앙 기준 아핀 좌표로 표현 -> 평면(사진/화면)은 어떤 아핀
+//      변형에도 값이 그대로, 입체 얼굴은 고개가 조금만 돌아도 변함. 창 안의 표준편차
+//    . 미세 움직임: 직전 프레임 대비 닮음 변환으로 설명 안 되는 랜드마크 이동 (IOD 정규화)
+//    . 텍스처: 얼굴 중앙 원본 해상도 패치의 LBP 비균일 패턴 비율 (화면 모아레/픽셀 격자에서 높음)
+//  - 판정은 매 프레임 현재 창으로 다시 (한 번 Live 였어도 창이 조건을 잃으면 Pending/Spoof)
+//    . 진입: 시차 + 미세 움직임 + 텍스처. 유지: 미세 움직임 + 텍스처 (고개를 멈춰도 유지)
+//    . 텍스처가 위조로 기울면 Spoof
+//    . 가만히 선 사용자: Pending 이 fallbackFrames 이어지면 더 엄격한 텍스처 기준으로 결정
+//  - 트랙이 바뀌거나 끊기면 처음부터
+//  - 프레임당 비용: 랜드마크 O(1) + 최대 64x64 패치 한 번 (검출 대비 무시할 수준)
+// detect 스테이지 스레드 전용 (동기화 없음)
+class TemporalLiveness {
+	public:
+		static constexpr int kMaxWindow = 32;
+
+		struct Options {
+			int		window		  = 16;		// 링 크기 (프레임, kMaxWindow 이하)
+			int		minFrames	  = 8;		// 판정에 필요한 최소 샘플 수
+			float	minParallax	  = 0.04f;	// 코 아핀 좌표 표준편차 하한 (검출 지터 ~0.02 위, Live 조건)
+			float	minMotion	  = 0.004f;	// 평균 비강체 움직임 하한 (IOD 비율). 지터조차 없는 정지 입력 배제
+			float	maxNonUniform = 0.30f;	// LBP 비균일 비율 평균 상한 (넘으면 Spoof)
+			int		fallbackFrames = 45;	// 판정 가능 후 Pending 이 이만큼 이어지면 텍스처로 결정 (0 = 안 함)
+			float	fallbackNonUniform = 0.22f;	// 그때의 텍스처 상한 (이하 Live, 초과 Spoof)
+			int		maxGapMs	  = 300;	// 샘플 간격이 이보다 벌어지면 초기화
+			int		patch		  = 64;		// 텍스처 패치 한 변 상한 (px)
+		};
+
+		struct Result {
+			LiveVerdict verdict	   = LiveVerdict::Pending;
+			bool		fallback   = false;	// 시차 없이 텍스처 기준으로 내린 판정
+			int			frames	   = 0;		// 링에 쌓인 샘플 수
+			float		parallax   = 0.0f;
+			float		motion	   = 0.0f;
+			float		nonUniform = 0.0f;
+		};
+
+		TemporalLiveness() = default;
+		explicit TemporalLiveness(const Options& opt) { setOptions(opt); }
+
+		void setOptions(const Options& opt);
+		void reset();
+
+		// fd: 원본 좌표 검출 결과 (trackId 사용), tsMs: 캡처 시각 (단조 ms)
+		// img/org: 얼굴을 담은 영상과 그 좌상단의 원본 좌표 (LivenessGate::passQualityForRecog 와 같은 규약)
+		const Result& update(const FaceDet& fd, int64_t tsMs, const cv::Mat& img, cv::Point org = cv::Point(0, 0));
+
+		const Result& result() const { return res_; }
+
+	private:
+		LiveVerdict decide();
+
+		struct Sample {
+			std::array<cv::Point2f, 5> lmk;
+			float	ax = 0.0f, ay = 0.0f;	// 코의 아핀 좌표 (눈-눈, 눈-입 축)
+			float	motion	   = 0.0f;
+			float	nonUniform = 0.0f;
+		};
+
+		float textureNonUniform(const cv::Mat& img, const cv::Rect& box);
+		void  push(const Sample& s);
+
+		Options	opt_;
+		std::array<Sample, kMaxWindow> ring_{};
+		int		head_	= 0;			// 다음에 쓸 칸
+		int		count_	= 0;
+
+		// 창 누적합 (push 에서 들어온 샘플 더하고 밀려난 샘플 뺌)
+		double	sumAx_ = 0, sumAx2_ = 0, sumAy_ = 0, sumAy2_ = 0;
+		double	sumMotion_ = 0, sumNonUni_ = 0;
+
+		int		trackId_ = -1;
+		int64_t	lastTs_	 = 0;
+		int		pending_ = 0;			// 판정 가능해진 뒤 연속 Pending 프레임 수
+
+		std::vector<uint8_t> rows_;		// 패치 휘도 3행 링
+		Result	res_;
+};
@@ -0,0 +1,127 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// 스냅샷 간 공유용 copy-on-write 컨테이너
+//  - 원소를 고정 크기 청크(shared_ptr)로 나눠 보관 -> 복사는 청크 포인터 표만 (원소 복사 없음)
+//  - 쓰기(mut/set/erase)는 그 청크를 이 인스턴스만 들고 있으면 제자리, 공유 중이면 청크 하나만 복사 후 수정
+//  - 게시된(읽기 전용) 인스턴스는 수정하지 말 것: 복사본을 만들어 고친 뒤 새 스냅샷으로 게시
+//    (use_count()==1 이면 다른 스냅샷이 그 청크를 볼 수 없으므로 제자리 수정이 안전)
+
+// 인덱스 -> T (뒤에만 추가)
+template<typename T, int Shift = 8>
+class CowVector {
+	public:
+		static constexpr size_t kChunk = size_t(1) << Shift;
+
+		size_t size() const { return size_; }
+		bool empty() const { return size_ == 0; }
+
+		const T& operator[](size_t i) const { return (*chunks_[i >> Shift])[i & (kChunk - 1)]; }
+
+		T& mut(size_t i)
+		{
+			auto& c = chunks_[i >> Shift];
+			if (c.use_count() != 1) c = std::make_shared<std::vector<T>>(*c);
+			return (*c)[i & (kChunk - 1)];
+		}
+
+		void push_back(T v)
+		{
+			if ((size_ & (kChunk - 1)) == 0) {
+				chunks_.push_back(std::make_shared<std::vector<T>>());
+				chunks_.back()->reserve(kChunk);
+			}
+			auto& c = chunks_.back();
+			if (c.use_count() != 1) {
+				auto copy = std::make_shared<std::vector<T>>();
+				copy->reserve(kChunk);
+				copy->assign(c->begin(), c->end());
+				c = std::move(copy);
+			}
+			c->push_back(std::move(v));
+			++size_;
+		}
+
+		void clear() { chunks_.clear(); size_ = 0; }
+		void reserve(size_t n) { chunks_.reserve((n + kChunk - 1) >> Shift); }
+
+	private:
+		std::vector<std::shared_ptr<std::vector<T>>> chunks_;
+		size_t size_ = 0;
+};
+
+// int 키(사용자 ID) -> V. 고정 개수 버킷(버킷 안은 키 정렬) -> 복사는 버킷 포인터 표만
+template<typename V, int Bits = 10>
+class CowIdMap {
+	public:
+		static constexpr size_t kBuckets = size_t(1) << Bits;
+
+		size_t size() const { return size_; }
+		bool empty() const { return size_ == 0; }
+
+		const V* find(int key) const
+		{
+			const auto& b = buckets_[bucketOf(key)];
+			if (!b) return nullptr;
+			auto it = lower(*b, key);
+			return it != b->end() && it->first == key ? &it->second : nullptr;
+		}
+
+		void set(int key, V v)
+		{
+			Bucket& b = mutBucket(bucketOf(key));
+			auto it = lower(b, key);
+			if (it != b.end() && it->first == key) { it->second = std::move(v); return; }
+			b.insert(it, { key, std::move(v) });
+			++size_;
+		}
+
+		bool erase(int key)
+		{
+			const size_t i = bucketOf(key);
+			if (!buckets_[i] || !find(key)) return false;
+			Bucket& b = mutBucket(i);
+			b.erase(lower(b, key));
+			--size_;
+			return true;
+		}
+
+		void clear() { buckets_.assign(kBuckets, nullptr); size_ = 0; }
+
+		// 순서는 버킷 순 (키 순 아님)
+		template<typename F>
+		void forEach(F&& f) const
+		{
+			for (const auto& b : buckets_) {
+				if (!b) continue;
+				for (const auto& kv : *b) f(kv.first, kv.second);
+			}
+		}
+
+	private:
+		using Bucket = std::vector<std::pair<int, V>>;
+
+		static size_t bucketOf(int key) { return (uint32_t(key) * 2654435761u) >> (32 - Bits); }
+
+		template<typename B>
+		static auto lower(B& b, int key)
+		{
+			return std::lower_bound(b.begin(), b.end(), key, [] (const auto& kv, int k) { return kv.first < k; });
+		}
+
+		Bucket& mutBucket(size_t i)
+		{
+			auto& b = buckets_[i];
+			if (!b) b = std::make_shared<Bucket>();
+			else if (b.use_count() != 1) b = std::make_shared<Bucket>(*b);
+			return *b;
+		}
+
+		std::vector<std::shared_ptr<Bucket>> buckets_ = std::vector<std::shared_ptr<Bucket>>(kBuckets);
+		size_t size_ = 0;
+};
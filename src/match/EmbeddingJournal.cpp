@@ -0,0 +1,395 @@
+#include "match/EmbeddingJournal.hpp"
+#include "match/EmbeddingStore.hpp"		// crc32c
+
+#include <QtCore/QDebug>
+#include <QFileInfo>
+#include <QHash>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint32_t kMagic	   = 0x4c4e4a46;		// "FJNL"
+constexpr qint64   kFileHeader = EmbeddingJournal::kHeaderBytes;
+constexpr uint32_t kMaxRecord  = 16u << 20;			// 레코드 상한 (깨진 길이 방어)
+
+enum class Op : uint8_t { Upsert = 1, Delete = 2 };
+
+// payload: [op u8][pad u8 x3][id i32][dim u32][protos u32][nameBytes u32][name][embedding][prototypes...]
+struct RecordHead {
+	uint8_t	 op;
+	uint8_t	 pad[3];
+	int32_t	 id;
+	uint32_t dim;
+	uint32_t protos;
+	uint32_t nameBytes;
+};
+static_assert(sizeof(RecordHead) == 20, "EmbeddingJournal record layout");
+
+bool writeAll(int fd, const char* p, size_t n)
+{
+	while (n > 0) {
+		const ssize_t w = ::write(fd, p, n);
+		if (w < 0) {
+			if (errno == EINTR) continue;
+			return false;
+		}
+		p += w;
+		n -= static_cast<size_t>(w);
+	}
+	return true;
+}
+
+bool preadAll(int fd, char* p, size_t n, off_t off)
+{
+	while (n > 0) {
+		const ssize_t r = ::pread(fd, p, n, off);
+		if (r < 0) {
+			if (errno == EINTR) continue;
+			return false;
+		}
+		if (r == 0) return false;
+		p	+= r;
+		off += r;
+		n	-= static_cast<size_t>(r);
+	}
+	return true;
+}
+
+// rename 확정 (디렉터리 엔트리까지)
+void syncDir(const QString& path)
+{
+	const QByteArray dir = QFileInfo(path).absolutePath().toLocal8Bit();
+	const int fd = ::open(dir.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd < 0) return;
+	::fsync(fd);
+	::close(fd);
+}
+
+QByteArray fileHeader()
+{
+	QByteArray h(kFileHeader, '\0');
+	const uint32_t v[2] = { kMagic, EmbeddingJournal::kVersion };
+	std::memcpy(h.data(), v, sizeof(v));
+	return h;
+}
+
+} // namespace
+
+EmbeddingJournal::~EmbeddingJournal()
+{
+	waitCompaction();
+	closeFd();
+}
+
+void EmbeddingJournal::closeFd()
+{
+	if (fd_ >= 0) ::close(fd_);
+	fd_ = -1;
+}
+
+bool EmbeddingJournal::open()
+{
+	std::lock_guard<std::mutex> lk(writeMutex_);
+	closeFd();
+
+	const QByteArray p = path_.toLocal8Bit();
+	fd_ = ::open(p.constData(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	if (fd_ < 0) {
+		qWarning() << "[EmbeddingJournal] open failed:" << path_ << std::strerror(errno);
+		return false;
+	}
+
+	struct stat st{};
+	::fstat(fd_, &st);
+	if (st.st_size == 0) {
+		const QByteArray h = fileHeader();
+		if (!writeAll(fd_, h.constData(), size_t(h.size())) || ::fdatasync(fd_) != 0) {
+			qWarning() << "[EmbeddingJournal] header write failed:" << path_;
+			closeFd();
+			return false;
+		}
+		size_.store(kFileHeader, std::memory_order_relaxed);
+		return true;
+	}
+
+	uint32_t h[2] = { 0, 0 };
+	if (st.st_size < kFileHeader || !preadAll(fd_, reinterpret_cast<char*>(h), sizeof(h), 0)
+		|| h[0] != kMagic || h[1] != kVersion) {
+		// 알 수 없는 파일: 지우지 않고 옆으로 치운 뒤 새로 시작
+		qWarning() << "[EmbeddingJournal] header mismatch -> set aside" << path_;
+		closeFd();
+		::rename(p.constData(), (p + ".bad").constData());
+		fd_ = ::open(p.constData(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+		const QByteArray fh = fileHeader();
+		if (fd_ < 0 || !writeAll(fd_, fh.constData(), size_t(fh.size())) || ::fdatasync(fd_) != 0) {
+			closeFd();
+			return false;
+		}
+		size_.store(kFileHeader, std::memory_order_relaxed);
+		return true;
+	}
+	size_.store(st.st_size, std::memory_order_relaxed);
+	return true;
+}
+
+// 다른 프로세스가 덧붙인 바이트는 size_ 에 없음 -> fstat 으로 다시 맞춤
+//  경로가 다른 파일(inode)을 가리키면 (밖에서 압축/교체) 새 파일로 다시 연다
+bool EmbeddingJournal::refresh()
+{
+	{
+		std::lock_guard<std::mutex> lk(writeMutex_);
+		const QByteArray p = path_.toLocal8Bit();
+		struct stat fdSt{}, pathSt{};
+		if (fd_ >= 0 && ::fstat(fd_, &fdSt) == 0 && ::stat(p.constData(), &pathSt) == 0
+			&& fdSt.st_ino == pathSt.st_ino && fdSt.st_dev == pathSt.st_dev) {
+			size_.store(std::max<qint64>(fdSt.st_size, kFileHeader), std::memory_order_relaxed);
+			return true;
+		}
+	}
+	qInfo() << "[EmbeddingJournal] file replaced externally -> reopen" << path_;
+	return open();
+}
+
+int EmbeddingJournal::replay(std::vector<GalleryUserPtr>& users)
+{
+	if (!refresh()) return -1;
+	std::lock_guard<std::mutex> lk(writeMutex_);
+	if (fd_ < 0) return -1;
+
+	const qint64 size = size_.load(std::memory_order_relaxed);
+	QByteArray buf(static_cast<int>(std::max<qint64>(size - kFileHeader, 0)), '\0');
+	if (!buf.isEmpty() && !preadAll(fd_, buf.data(), size_t(buf.size()), kFileHeader)) {
+		qWarning() << "[EmbeddingJournal] read failed:" << path_;
+		return -1;
+	}
+
+	// id -> users 위치 (한 번만 만듦). 삭제는 자리만 비우고 끝에서 한 번에 정리
+	QHash<int, size_t> index;
+	index.reserve(int(users.size()));
+	for (size_t i = 0; i < users.size(); ++i) index.insert(users[i]->id, i);
+
+	int applied = 0, skipped = 0, removed = 0;
+	qint64 off = 0;
+	const char* base = buf.constData();
+	while (off + 8 <= buf.size()) {
+		uint32_t len = 0, crc = 0;
+		std::memcpy(&len, base + off, 4);
+		std::memcpy(&crc, base + off + 4, 4);
+		if (len < sizeof(RecordHead) || len > kMaxRecord || off + 8 + qint64(len) > buf.size()) break;
+		const char* p = base + off + 8;
+		if (EmbeddingStore::crc32c(p, len) != crc) break;
+		const qint64 at = kFileHeader + off;
+		off += 8 + qint64(len);
+
+		// 여기부터는 프레임/CRC 가 맞는 레코드: 내용이 틀려도 뒤 레코드는 살림 (건너뜀)
+		RecordHead h;
+		std::memcpy(&h, p, sizeof(h));
+		const Op op = static_cast<Op>(h.op);
+		const uint64_t need = sizeof(RecordHead) + uint64_t(h.nameBytes) + uint64_t(h.dim) * (1 + h.protos) * sizeof(float);
+		if ((op != Op::Upsert && op != Op::Delete) || need != len || (op == Op::Upsert && h.dim == 0)) {
+			qWarning() << "[EmbeddingJournal] bad record (op" << int(h.op) << "id" << h.id << ") at" << at << "-> skip";
+			++skipped;
+			continue;
+		}
+
+		const auto it = index.constFind(h.id);
+		if (op == Op::Delete) {
+			if (it != index.constEnd()) {
+				users[it.value()].reset();
+				index.erase(it);
+				++removed;
+			}
+		}
+		else {
+			// 행은 레코드 안에서 정렬 보장 없음 -> 한 번 꺼내서 블록으로
+			const QString name = QString::fromUtf8(p + sizeof(RecordHead), static_cast<int>(h.nameBytes));
+			std::vector<float> rows(size_t(h.dim) * (1 + h.protos));
+			std::memcpy(rows.data(), p + sizeof(RecordHead) + h.nameBytes, rows.size() * sizeof(float));
+			GalleryUserPtr u = GalleryUser::make(h.id, name, static_cast<int>(h.dim), rows.data(),
+												 rows.data() + h.dim, static_cast<int>(h.protos));
+			if (!u) {
+				qWarning() << "[EmbeddingJournal] unusable user block (id" << h.id << "dim" << h.dim << ") -> skip";
+				++skipped;
+				continue;
+			}
+			if (it != index.constEnd()) users[it.value()] = std::move(u);
+			else {
+				index.insert(h.id, users.size());
+				users.push_back(std::move(u));
+			}
+		}
+		++applied;
+	}
+	if (removed > 0) users.erase(std::remove(users.begin(), users.end(), nullptr), users.end());
+	if (skipped > 0) qWarning() << "[EmbeddingJournal] skipped" << skipped << "bad records in" << path_;
+
+	// 프레임이 끊겼거나 CRC 가 틀린 끝 (쓰는 도중 전원 차단 등) -> 잘라냄
+	if (off < buf.size()) {
+		qWarning() << "[EmbeddingJournal] torn tail at" << (kFileHeader + off) << "of" << size << "-> truncate";
+		if (::ftruncate(fd_, kFileHeader + off) == 0) {
+			::fdatasync(fd_);
+			size_.store(kFileHeader + off, std::memory_order_relaxed);
+		}
+	}
+	if (applied > 0) qInfo() << "[EmbeddingJournal] replayed" << applied << "records from" << path_;
+	return applied;
+}
+
+uint64_t EmbeddingJournal::appendUpsert(const GalleryUser& u)
+{
+	const QByteArray name = u.name.toUtf8();
+	const uint32_t dim	  = static_cast<uint32_t>(u.dim);
+	const uint32_t protos = static_cast<uint32_t>(u.protoCount());
+
+	RecordHead h{};
+	h.op		= static_cast<uint8_t>(Op::Upsert);
+	h.id		= u.id;
+	h.dim		= dim;
+	h.protos	= protos;
+	h.nameBytes = static_cast<uint32_t>(name.size());
+
+	// 행은 패딩 없이 dim 개씩 (코드 전용 블록은 복원값)
+	const int rowBytes = int(dim * sizeof(float));
+	std::vector<float> row(dim);
+	QByteArray payload;
+	payload.reserve(int(sizeof(h) + name.size() + dim * (1 + protos) * sizeof(float)));
+	payload.append(reinterpret_cast<const char*>(&h), sizeof(h));
+	payload.append(name);
+	for (int r = -1; r < int(protos); ++r) {
+		u.copyRow(r, row.data());
+		payload.append(reinterpret_cast<const char*>(row.data()), rowBytes);
+	}
+	return append(payload);
+}
+
+uint64_t EmbeddingJournal::appendDelete(int id)
+{
+	RecordHead h{};
+	h.op = static_cast<uint8_t>(Op::Delete);
+	h.id = id;
+	return append(QByteArray(reinterpret_cast<const char*>(&h), sizeof(h)));
+}
+
+// 쓰기만 (확정은 sync). 쓰기 순서 = 순번 순서
+uint64_t EmbeddingJournal::append(const QByteArray& payload)
+{
+	const uint32_t head[2] = { static_cast<uint32_t>(payload.size()),
+							   EmbeddingStore::crc32c(payload.constData(), size_t(payload.size())) };
+	QByteArray frame(reinterpret_cast<const char*>(head), sizeof(head));
+	frame.append(payload);
+
+	std::lock_guard<std::mutex> lk(writeMutex_);
+	if (fd_ < 0) return 0;
+	if (!writeAll(fd_, frame.constData(), size_t(frame.size()))) {
+		qWarning() << "[EmbeddingJournal] write failed:" << path_ << std::strerror(errno);
+		return 0;
+	}
+	size_.fetch_add(frame.size(), std::memory_order_relaxed);
+	return ++written_;
+}
+
+// group commit: 먼저 들어온 fdatasync 가 뒤 레코드까지 덮었으면 그대로 반환
+bool EmbeddingJournal::sync(uint64_t seq)
+{
+	if (seq == 0) return false;
+	std::lock_guard<std::mutex> lk(syncMutex_);
+	if (synced_ >= seq) return true;
+
+	uint64_t target = 0;
+	int fd = -1;
+	{
+		std::lock_guard<std::mutex> wl(writeMutex_);
+		target = written_;
+		fd	   = fd_;
+	}
+	if (fd < 0 || ::fdatasync(fd) != 0) {
+		qWarning() << "[EmbeddingJournal] fdatasync failed:" << path_ << std::strerror(errno);
+		return false;
+	}
+	synced_ = target;
+	return true;
+}
+
+bool EmbeddingJournal::reopen(qint64 keepFrom)
+{
+	// 남기는 쪽은 파일 끝까지 (아직 재적용 전인 다른 프로세스의 레코드도 버리지 않음)
+	qint64 size = size_.load(std::memory_order_relaxed);
+	struct stat st{};
+	if (fd_ >= 0 && ::fstat(fd_, &st) == 0) size = std::max<qint64>(size, st.st_size);
+	keepFrom = std::clamp(keepFrom, kFileHeader, size);
+
+	QByteArray out = fileHeader();
+	if (keepFrom < size) {
+		QByteArray tail(static_cast<int>(size - keepFrom), '\0');
+		if (fd_ < 0 || !preadAll(fd_, tail.data(), size_t(tail.size()), keepFrom)) return false;
+		out.append(tail);
+	}
+
+	const QByteArray p	 = path_.toLocal8Bit();
+	const QByteArray tmp = p + ".tmp";
+	const int tfd = ::open(tmp.constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (tfd < 0) return false;
+	const bool ok = writeAll(tfd, out.constData(), size_t(out.size())) && ::fdatasync(tfd) == 0;
+	::close(tfd);
+	if (!ok || ::rename(tmp.constData(), p.constData()) != 0) {
+		::unlink(tmp.constData());
+		return false;
+	}
+	syncDir(path_);
+
+	closeFd();
+	fd_ = ::open(p.constData(), O_RDWR | O_APPEND | O_CLOEXEC);
+	size_.store(out.size(), std::memory_order_relaxed);
+	synced_ = written_;			// 남긴 레코드는 새 파일과 함께 fdatasync 됨
+	return fd_ >= 0;
+}
+
+bool EmbeddingJournal::compactAsync(std::function<bool()> writeBase)
+{
+	if (compacting_.exchange(true, std::memory_order_acq_rel)) return false;
+	if (compactTh_.joinable()) compactTh_.join();		// 이전 압축(이미 끝남) 정리
+
+	// 호출 시점까지의 레코드가 writeBase 대상 (호출 측이 같은 시점의 스냅샷을 넘김)
+	qint64 mark = 0;
+	{
+		std::lock_guard<std::mutex> wl(writeMutex_);
+		mark = size_.load(std::memory_order_relaxed);
+	}
+	compactTh_ = std::thread([this, mark, writeBase = std::move(writeBase)] {
+		const bool ok = writeBase();
+		if (ok) {
+			std::lock_guard<std::mutex> sl(syncMutex_);
+			std::lock_guard<std::mutex> wl(writeMutex_);
+			const qint64 before = size_.load(std::memory_order_relaxed);
+			if (reopen(mark)) {
+				qInfo() << "[EmbeddingJournal] compacted" << before << "->" << size_.load(std::memory_order_relaxed) << "bytes";
+			}
+			else {
+				qWarning() << "[EmbeddingJournal] compaction rewrite failed:" << path_;
+			}
+		}
+		else {
+			qWarning() << "[EmbeddingJournal] base write failed -> journal kept";
+		}
+		compacting_.store(false, std::memory_order_release);
+	});
+	return true;
+}
+
+void EmbeddingJournal::waitCompaction()
+{
+	if (compactTh_.joinable()) compactTh_.join();
+}
+
+bool EmbeddingJournal::reset()
+{
+	waitCompaction();
+	std::lock_guard<std::mutex> sl(syncMutex_);
+	std::lock_guard<std::mutex> wl(writeMutex_);
+	return reopen(size_.load(std::memory_order_relaxed));
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <QByteArray>
+#include <QString>
+
+#include "match/GalleryUser.hpp"
+
+// 갤러리 변경 저널 (append-only, embeddings.journal)
+//  - 사용자 추가/갱신(Upsert)·삭제(Delete) 한 건 = 레코드 하나 [len][crc32c][payload]
+//  - append* 는 레코드를 쓰기만 하고 순번을 돌려줌, 확정(fdatasync)은 sync(seq) 로 따로
+//    호출 측은 자기 쓰기 락을 푼 뒤 sync 를 부름 -> 그사이 들어온 쓰기까지 한 번의 fdatasync 로 확정 (group commit)
+//  - 시작 시 기반 저장소(EmbeddingStore) 위에 순서대로 재적용. 끝의 깨진 레코드는 잘라냄
+//  - 압축: 표시 시점까지를 기반 저장소에 다시 쓰고(백그라운드) 그 이후 레코드만 남긴다
+// 레코드는 멱등(같은 id 는 통째로 교체/삭제)이라 압축 중 중단돼도 재적용 결과가 같다
+class EmbeddingJournal {
+	public:
+		static constexpr uint32_t kVersion = 1;
+		static constexpr qint64	  kHeaderBytes = 8;			// 레코드 없는 파일 크기 [magic][version]
+
+		explicit EmbeddingJournal(const QString& path) : path_(path) {}
+		~EmbeddingJournal();
+
+		EmbeddingJournal(const EmbeddingJournal&) = delete;
+		EmbeddingJournal& operator=(const EmbeddingJournal&) = delete;
+
+		bool open();									// 없으면 생성
+		// users 에 저널을 재적용 (추가/교체된 사용자는 자기 버퍼 블록). 적용한 레코드 수 (실패 시 -1)
+		//  먼저 파일과 다시 맞춤: 다른 프로세스가 덧붙인 레코드까지 읽고, 파일이 교체됐으면 새로 연다
+		//  프레임/CRC 가 깨진 끝만 잘라내고, 내용을 쓸 수 없는 레코드는 건너뜀 (뒤 레코드 유지)
+		int replay(std::vector<GalleryUserPtr>& users);
+
+		// 레코드 쓰기 (page cache 까지). 순번 반환, 실패 시 0
+		uint64_t appendUpsert(const GalleryUser& u);
+		uint64_t appendDelete(int id);
+		// seq 까지 디스크에 확정. 다른 호출의 fdatasync 가 이미 덮었으면 바로 true
+		bool sync(uint64_t seq);
+
+		qint64 bytes() const { return size_.load(std::memory_order_relaxed); }
+		bool compacting() const { return compacting_.load(std::memory_order_acquire); }
+
+		// 지금까지의 레코드가 writeBase 로 기반 저장소에 반영된다고 보고, 끝나면 그 뒤 레코드만 남김
+		//  writeBase 는 백그라운드 스레드에서 실행. 이미 압축 중이면 false
+		bool compactAsync(std::function<bool()> writeBase);
+		void waitCompaction();
+		// 레코드 전부 폐기 (기반 저장소를 통째로 다시 쓴 직후 / 초기화)
+		bool reset();
+
+	private:
+		uint64_t append(const QByteArray& payload);
+		bool refresh();									// size_ 를 파일 크기로 (교체됐으면 open)
+		bool reopen(qint64 keepFrom);					// keepFrom 이후 (파일 끝까지) 남겨 새 파일로 교체 (syncMutex_ + writeMutex_ 보유)
+		void closeFd();
+
+		QString				 path_;
+		int					 fd_ = -1;
+		std::atomic<qint64>	 size_{0};
+
+		std::mutex			 syncMutex_;				// 순서: syncMutex_ -> writeMutex_
+		std::mutex			 writeMutex_;
+		uint64_t			 written_ = 0;				// 쓴 레코드 수 (writeMutex_)
+		uint64_t			 synced_  = 0;				// fdatasync 로 확정된 레코드 수 (syncMutex_)
+
+		std::thread			 compactTh_;
+		std::atomic<bool>	 compacting_{false};
+};
@@ -0,0 +1,416 @@
+#include "match/EmbeddingStore.hpp"
+#include "match/GalleryIndex.hpp"		// paddedDim
+
+#include <QtCore/QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define STORE_CRC_ARM 1
+#elif defined(__SSE4_2__)
+#include <nmmintrin.h>
+#define STORE_CRC_SSE42 1
+#endif
+
+struct EmbeddingStore::Entry {
+	int32_t	 id;
+	uint32_t rowBegin;
+	uint32_t rowCount;
+	uint32_t flags;				// kHasPrototypes
+	uint32_t nameOffset;		// 이름 영역 기준
+	uint32_t nameBytes;
+};
+
+namespace {
+
+constexpr uint32_t kMagic		   = 0x424d4546;	// "FEMB"
+constexpr uint32_t kHasPrototypes = 1u << 0;
+constexpr size_t   kAlign		   = 64;
+
+struct Header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t headerBytes;
+	uint32_t dim;
+	uint32_t stride;
+	uint32_t users;
+	uint32_t rows;
+	uint32_t tableCrc;			// 테이블 + 이름
+	uint64_t tableOffset;
+	uint64_t tableBytes;
+	uint64_t meanOffset;		// users x stride float
+	uint64_t matrixOffset;		// rows x stride float
+	uint32_t dataCrc;			// 평균 + 프로토타입 행렬
+	uint32_t headerCrc;			// 이 필드 앞까지
+};
+static_assert(sizeof(Header) == 72, "EmbeddingStore header layout");
+
+constexpr size_t alignUp(size_t n) { return (n + kAlign - 1) / kAlign * kAlign; }
+
+// QSaveFile 에 고정 크기 청크로 모아 쓰기 + 구간별 CRC 누적
+class ChunkWriter {
+	public:
+		explicit ChunkWriter(QSaveFile& f) : f_(f) { buf_.reserve(kChunk); }
+
+		void put(const void* p, size_t n, uint32_t* crc = nullptr)
+		{
+			if (crc) *crc = EmbeddingStore::crc32c(p, n, *crc);
+			const char* c = static_cast<const char*>(p);
+			while (n > 0) {
+				const size_t k = std::min(n, kChunk - buf_.size());
+				buf_.insert(buf_.end(), c, c + k);
+				c += k;
+				n -= k;
+				if (buf_.size() == kChunk) flush();
+			}
+		}
+		// to 까지 0 으로 채움 (정렬 패딩)
+		void pad(size_t to, uint32_t* crc = nullptr)
+		{
+			static const char zero[kAlign] = {};
+			while (pos() < to) put(zero, std::min(to - pos(), kAlign), crc);
+		}
+		bool flush()
+		{
+			if (!buf_.empty()) {
+				ok_ = ok_ && f_.write(buf_.data(), qint64(buf_.size())) == qint64(buf_.size());
+				written_ += buf_.size();
+				buf_.clear();
+			}
+			return ok_;
+		}
+		size_t pos() const { return written_ + buf_.size(); }
+
+	private:
+		static constexpr size_t kChunk = size_t(1) << 20;
+
+		QSaveFile&			f_;
+		std::vector<char>	buf_;
+		size_t				written_ = 0;
+		bool				ok_		 = true;
+};
+
+// JSON 행 <-> float (exportJson / importJson 공용)
+QJsonArray jsonRow(const float* v, int dim)
+{
+	QJsonArray a;
+	for (int i = 0; i < dim; ++i) a.append(double(v[i]));
+	return a;
+}
+
+std::vector<float> rowFromJson(const QJsonArray& a)
+{
+	std::vector<float> v;
+	v.reserve(static_cast<size_t>(a.size()));
+	for (const auto& x : a) v.push_back(float(x.toDouble()));
+	return v;
+}
+
+} // namespace
+
+uint32_t EmbeddingStore::crc32c(const void* data, size_t n, uint32_t crc)
+{
+	const auto* p = static_cast<const uint8_t*>(data);
+	crc = ~crc;
+#if defined(STORE_CRC_ARM)
+	for (; n >= 8; n -= 8, p += 8) { uint64_t v; std::memcpy(&v, p, 8); crc = __crc32cd(crc, v); }
+	for (; n > 0; --n, ++p) crc = __crc32cb(crc, *p);
+#elif defined(STORE_CRC_SSE42)
+	uint64_t c = crc;
+	for (; n >= 8; n -= 8, p += 8) { uint64_t v; std::memcpy(&v, p, 8); c = _mm_crc32_u64(c, v); }
+	crc = static_cast<uint32_t>(c);
+	for (; n > 0; --n, ++p) crc = _mm_crc32_u8(crc, *p);
+#else
+	static const auto table = [] {
+		std::vector<uint32_t> t(256);
+		for (uint32_t i = 0; i < 256; ++i) {
+			uint32_t c = i;
+			for (int k = 0; k < 8; ++k) c = (c & 1) ? (c >> 1) ^ 0x82f63b78u : (c >> 1);
+			t[i] = c;
+		}
+		return t;
+	}();
+	for (; n > 0; --n, ++p) crc = table[(crc ^ *p) & 0xff] ^ (crc >> 8);
+#endif
+	return ~crc;
+}
+
+EmbeddingStore::~EmbeddingStore()
+{
+	if (base_) file_.unmap(const_cast<uchar*>(base_));
+}
+
+const EmbeddingStore::Entry& EmbeddingStore::entry(int u) const
+{
+	return reinterpret_cast<const Entry*>(table_)[u];
+}
+
+int EmbeddingStore::id(int u) const { return entry(u).id; }
+int EmbeddingStore::rowBegin(int u) const { return static_cast<int>(entry(u).rowBegin); }
+int EmbeddingStore::rowEnd(int u) const { return static_cast<int>(entry(u).rowBegin + entry(u).rowCount); }
+bool EmbeddingStore::hasPrototypes(int u) const { return (entry(u).flags & kHasPrototypes) != 0; }
+
+QString EmbeddingStore::name(int u) const
+{
+	const Entry& e = entry(u);
+	return QString::fromUtf8(names_ + e.nameOffset, static_cast<int>(e.nameBytes));
+}
+
+bool EmbeddingStore::save(const QString& path, const std::vector<GalleryUserPtr>& users, int dim)
+{
+	if (dim <= 0) return false;
+	const size_t stride = static_cast<size_t>(GalleryIndex::paddedDim(dim));
+
+	// 1) 저장 대상 + 행 수 + 이름
+	std::vector<const GalleryUser*> keep;
+	std::vector<QByteArray> names;
+	size_t rows = 0, nameBytes = 0;
+	for (const auto& u : users) {
+		if (!u) continue;
+		if (u->dim != dim) {
+			qWarning() << "[EmbeddingStore] skip id=" << u->id << "dim=" << u->dim;
+			continue;
+		}
+		rows += static_cast<size_t>(u->rows);
+		keep.push_back(u.get());
+		names.push_back(u->name.toUtf8());
+		nameBytes += static_cast<size_t>(names.back().size());
+	}
+
+	// 2) 배치
+	Header h{};
+	h.magic		   = kMagic;
+	h.version	   = kVersion;
+	h.headerBytes  = sizeof(Header);
+	h.dim		   = static_cast<uint32_t>(dim);
+	h.stride	   = static_cast<uint32_t>(stride);
+	h.users		   = static_cast<uint32_t>(keep.size());
+	h.rows		   = static_cast<uint32_t>(rows);
+	h.tableOffset  = alignUp(sizeof(Header));
+	h.tableBytes   = keep.size() * sizeof(Entry) + nameBytes;
+	h.meanOffset   = alignUp(h.tableOffset + h.tableBytes);
+	h.matrixOffset = alignUp(h.meanOffset + keep.size() * stride * sizeof(float));
+	const size_t total = h.matrixOffset + rows * stride * sizeof(float);
+
+	// 3) 임시 파일에 청크 단위로 쓰면서 CRC 누적 (파일 전체를 메모리에 만들지 않음) -> 헤더는 마지막에 -> rename
+	QSaveFile f(path);
+	if (!f.open(QIODevice::WriteOnly)) {
+		qWarning() << "[EmbeddingStore] open failed:" << path << f.errorString();
+		return false;
+	}
+	ChunkWriter w(f);
+	w.pad(h.tableOffset);							// 헤더 자리
+
+	uint32_t row = 0, nameOff = 0;
+	for (size_t i = 0; i < keep.size(); ++i) {
+		const GalleryUser& u = *keep[i];
+		Entry e{};
+		e.id		 = u.id;
+		e.rowBegin	 = row;
+		e.rowCount	 = static_cast<uint32_t>(u.rows);
+		e.flags		 = u.prototypes ? kHasPrototypes : 0;
+		e.nameOffset = nameOff;
+		e.nameBytes	 = static_cast<uint32_t>(names[i].size());
+		w.put(&e, sizeof(e), &h.tableCrc);
+		row		+= e.rowCount;
+		nameOff += e.nameBytes;
+	}
+	for (const QByteArray& n : names) w.put(n.constData(), size_t(n.size()), &h.tableCrc);
+	w.pad(h.meanOffset);
+
+	// 사용자 행은 이미 정규화 + 패딩 -> 그대로 (코드 전용 블록은 복원값)
+	std::vector<float> line(stride, 0.0f);
+	for (const GalleryUser* u : keep) {
+		u->copyRow(-1, line.data());
+		w.put(line.data(), stride * sizeof(float), &h.dataCrc);
+	}
+	w.pad(h.matrixOffset, &h.dataCrc);
+	for (const GalleryUser* u : keep) {
+		for (int r = 0; r < u->rows; ++r) {
+			u->copyRow(r, line.data());
+			w.put(line.data(), stride * sizeof(float), &h.dataCrc);
+		}
+	}
+	h.headerCrc = crc32c(&h, offsetof(Header, headerCrc));
+
+	if (!w.flush() || w.pos() != total || !f.seek(0)
+		|| f.write(reinterpret_cast<const char*>(&h), sizeof(h)) != qint64(sizeof(h))) {
+		f.cancelWriting();
+		qWarning() << "[EmbeddingStore] write failed:" << path;
+		return false;
+	}
+	if (!f.commit()) {
+		qWarning() << "[EmbeddingStore] commit failed:" << path << f.errorString();
+		return false;
+	}
+	qInfo() << "[EmbeddingStore] saved users=" << h.users << "rows=" << h.rows << "bytes=" << qint64(total) << "to" << path;
+	return true;
+}
+
+EmbeddingStore::Ptr EmbeddingStore::load(const QString& path)
+{
+	std::shared_ptr<EmbeddingStore> s(new EmbeddingStore());
+	s->file_.setFileName(path);
+	if (!s->file_.open(QIODevice::ReadOnly)) return nullptr;
+
+	s->bytes_ = s->file_.size();
+	if (s->bytes_ < static_cast<qint64>(sizeof(Header))) {
+		qWarning() << "[EmbeddingStore] truncated:" << path;
+		return nullptr;
+	}
+	s->base_ = s->file_.map(0, s->bytes_);
+	if (!s->base_) {
+		qWarning() << "[EmbeddingStore] mmap failed:" << path << s->file_.errorString();
+		return nullptr;
+	}
+
+	// 헤더
+	Header h;
+	std::memcpy(&h, s->base_, sizeof(h));
+	const size_t size = static_cast<size_t>(s->bytes_);
+	if (h.magic != kMagic || h.version != kVersion || h.headerBytes != sizeof(Header)
+		|| h.headerCrc != crc32c(&h, offsetof(Header, headerCrc))) {
+		qWarning() << "[EmbeddingStore] header mismatch:" << path;
+		return nullptr;
+	}
+	const size_t stride = static_cast<size_t>(h.stride);
+	if (h.dim == 0 || stride != static_cast<size_t>(GalleryIndex::paddedDim(static_cast<int>(h.dim)))
+		|| h.tableOffset % kAlign || h.meanOffset % kAlign || h.matrixOffset % kAlign
+		|| h.tableBytes < uint64_t(h.users) * sizeof(Entry)
+		|| h.tableOffset + h.tableBytes > h.meanOffset
+		|| h.meanOffset + uint64_t(h.users) * stride * sizeof(float) > h.matrixOffset
+		|| h.matrixOffset + uint64_t(h.rows) * stride * sizeof(float) != size) {
+		qWarning() << "[EmbeddingStore] layout mismatch:" << path;
+		return nullptr;
+	}
+
+	// 무결성
+	if (crc32c(s->base_ + h.tableOffset, h.tableBytes) != h.tableCrc
+		|| crc32c(s->base_ + h.meanOffset, size - h.meanOffset) != h.dataCrc) {
+		qWarning() << "[EmbeddingStore] checksum mismatch:" << path;
+		return nullptr;
+	}
+
+	s->dim_	   = static_cast<int>(h.dim);
+	s->stride_ = stride;
+	s->users_  = static_cast<int>(h.users);
+	s->rows_   = static_cast<int>(h.rows);
+	s->table_  = s->base_ + h.tableOffset;
+	s->names_  = reinterpret_cast<const char*>(s->table_ + size_t(h.users) * sizeof(Entry));
+	s->mean_   = reinterpret_cast<const float*>(s->base_ + h.meanOffset);
+	s->matrix_ = reinterpret_cast<const float*>(s->base_ + h.matrixOffset);
+
+	// 테이블: 행 구간이 빈틈없이 이어지고 이름이 영역 안에 있어야 함
+	const uint64_t nameArea = h.tableBytes - uint64_t(h.users) * sizeof(Entry);
+	uint32_t next = 0;
+	for (int u = 0; u < s->users_; ++u) {
+		const Entry& e = s->entry(u);
+		if (e.rowBegin != next || e.rowCount == 0 || uint64_t(e.nameOffset) + e.nameBytes > nameArea) {
+			qWarning() << "[EmbeddingStore] table mismatch at" << u << ":" << path;
+			return nullptr;
+		}
+		next += e.rowCount;
+	}
+	if (next != h.rows) {
+		qWarning() << "[EmbeddingStore] row count mismatch:" << next << "!=" << h.rows << ":" << path;
+		return nullptr;
+	}
+
+	qInfo() << "[EmbeddingStore] mapped users=" << s->users_ << "rows=" << s->rows_ << "dim=" << s->dim_ << "from" << path;
+	return s;
+}
+
+// 사용자 블록은 한 번에 할당하고 aliasing shared_ptr 로 나눠 줌 (블록이 남아 있는 동안 매핑 유지)
+std::vector<GalleryUserPtr> EmbeddingStore::users() const
+{
+	auto block = std::make_shared<std::vector<GalleryUser>>(static_cast<size_t>(users_));
+	const Ptr self = shared_from_this();
+	for (int u = 0; u < users_; ++u) {
+		GalleryUser& g = (*block)[static_cast<size_t>(u)];
+		g.id		 = id(u);
+		g.name		 = name(u);
+		g.dim		 = dim_;
+		g.stride	 = stride_;
+		g.rows		 = rowEnd(u) - rowBegin(u);
+		g.prototypes = hasPrototypes(u);
+		g.mean		 = mean(u);
+		g.data		 = matrix_ + size_t(rowBegin(u)) * stride_;
+		g.mapped	 = true;
+		g.owner		 = self;
+	}
+
+	std::vector<GalleryUserPtr> out;
+	out.reserve(block->size());
+	for (const GalleryUser& g : *block) out.emplace_back(block, &g);
+	return out;
+}
+
+bool EmbeddingStore::exportJson(const QString& path, const std::vector<GalleryUserPtr>& users, int dim)
+{
+	QJsonArray items;
+	std::vector<float> row(static_cast<size_t>(std::max(dim, 0)));
+	for (const auto& u : users) {
+		if (!u || u->dim != dim) continue;
+		QJsonObject o;
+		o["id"] = u->id;
+		o["name"] = u->name;
+		u->copyRow(-1, row.data());
+		o["embedding"] = jsonRow(row.data(), dim);
+		if (u->prototypes) {
+			QJsonArray protos;
+			for (int r = 0; r < u->rows; ++r) {
+				u->copyRow(r, row.data());
+				protos.append(jsonRow(row.data(), dim));
+			}
+			o["prototypes"] = protos;
+		}
+		items.append(o);
+	}
+
+	QJsonObject root;
+	root["count"] = int(items.size());
+	root["dim"] = dim;
+	root["items"] = items;
+	root["version"] = 2;		// 2: prototypes 추가 (없으면 embedding 하나로 매칭)
+
+	QSaveFile f(path);
+	if (!f.open(QIODevice::WriteOnly)) return false;
+	const QByteArray out = QJsonDocument(root).toJson(QJsonDocument::Indented);
+	if (f.write(out) != out.size()) { f.cancelWriting(); return false; }
+	return f.commit();
+}
+
+bool EmbeddingStore::importJson(const QString& path, std::vector<UserEmbedding>& out)
+{
+	out.clear();
+	QFile f(path);
+	if (!f.open(QIODevice::ReadOnly)) return false;
+
+	const QJsonDocument jd = QJsonDocument::fromJson(f.readAll());
+	f.close();
+	if (!jd.isObject()) return false;
+
+	const auto items = jd.object().value("items").toArray();
+	out.reserve(items.size());
+	for (const auto& v : items) {
+		const auto o = v.toObject();
+		UserEmbedding ue;
+		ue.id	= o.value("id").toInt(-1);
+		ue.name = o.value("name").toString();
+
+		ue.embedding = rowFromJson(o.value("embedding").toArray());
+		for (const auto& pv : o.value("prototypes").toArray()) {
+			std::vector<float> p = rowFromJson(pv.toArray());
+			if (p.size() == ue.embedding.size()) ue.prototypes.push_back(std::move(p));
+		}
+
+		if (ue.id >= 0) out.push_back(std::move(ue));
+	}
+	return true;
+}
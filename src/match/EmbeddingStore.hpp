@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <QFile>
+#include <QString>
+
+#include "include/types.hpp"		// UserEmbedding
+#include "match/GalleryUser.hpp"
+
+// 갤러리 바이너리 저장소 (embeddings.bin)
+//  [Header 72B][사용자 테이블][이름 UTF-8] .. [평균 행렬] .. [프로토타입 행렬]   (리틀 엔디언)
+//  - 테이블은 고정 크기 항목 -> 사용자 u 접근 O(1)
+//  - 두 행렬은 64B 정렬, 행은 L2 정규화 + 0 패딩(stride = GalleryIndex::paddedDim) -> mmap 그대로 GalleryIndex 에 넘김
+//  - 헤더/테이블/행렬 각각 CRC32C, 하나라도 어긋나면 load 실패
+//  - 저장은 QSaveFile (임시 파일 -> rename)
+//  - 갤러리는 users() 의 사용자 블록으로 읽음: id/이름만 만들고 행은 매핑을 그대로 가리킴 (매핑 수명 = 블록 수명)
+// JSON 은 디버깅용 내보내기와 구버전(embeddings.json) 이관에만 사용
+class EmbeddingStore : public std::enable_shared_from_this<EmbeddingStore> {
+	public:
+		using Ptr = std::shared_ptr<const EmbeddingStore>;
+
+		static constexpr uint32_t kVersion = 1;
+
+		// 차원이 dim 이 아닌 사용자는 건너뜀 (행은 이미 정규화돼 있어 그대로 복사)
+		static bool save(const QString& path, const std::vector<GalleryUserPtr>& users, int dim);
+		// 파일을 읽기 전용으로 mmap. 실패(없음/헤더/CRC)하면 nullptr
+		static Ptr load(const QString& path);
+
+		// CRC32C (Castagnoli). AArch64 CRC / SSE4.2 명령, 그 외 테이블
+		static uint32_t crc32c(const void* data, size_t n, uint32_t crc = 0);
+
+		// embeddings.json 형식 {version, dim, count, items[{id, name, embedding, prototypes}]}
+		static bool exportJson(const QString& path, const std::vector<GalleryUserPtr>& users, int dim);
+		static bool importJson(const QString& path, std::vector<UserEmbedding>& out);
+
+		~EmbeddingStore();
+		EmbeddingStore(const EmbeddingStore&) = delete;
+		EmbeddingStore& operator=(const EmbeddingStore&) = delete;
+
+		int	   dim() const { return dim_; }
+		size_t stride() const { return stride_; }
+		int	   size() const { return users_; }
+		int	   rows() const { return rows_; }
+
+		int		id(int u) const;
+		QString name(int u) const;
+		const float* mean(int u) const { return mean_ + static_cast<size_t>(u) * stride_; }
+		int		rowBegin(int u) const;
+		int		rowEnd(int u) const;
+		bool	hasPrototypes(int u) const;			// false 면 행은 평균 하나
+		const float* matrix() const { return matrix_; }
+
+		// 저장소 순서의 사용자 블록 (행 복사 없음, 블록이 이 저장소를 잡아 둠)
+		std::vector<GalleryUserPtr> users() const;
+
+	private:
+		struct Entry;
+		EmbeddingStore() = default;
+		const Entry& entry(int u) const;
+
+		QFile		   file_;				// 매핑 수명 = 객체 수명
+		const uchar*   base_   = nullptr;
+		qint64		   bytes_  = 0;
+		int			   dim_	   = 0;
+		size_t		   stride_ = 0;
+		int			   users_  = 0;
+		int			   rows_   = 0;
+		const uchar*   table_  = nullptr;
+		const char*	   names_  = nullptr;
+		const float*   mean_   = nullptr;
+		const float*   matrix_ = nullptr;
+};
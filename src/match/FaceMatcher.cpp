@@ -5,8 +5,69 @@
 #include <cmath>
 #include <limits>
 
-MatchResult FaceMatcher::bestMatch(const cv::Mat&  alignedFaceBGR, 
-								   const std::vector<UserEmbedding>& gallery)
+void FaceMatcher::setStorage(GalleryIndex::Storage s)
+{
+	m_storage.store(s);
+}
+
+GallerySnapshot::Ptr FaceMatcher::rebuild(const GallerySnapshot& prev, const std::vector<GalleryUserPtr>& users) const
+{
+	// 첫 게시(또는 이전이 빈 스냅샷)는 파일 그래프를 시작점으로, 아니면 이전 버전 그래프에 차이만
+	//  시드는 복사해 쓰므로 포인터만 잡고 구성은 락 밖에서
+	std::shared_ptr<const HnswIndex> seed;
+	if (prev.ann().size() == 0) {
+		std::lock_guard<std::mutex> lk(m_writeMutex);
+		seed = m_annSeed;
+	}
+	return GallerySnapshot::build(users, m_storage.load(), prev.version() + 1, seed ? seed.get() : &prev.ann());
+}
+
+GallerySnapshot::Ptr FaceMatcher::derive(const GallerySnapshot& prev, const GalleryDelta& delta) const
+{
+	return GallerySnapshot::derive(prev, delta, m_storage.load());
+}
+
+bool FaceMatcher::publish(const GallerySnapshot::Ptr& prev, const GallerySnapshot::Ptr& next)
+{
+	std::lock_guard<std::mutex> lk(m_writeMutex);
+	if (std::atomic_load(&m_gallery) != prev) return false;
+	std::atomic_store(&m_gallery, next);
+	if (next->ann().size() > 0) m_annSeed.reset();		// 이후 구성은 게시된 그래프에서
+	return true;
+}
+
+bool FaceMatcher::loadAnnIndex(const QString& path)
+{
+	auto seed = std::make_shared<HnswIndex>();
+	if (!seed->load(path.toStdString())) return false;
+	std::lock_guard<std::mutex> lk(m_writeMutex);
+	m_annSeed = std::move(seed);
+	return true;
+}
+
+bool FaceMatcher::saveAnnIndex(const QString& path) const
+{
+	return gallery()->ann().save(path.toStdString());
+}
+
+// 큰 갤러리는 HNSW 후보 -> 정확 재정렬, 아니면 전수 스캔
+std::vector<GalleryIndex::Hit> FaceMatcher::search(const GallerySnapshot& g, const std::vector<float>& emb, int k)
+{
+	const GalleryIndex& index = g.index();
+	if (index.size() < kAnnMinRows || g.ann().size() != index.size()) {
+		return index.topK(emb, k);
+	}
+
+	std::vector<int> rows;
+	for (const auto& h : g.ann().search(emb, std::max(k, kRerank))) {
+		const int r = g.indexRowOf(h.label);
+		if (r >= 0) rows.push_back(r);
+	}
+	if (rows.empty()) return index.topK(emb, k);
+	return index.rerank(emb, rows, k);
+}
+
+MatchResult FaceMatcher::bestMatch(FaceSample& sample) const
 {
 	MatchResult r;
 	r.sim = -1.0f;
@@ -16,88 +77,104 @@ MatchResult FaceMatcher::bestMatch(const cv::Mat&  alignedFaceBGR,
 		qWarning() << "[FaceMatcher] m_embedder is null";
 		return r;
 	}
-	if (gallery.empty()) {
-		qWarning() << "[FaceMatcher] gallery is empty";
-		return r;
-	}
-
-	std::vector<float> emb;
-	if (!m_embedder->extract(alignedFaceBGR, emb) || emb.empty()) {
+	// 갤러리가 비어 있어도 임베딩은 채워 둔다 (등록 단계에서 재사용)
+	if (!sample.hasEmbedding()
+		&& (!m_embedder->extract(sample.aligned, sample.embedding) || sample.embedding.empty())) {
 		qWarning() << "[FaceMatcher] extract() failed or empty embedding";
+		sample.embedding.clear();
 		return r;
 	}
 
-	const int d_in = (int)emb.size();
+	return bestMatch(sample.embedding);
+}
 
-	for (const auto& u : gallery) {
-		if (u.embedding.empty()) continue;
-		float sim = m_embedder->cosine(emb, u.embedding);
-		if (sim > r.sim) {
-			r.sim		= sim;
-			r.id		= u.id;
-			r.name	= u.name; 
-		}
+MatchResult FaceMatcher::bestMatch(const std::vector<float>& emb) const
+{
+	MatchResult r;
+	r.sim = -1.0f;
+	r.id  = -1;
+
+	const GallerySnapshot::Ptr g = gallery();
+	if (g->index().empty()) {
+		qWarning() << "[FaceMatcher] gallery is empty";
+		return r;
 	}
+	if (emb.empty()) {
+		qWarning() << "[FaceMatcher] input embedding is empty";
+		return r;
+	}
+
+	const auto hits = search(*g, emb, 1);
+	if (hits.empty() || hits[0].row < 0) return r;
 
-	qDebug() << "[FaceMatcher] bestMatch result:" << r.name << "sim=" << r.sim;
+	r.sim  = hits[0].sim;
+	r.id   = g->index().id(hits[0].row);
+	r.name = g->index().name(hits[0].row);
 	return r;
 }
 
-MatchTop2 FaceMatcher::bestMatchTop2(const std::vector<float>& emb, const std::vector<UserEmbedding>& gallery, bool debugAngles)
+MatchTop2 FaceMatcher::bestMatchTop2(const std::vector<float>& emb, bool debugAngles) const
 {
 	MatchTop2 r;
-	 if (gallery.empty()) {
-    qWarning() << "[FaceMatcher] gallery is empty";
-    return r;
-  }
-  if (emb.empty()) {
-    qWarning() << "[FaceMatcher] input embedding is empty";
-    return r;
-  }
-
-	const int dim = (int)emb.size();
-	cv::Mat q(1, dim, CV_32F, const_cast<float*>(emb.data()));
-	q = q.clone();
-	double nq = cv::norm(q, cv::NORM_L2);
-	if (nq <= 0.0) return r;
-	q /= (nq + 1e-9);
-
-	for (int i = 0; i < (int)gallery.size(); ++i) {
-		const auto& u = gallery[i];
-		if ((int)u.embedding.size() != dim) {
-			qWarning() << "[FaceMatcher] dim mismatch i=" << i;
-			continue;
-		}
-		if (u.proto.empty() || u.proto.type() != CV_32F || u.proto.total() != (size_t)dim) {
-			qWarning() << "[FaceMatcher] invalid proto at i=" << i;
-			continue;
-		}
+	const GallerySnapshot::Ptr g = gallery();
+	if (g->index().empty()) {
+		qWarning() << "[FaceMatcher] gallery is empty";
+		return r;
+	}
+	if (emb.empty()) {
+		qWarning() << "[FaceMatcher] input embedding is empty";
+		return r;
+	}
 
-		double np = cv::norm(u.proto, cv::NORM_L2);
-		if (np < 0.0) {
-			qWarning() << "[FaceMatcher] proto L2==0 at i=" << i;
-			continue;
-		}
+	const auto hits = search(*g, emb, 2);
+	if (hits.size() > 0 && hits[0].row >= 0) { r.bestIdx	= hits[0].row; r.bestSim   = hits[0].sim; }
+	if (hits.size() > 1 && hits[1].row >= 0) { r.secondIdx = hits[1].row; r.secondSim = hits[1].sim; }
 
-		float sim = q.dot(u.proto / (float)(np + 1e-9));
-		if (debugAngles) {
-			double cosn = std::max(-1.0, std::min(1.0, (double)sim));
+	if (debugAngles) {
+		for (const auto& h : hits) {
+			double cosn = std::max(-1.0, std::min(1.0, (double)h.sim));
 			double deg  = std::acos(cosn) * 180.0 / M_PI;
-			qDebug() << "[FaceMatcher] i=" << i << "cos=" << cosn << "deg=" << deg;
-		}
-
-		if (sim > r.bestSim) {
-			r.secondIdx = r.bestIdx;
-			r.secondSim = r.bestSim;
-			r.bestIdx   = i;
-			r.bestSim	  = sim;
-		}
-		else if(sim > r.secondSim) {
-			r.secondIdx = i;
-			r.secondSim = sim;
+			qDebug() << "[FaceMatcher] i=" << h.row << "cos=" << cosn << "deg=" << deg;
 		}
 	}
-	
 	return r;
 }
 
+std::vector<std::vector<float>> FaceMatcher::makePrototypes(const std::vector<std::vector<float>>& embs, int k)
+{
+	std::vector<std::vector<float>> out;
+	if (embs.empty() || k <= 0) return out;
+
+	// 정규화된 샘플 행렬 (차원은 첫 샘플 기준)
+	const int dim = static_cast<int>(embs.front().size());
+	cv::Mat data(0, dim, CV_32F);
+	for (const auto& e : embs) {
+		if (static_cast<int>(e.size()) != dim || dim == 0) continue;
+		cv::Mat row(1, dim, CV_32F, const_cast<float*>(e.data()));
+		const double n = cv::norm(row);
+		if (n <= 1e-12) continue;
+		data.push_back(cv::Mat(row / n));
+	}
+	if (data.empty()) return out;
+
+	cv::Mat centers;
+	if (data.rows <= k) {
+		centers = data;
+	}
+	else {
+		// 단위 벡터의 유클리드 k-means = 코사인 기준 군집
+		cv::Mat labels;
+		cv::kmeans(data, k, labels,
+				   cv::TermCriteria(cv::TermCriteria::EPS | cv::TermCriteria::COUNT, 20, 1e-4),
+				   /*attempts*/3, cv::KMEANS_PP_CENTERS, centers);
+	}
+
+	out.reserve(static_cast<size_t>(centers.rows));
+	for (int i = 0; i < centers.rows; ++i) {
+		const double n = cv::norm(centers.row(i));
+		if (n <= 1e-12) continue;
+		cv::Mat c = centers.row(i) / n;
+		out.emplace_back(c.ptr<float>(), c.ptr<float>() + dim);
+	}
+	return out;
+}
@@ -1,19 +1,62 @@
 #pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <vector>
+#include <QString>
 #include "include/types.hpp"
 #include "ai/Embedder.hpp"
+#include "match/GallerySnapshot.hpp"
 
-// 단순 코사인 매칭기. 갤러리와 unknown 풀은 호출 시점에 받아온다(소유권 없음)
+// 코사인 매칭기. 갤러리는 불변 스냅샷(사용자 블록 + 검색 인덱스 + HNSW)으로 만들어(rebuild/derive) 원자적으로 교체한다(publish)
+//  - 사용자 점수 = 프로토타입(포즈별 대표 벡터) 중 최대 유사도
+//  - 사용자 수가 kAnnMinRows 이상이면 HNSW(사용자 평균 벡터) 후보 kRerank 명을 GalleryIndex 로 정확 재정렬
+//  - 그 미만(또는 HNSW 가 갤러리와 어긋난 경우)은 전수 SIMD 스캔
+//  - 검색은 호출 시점의 스냅샷 하나만 잡고 진행 -> 등록/삭제와 동시에 불려도 락 없이 안전
 class FaceMatcher {
 	public:
+		static constexpr int kAnnMinRows = 2000;		// 이보다 작으면 전수 스캔이 더 빠름
+		static constexpr int kRerank	 = 16;			// 근사 후보 중 정확 재계산할 개수
+		static constexpr int kMaxPrototypes = 5;		// 사용자당 프로토타입 상한 (등록 각도 단계 수)
+
 		explicit FaceMatcher(std::shared_ptr<Embedder> embedder)
 			: m_embedder(std::move(embedder)) {}
 
-		// 갤러리에서 best 1개 찾기
-		MatchResult bestMatch(const cv::Mat& alignedFaceBGR,
-							  const std::vector<UserEmbedding>& gallery);
-		// 갤러리에서 top-2 찾기
-		static MatchTop2 bestMatchTop2(const std::vector<float>& emb, const std::vector<UserEmbedding>& gallery, bool debugAngles = false);
+		// 갤러리 행렬 저장 형식 (다음 rebuild/derive 부터 적용)
+		void setStorage(GalleryIndex::Storage s);
+
+		// 게시 2단계: 새 스냅샷은 락 없이 만들고 (prev 는 불변), publish 는 현재가 아직 prev 일 때만 교체
+		//  publish 가 false 면 그 사이 다른 쓰기가 게시한 것 -> 현재 스냅샷으로 다시 만들 것
+		//  rebuild: 전체 교체 (로드 시). 첫 게시면 파일 그래프, 아니면 prev 의 그래프에 차이만 반영
+		//  derive:  변경분만
+		GallerySnapshot::Ptr rebuild(const GallerySnapshot& prev, const std::vector<GalleryUserPtr>& users) const;
+		GallerySnapshot::Ptr derive(const GallerySnapshot& prev, const GalleryDelta& delta) const;
+		bool publish(const GallerySnapshot::Ptr& prev, const GallerySnapshot::Ptr& next);
+		// 현재 스냅샷 (대기 없음). 한 번 잡은 포인터는 이후 교체와 무관하게 유효
+		GallerySnapshot::Ptr gallery() const { return std::atomic_load(&m_gallery); }
+
+		// HNSW 그래프 저장/로드 (로드한 그래프는 다음 rebuild 가 차이만 반영해 사용)
+		bool loadAnnIndex(const QString& path);
+		bool saveAnnIndex(const QString& path) const;
+
+		// 샘플로 best 1개 찾기 (임베딩이 없을 때만 추출해 샘플에 남김)
+		MatchResult bestMatch(FaceSample& sample) const;
+		// 이미 추출한 임베딩으로 best 1개 찾기 (재추출 없음)
+		MatchResult bestMatch(const std::vector<float>& emb) const;
+		// top-2 (bestIdx/secondIdx 는 그 시점 스냅샷의 GalleryIndex 사용자 인덱스)
+		MatchTop2 bestMatchTop2(const std::vector<float>& emb, bool debugAngles = false) const;
+
+		// 등록 임베딩들 -> 최대 k 개 프로토타입 (구면 k-means 중심, L2 정규화). 샘플이 k 개 이하면 그대로
+		static std::vector<std::vector<float>> makePrototypes(const std::vector<std::vector<float>>& embs,
+															  int k = kMaxPrototypes);
 	private:
+		static std::vector<GalleryIndex::Hit> search(const GallerySnapshot& g, const std::vector<float>& emb, int k);
+
 		std::shared_ptr<Embedder> m_embedder;
+		GallerySnapshot::Ptr	  m_gallery = GallerySnapshot::empty();	// std::atomic_load/store 로만 접근
+
+		// 쓰기 측 상태 (m_writeMutex)
+		mutable std::mutex		  m_writeMutex;
+		std::atomic<GalleryIndex::Storage> m_storage{ GalleryIndex::Storage::F32 };		// derive 는 락 없이 읽음
+		std::shared_ptr<const HnswIndex> m_annSeed;		// 파일에서 로드, 그래프가 있는 스냅샷이 게시되면 버림
 };
@@ -0,0 +1,570 @@
+#include "match/GalleryIndex.hpp"
+
+#include <QtCore/QDebug>
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__aarch64__) && defined(__ARM_NEON)		// vfmaq/vaddvq/vcvt_f32_f16: AArch64 전용
+#include <arm_neon.h>
+#define GALLERY_NEON 1
+#elif defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define GALLERY_AVX2 1
+#endif
+
+namespace {
+
+constexpr int kBlock = 32;			// 행/질의 패딩 단위 (float). 모든 커널의 스텝 배수
+
+// 누산기 여러 개로 FMA 의존 사슬을 끊는다. D 가 상수라 루프가 완전히 펼쳐짐
+template<int D>
+inline float dotFixed(const float* a, const float* b)
+{
+	static_assert(D % kBlock == 0, "dimension must be a multiple of kBlock");
+#if defined(GALLERY_NEON)
+	float32x4_t s0 = vdupq_n_f32(0.f), s1 = s0, s2 = s0, s3 = s0;
+	for (int i = 0; i < D; i += 16) {
+		s0 = vfmaq_f32(s0, vld1q_f32(a + i),	  vld1q_f32(b + i));
+		s1 = vfmaq_f32(s1, vld1q_f32(a + i + 4),  vld1q_f32(b + i + 4));
+		s2 = vfmaq_f32(s2, vld1q_f32(a + i + 8),  vld1q_f32(b + i + 8));
+		s3 = vfmaq_f32(s3, vld1q_f32(a + i + 12), vld1q_f32(b + i + 12));
+	}
+	return vaddvq_f32(vaddq_f32(vaddq_f32(s0, s1), vaddq_f32(s2, s3)));
+#elif defined(GALLERY_AVX2)
+	__m256 s0 = _mm256_setzero_ps(), s1 = s0, s2 = s0, s3 = s0;
+	for (int i = 0; i < D; i += 32) {
+		s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i),	  _mm256_loadu_ps(b + i),	   s0);
+		s1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8),  _mm256_loadu_ps(b + i + 8),  s1);
+		s2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16), s2);
+		s3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24), s3);
+	}
+	const __m256 s = _mm256_add_ps(_mm256_add_ps(s0, s1), _mm256_add_ps(s2, s3));
+	__m128 h = _mm_add_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1));
+	h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+	h = _mm_add_ss(h, _mm_shuffle_ps(h, h, 1));
+	return _mm_cvtss_f32(h);
+#else
+	float s0 = 0.f, s1 = 0.f, s2 = 0.f, s3 = 0.f;
+	for (int i = 0; i < D; i += 4) {
+		s0 += a[i]	   * b[i];
+		s1 += a[i + 1] * b[i + 1];
+		s2 += a[i + 2] * b[i + 2];
+		s3 += a[i + 3] * b[i + 3];
+	}
+	return (s0 + s1) + (s2 + s3);
+#endif
+}
+
+// 임의 차원 (모델 교체 대비): kBlock 단위 0 패딩이라 꼬리 처리 없음
+inline float dotPadded(const float* a, const float* b, int paddedDim)
+{
+	float s = 0.f;
+	for (int i = 0; i < paddedDim; i += kBlock) s += dotFixed<kBlock>(a + i, b + i);
+	return s;
+}
+
+// ── INT8: 정수 내적 (int16 곱 -> int32 누산) ──
+inline int32_t dotI8Block(const int8_t* a, const int8_t* b)		// kBlock 원소
+{
+#if defined(GALLERY_NEON)
+	int32x4_t acc = vdupq_n_s32(0);
+	for (int i = 0; i < kBlock; i += 16) {
+		const int8x16_t va = vld1q_s8(a + i);
+		const int8x16_t vb = vld1q_s8(b + i);
+		acc = vpadalq_s16(acc, vmull_s8(vget_low_s8(va),  vget_low_s8(vb)));
+		acc = vpadalq_s16(acc, vmull_s8(vget_high_s8(va), vget_high_s8(vb)));
+	}
+	return vaddvq_s32(acc);
+#elif defined(GALLERY_AVX2)
+	const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+	const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+	__m256i acc = _mm256_madd_epi16(_mm256_cvtepi8_epi16(_mm256_castsi256_si128(va)),
+									_mm256_cvtepi8_epi16(_mm256_castsi256_si128(vb)));
+	acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_cvtepi8_epi16(_mm256_extracti128_si256(va, 1)),
+												  _mm256_cvtepi8_epi16(_mm256_extracti128_si256(vb, 1))));
+	__m128i h = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+	h = _mm_add_epi32(h, _mm_shuffle_epi32(h, _MM_SHUFFLE(1, 0, 3, 2)));
+	h = _mm_add_epi32(h, _mm_shuffle_epi32(h, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(h);
+#else
+	int32_t s = 0;
+	for (int i = 0; i < kBlock; ++i) s += int32_t(a[i]) * int32_t(b[i]);
+	return s;
+#endif
+}
+
+template<int D>
+inline int32_t dotI8(const int8_t* a, const int8_t* b)
+{
+	int32_t s = 0;
+	for (int i = 0; i < D; i += kBlock) s += dotI8Block(a + i, b + i);
+	return s;
+}
+
+// ── FP16: 저장은 IEEE half, 스캔 때 float 로 펼쳐 FMA ──
+inline float halfToFloat(uint16_t h)
+{
+	const uint32_t sign = uint32_t(h & 0x8000) << 16;
+	uint32_t exp  = (h >> 10) & 0x1f;
+	uint32_t mant = h & 0x3ff;
+	uint32_t bits;
+	if (exp == 0) {
+		if (mant == 0) bits = sign;
+		else {											// subnormal -> 정규화
+			exp = 127 - 15 + 1;
+			while (!(mant & 0x400)) { mant <<= 1; --exp; }
+			bits = sign | (exp << 23) | ((mant & 0x3ff) << 13);
+		}
+	}
+	else if (exp == 0x1f) bits = sign | 0x7f800000 | (mant << 13);
+	else				  bits = sign | ((exp + 127 - 15) << 23) | (mant << 13);
+	float f;
+	std::memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+inline uint16_t floatToHalf(float f)			// 정규화 벡터 범위 전제 (|f| <= 1), 최근접 짝수 반올림
+{
+	uint32_t x;
+	std::memcpy(&x, &f, sizeof(x));
+	const uint16_t sign = uint16_t((x >> 16) & 0x8000);
+	const int	   exp	= int((x >> 23) & 0xff) - 127 + 15;
+	uint32_t	   mant = x & 0x7fffff;
+	if (exp <= 0) {
+		if (exp < -10) return sign;
+		mant |= 0x800000;
+		const int shift = 14 - exp;
+		uint32_t h = mant >> shift;
+		const uint32_t rem = mant & ((1u << shift) - 1), half = 1u << (shift - 1);
+		if (rem > half || (rem == half && (h & 1))) ++h;
+		return uint16_t(sign | h);
+	}
+	if (exp >= 0x1f) return uint16_t(sign | 0x7c00);
+	uint32_t h = (uint32_t(exp) << 10) | (mant >> 13);
+	const uint32_t rem = mant & 0x1fff;
+	if (rem > 0x1000 || (rem == 0x1000 && (h & 1))) ++h;
+	return uint16_t(sign | h);
+}
+
+inline float dotF16Block(const float* q, const uint16_t* h)		// kBlock 원소
+{
+#if defined(GALLERY_NEON)
+	float32x4_t s0 = vdupq_n_f32(0.f), s1 = s0;
+	for (int i = 0; i < kBlock; i += 8) {
+		const uint16x8_t v = vld1q_u16(h + i);
+		s0 = vfmaq_f32(s0, vld1q_f32(q + i),	 vcvt_f32_f16(vreinterpret_f16_u16(vget_low_u16(v))));
+		s1 = vfmaq_f32(s1, vld1q_f32(q + i + 4), vcvt_f32_f16(vreinterpret_f16_u16(vget_high_u16(v))));
+	}
+	return vaddvq_f32(vaddq_f32(s0, s1));
+#elif defined(GALLERY_AVX2) && defined(__F16C__)
+	__m256 s = _mm256_setzero_ps();
+	for (int i = 0; i < kBlock; i += 8) {
+		const __m256 v = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h + i)));
+		s = _mm256_fmadd_ps(_mm256_loadu_ps(q + i), v, s);
+	}
+	__m128 r = _mm_add_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1));
+	r = _mm_add_ps(r, _mm_movehl_ps(r, r));
+	r = _mm_add_ss(r, _mm_shuffle_ps(r, r, 1));
+	return _mm_cvtss_f32(r);
+#else
+	float s = 0.f;
+	for (int i = 0; i < kBlock; ++i) s += q[i] * halfToFloat(h[i]);
+	return s;
+#endif
+}
+
+template<int D>
+inline float dotF16(const float* q, const uint16_t* h)
+{
+	float s = 0.f;
+	for (int i = 0; i < D; i += kBlock) s += dotF16Block(q + i, h + i);
+	return s;
+}
+
+inline size_t padTo(int n, int m) { return static_cast<size_t>((n + m - 1) / m * m); }
+
+template<typename T>
+T* allocAligned(size_t count)
+{
+	const size_t bytes = (count * sizeof(T) + 63) / 64 * 64;
+	void* p = std::aligned_alloc(64, std::max<size_t>(bytes, 64));
+	if (p) std::memset(p, 0, std::max<size_t>(bytes, 64));
+	return static_cast<T*>(p);
+}
+
+// top-K 유지: best 는 sim 내림차순, 길이 k
+inline void pushHit(GalleryIndex::Hit* best, int k, int row, float sim)
+{
+	if (sim <= best[k - 1].sim) return;
+	int i = k - 1;
+	while (i > 0 && best[i - 1].sim < sim) { best[i] = best[i - 1]; --i; }
+	best[i] = { row, sim };
+}
+
+// 대칭 INT8: scale = max|x| / 127
+inline float quantizeI8(const float* x, int dim, int8_t* dst)
+{
+	float m = 0.f;
+	for (int i = 0; i < dim; ++i) m = std::max(m, std::abs(x[i]));
+	if (m <= 0.f) return 0.f;
+	const float inv = 127.f / m;
+	for (int i = 0; i < dim; ++i) dst[i] = static_cast<int8_t>(std::lround(x[i] * inv));
+	return m / 127.f;
+}
+
+// 사용자 행 -> 압축 코드 (행은 이미 정규화 + 패딩, 코드 전용 블록이면 복원해서 다시)
+//  withMean: 평균 행도 (프로토타입 사용자는 rows 번째 행, 아니면 매칭 행과 같음)
+std::shared_ptr<GalleryCodes> encodeRows(const GalleryUser& u, GalleryIndex::Storage storage, bool withMean)
+{
+	auto c = std::make_shared<GalleryCodes>();
+	const size_t stride = static_cast<size_t>(GalleryIndex::paddedDim(u.dim));
+	const bool	 extra	= withMean && u.prototypes;
+	const int	 n		= u.rows + (extra ? 1 : 0);
+	const size_t cells	= static_cast<size_t>(n) * stride;
+	c->meanRow = extra ? u.rows : 0;
+
+	std::vector<float> row(static_cast<size_t>(u.dim));
+	if (storage == GalleryIndex::Storage::F16) {
+		c->half.reset(allocAligned<uint16_t>(cells));
+		if (!c->half) return nullptr;
+	}
+	else {
+		c->i8.reset(allocAligned<int8_t>(cells));
+		if (!c->i8) return nullptr;
+		c->scales.resize(static_cast<size_t>(n));
+	}
+	for (int r = 0; r < n; ++r) {
+		u.copyRow(r < u.rows ? r : -1, row.data());
+		const size_t off = static_cast<size_t>(r) * stride;
+		if (c->half) {
+			for (int i = 0; i < u.dim; ++i) c->half.get()[off + static_cast<size_t>(i)] = floatToHalf(row[static_cast<size_t>(i)]);
+		}
+		else {
+			c->scales[static_cast<size_t>(r)] = quantizeI8(row.data(), u.dim, c->i8.get() + off);
+		}
+	}
+	return c;
+}
+
+} // namespace
+
+void GalleryIndex::clear()
+{
+	slots_.clear();
+	slotById_.clear();
+	stride_ = 0;
+	rows_	= 0;
+	live_	= 0;
+	dim_	= 0;
+}
+
+size_t GalleryIndex::bytes() const
+{
+	const size_t n = static_cast<size_t>(rows_) * stride_;
+	switch (storage_) {
+		case Storage::F16: return n * sizeof(uint16_t);
+		case Storage::I8:  return n * sizeof(int8_t) + static_cast<size_t>(rows_) * sizeof(float);
+		default:		   return n * sizeof(float);
+	}
+}
+
+GalleryUserPtr GalleryIndex::fit(const GalleryUserPtr& u, Storage storage)
+{
+	if (!u) return u;
+	if (storage == Storage::F32) {
+		if (u->hasRows()) return u;
+		// 코드 전용 -> 복원한 float 행 (양자화 오차는 그대로 남음)
+		std::vector<float> mean(static_cast<size_t>(u->dim));
+		std::vector<float> protos(static_cast<size_t>(u->protoCount()) * static_cast<size_t>(u->dim));
+		u->copyRow(-1, mean.data());
+		for (int r = 0; r < u->protoCount(); ++r) u->copyRow(r, protos.data() + static_cast<size_t>(r) * u->dim);
+		return GalleryUser::make(u->id, u->name, u->dim, mean.data(), protos.data(), u->protoCount());
+	}
+	if (u->mapped) return u;			// 재계산은 매핑의 float 행 (페이지 캐시, 힙 아님)
+	if (u->codes && bool(u->codes->i8) == (storage == Storage::I8)) return u;
+
+	std::shared_ptr<GalleryCodes> codes = encodeRows(*u, storage, true);
+	if (!codes) return u;
+	auto c = std::make_shared<GalleryUser>();
+	c->id		  = u->id;
+	c->name		  = u->name;
+	c->dim		  = u->dim;
+	c->stride	  = u->stride;
+	c->rows		  = u->rows;
+	c->prototypes = u->prototypes;
+	c->codes	  = std::move(codes);
+	return c;
+}
+
+void GalleryIndex::decodeRow(const GalleryCodes& c, int r, int dim, float* dst)
+{
+	const size_t off = static_cast<size_t>(r) * padTo(dim, kBlock);
+	if (c.half) {
+		for (int i = 0; i < dim; ++i) dst[i] = halfToFloat(c.half.get()[off + static_cast<size_t>(i)]);
+	}
+	else {
+		const float sc = c.scales[static_cast<size_t>(r)];
+		for (int i = 0; i < dim; ++i) dst[i] = float(c.i8.get()[off + static_cast<size_t>(i)]) * sc;
+	}
+}
+
+float GalleryIndex::dotCodes(const float* q, const GalleryCodes& c, int r, int dim)
+{
+	const size_t stride = padTo(dim, kBlock);
+	const size_t off	= static_cast<size_t>(r) * stride;
+	if (c.half) {
+		const uint16_t* h = c.half.get() + off;
+		if (dim == kFixedDim) return dotF16<kFixedDim>(q, h);
+		float sum = 0.f;
+		for (size_t i = 0; i < stride; i += kBlock) sum += dotF16Block(q + i, h + i);
+		return sum;
+	}
+	const int8_t* v = c.i8.get() + off;
+	float s0 = 0.f, s1 = 0.f, s2 = 0.f, s3 = 0.f;
+	for (size_t i = 0; i < stride; i += 4) {
+		s0 += q[i]	   * float(v[i]);
+		s1 += q[i + 1] * float(v[i + 1]);
+		s2 += q[i + 2] * float(v[i + 2]);
+		s3 += q[i + 3] * float(v[i + 3]);
+	}
+	return ((s0 + s1) + (s2 + s3)) * c.scales[static_cast<size_t>(r)];
+}
+
+void GalleryIndex::build(const std::vector<GalleryUserPtr>& gallery, Storage storage)
+{
+	clear();
+	storage_ = storage;
+	slots_.reserve(gallery.size());
+	for (const auto& u : gallery) upsert(u);
+}
+
+bool GalleryIndex::upsert(const GalleryUserPtr& u)
+{
+	if (!u || u->dim <= 0) return false;
+
+	// 차원은 첫 사용자 기준 (비어 있으면 새 차원으로), 다른 차원은 거부
+	if (live_ == 0 && u->dim != dim_) {
+		clear();
+		dim_	= u->dim;
+		stride_ = padTo(dim_, kBlock);
+	}
+	if (u->dim != dim_) {
+		qWarning() << "[GalleryIndex] dim mismatch id=" << u->id << "dim=" << u->dim;
+		return false;
+	}
+
+	// 코드 전용 블록은 그 코드를 그대로 칸에 (F32 로는 fit 이 먼저 복원해 둬야 함)
+	Slot s{ u, nullptr };
+	if (storage_ == Storage::F32) {
+		if (!u->hasRows()) {
+			qWarning() << "[GalleryIndex] code-only user in F32 index id=" << u->id;
+			return false;
+		}
+	}
+	else if (u->codes && bool(u->codes->i8) == (storage_ == Storage::I8)) {
+		s.codes = u->codes;
+	}
+	else if (!(s.codes = encodeRows(*u, storage_, false))) {
+		qWarning() << "[GalleryIndex] code alloc failed id=" << u->id;
+		return false;
+	}
+
+	if (const int* at = slotById_.find(u->id)) {
+		Slot& old = slots_.mut(static_cast<size_t>(*at));
+		rows_ += u->rows - old.user->rows;
+		old = std::move(s);
+		return true;
+	}
+	slotById_.set(u->id, slotCount());
+	slots_.push_back(std::move(s));
+	rows_ += u->rows;
+	++live_;
+	return true;
+}
+
+bool GalleryIndex::remove(int id)
+{
+	const int* at = slotById_.find(id);
+	if (!at) return false;
+
+	Slot& s = slots_.mut(static_cast<size_t>(*at));
+	rows_ -= s.user->rows;
+	s = Slot{};
+	slotById_.erase(id);
+	if (--live_ == 0) { clear(); return true; }
+
+	const int dead = slotCount() - live_;
+	if (dead > kCompactMin && dead * 4 > slotCount()) compact();
+	return true;
+}
+
+// 빈 칸을 빼고 다시 채움 (칸 인덱스가 바뀜)
+void GalleryIndex::compact()
+{
+	CowVector<Slot> kept;
+	kept.reserve(static_cast<size_t>(live_));
+	for (size_t i = 0; i < slots_.size(); ++i) {
+		const Slot& s = slots_[i];
+		if (!s.user) continue;
+		slotById_.set(s.user->id, static_cast<int>(kept.size()));
+		kept.push_back(s);
+	}
+	slots_ = std::move(kept);
+}
+
+int GalleryIndex::slotOf(int id) const
+{
+	const int* at = slotById_.find(id);
+	return at ? *at : -1;
+}
+
+int GalleryIndex::paddedDim(int dim) { return static_cast<int>(padTo(dim, kBlock)); }
+
+float GalleryIndex::dot(const float* a, const float* b, int dim)
+{
+	if (dim == kFixedDim) return dotFixed<kFixedDim>(a, b);
+	return dotPadded(a, b, static_cast<int>(padTo(dim, kBlock)));
+}
+
+bool GalleryIndex::makeQuery(const std::vector<float>& q, Query& out) const
+{
+	out.f.reset(allocAligned<float>(stride_));
+	if (!out.f) return false;
+
+	double s = 0.0;
+	for (float v : q) s += double(v) * v;
+	if (s <= 1e-24) return false;
+	const float inv = float(1.0 / std::sqrt(s));
+	for (int i = 0; i < dim_; ++i) out.f.get()[i] = q[static_cast<size_t>(i)] * inv;
+
+	if (storage_ == Storage::I8) {
+		out.q8.reset(allocAligned<int8_t>(stride_));
+		if (!out.q8) return false;
+		out.scale = quantizeI8(out.f.get(), dim_, out.q8.get());
+	}
+	return true;
+}
+
+float GalleryIndex::rowScore(const Query& q, const Slot& s, int r) const
+{
+	const size_t off = static_cast<size_t>(r) * stride_;
+	switch (storage_) {
+		case Storage::F16: {
+			const uint16_t* h = s.codes->half.get() + off;
+			if (dim_ == kFixedDim) return dotF16<kFixedDim>(q.f.get(), h);
+			float sum = 0.f;
+			for (size_t i = 0; i < stride_; i += kBlock) sum += dotF16Block(q.f.get() + i, h + i);
+			return sum;
+		}
+		case Storage::I8: {
+			const int8_t* c = s.codes->i8.get() + off;
+			int32_t d;
+			if (dim_ == kFixedDim) d = dotI8<kFixedDim>(q.q8.get(), c);
+			else {
+				d = 0;
+				for (size_t i = 0; i < stride_; i += kBlock) d += dotI8Block(q.q8.get() + i, c + i);
+			}
+			return float(d) * q.scale * s.codes->scales[static_cast<size_t>(r)];
+		}
+		default:
+			return dot(q.f.get(), s.user->row(r), dim_);
+	}
+}
+
+float GalleryIndex::approx(const Query& q, const Slot& s) const
+{
+	float best = -2.0f;
+	for (int r = 0; r < s.user->rows; ++r) best = std::max(best, rowScore(q, s, r));
+	return best;
+}
+
+// 블록의 float 행 (F32 는 approx 와 같음). 코드 전용 블록은 float 질의 x 코드 (I8 도 질의 양자화 오차 없음)
+float GalleryIndex::exact(const Query& q, const Slot& s) const
+{
+	const GalleryUser& g = *s.user;
+	float best = -2.0f;
+	if (!g.hasRows()) {
+		for (int r = 0; r < g.rows; ++r) best = std::max(best, dotCodes(q.f.get(), *s.codes, r, dim_));
+		return best;
+	}
+	for (int r = 0; r < g.rows; ++r) best = std::max(best, dot(q.f.get(), g.row(r), dim_));
+	return best;
+}
+
+void GalleryIndex::scan(const Query& q, int begin, int end, int k, Hit* best) const
+{
+	for (int u = begin; u < end; ++u) {
+		const Slot& s = slots_[static_cast<size_t>(u)];
+		if (s.user) pushHit(best, k, u, approx(q, s));
+	}
+}
+
+std::vector<GalleryIndex::Hit> GalleryIndex::rerank(const std::vector<float>& q, const std::vector<int>& users, int k) const
+{
+	std::vector<Hit> out;
+	if (empty() || k <= 0 || users.empty() || static_cast<int>(q.size()) != dim_) return out;
+	k = std::min(k, static_cast<int>(users.size()));
+
+	Query qq;
+	if (!makeQuery(q, qq)) return out;
+
+	out.assign(static_cast<size_t>(k), Hit{});
+	for (int u : users) {
+		if (u < 0 || u >= slotCount()) continue;
+		const Slot& s = slots_[static_cast<size_t>(u)];
+		if (s.user) pushHit(out.data(), k, u, exact(qq, s));
+	}
+	while (!out.empty() && out.back().row < 0) out.pop_back();
+	return out;
+}
+
+// 저장 형식 그대로 스캔한 상위 k 개
+std::vector<GalleryIndex::Hit> GalleryIndex::topKScan(const Query& q, int k) const
+{
+	const int users = slotCount();
+	std::vector<Hit> out(static_cast<size_t>(k), Hit{});
+	if (rows_ < kParallelRows) {
+		scan(q, 0, users, k, out.data());
+		return out;
+	}
+
+	// 큰 갤러리: 사용자 청크(약 1024 행)별 top-K -> 병합
+	const int chunk	  = std::max(1, static_cast<int>(1024LL * users / rows_));
+	const int nChunks = (users + chunk - 1) / chunk;
+	std::vector<Hit> partial(static_cast<size_t>(nChunks) * k);
+	cv::parallel_for_(cv::Range(0, nChunks), [&](const cv::Range& r) {
+		for (int c = r.start; c < r.end; ++c) {
+			scan(q, c * chunk, std::min(users, (c + 1) * chunk), k, partial.data() + static_cast<size_t>(c) * k);
+		}
+	});
+	for (const Hit& h : partial) {
+		if (h.row >= 0) pushHit(out.data(), k, h.row, h.sim);
+	}
+	return out;
+}
+
+std::vector<GalleryIndex::Hit> GalleryIndex::topK(const std::vector<float>& q, int k) const
+{
+	std::vector<Hit> out;
+	if (empty() || k <= 0) return out;
+	if (static_cast<int>(q.size()) != dim_) {
+		qWarning() << "[GalleryIndex] query dim" << q.size() << "!= gallery dim" << dim_;
+		return out;
+	}
+	k = std::min(k, size());
+
+	Query qq;
+	if (!makeQuery(q, qq)) return out;
+	if (storage_ == Storage::F32) return topKScan(qq, k);
+
+	// 양자화: 넉넉한 1차 후보 -> 블록 float 행으로 정확 재정렬
+	const int coarseK = std::min(size(), std::max(k, kQuantRerank));
+	out.assign(static_cast<size_t>(k), Hit{});
+	for (const Hit& h : topKScan(qq, coarseK)) {
+		if (h.row >= 0) pushHit(out.data(), k, h.row, exact(qq, slots_[static_cast<size_t>(h.row)]));
+	}
+	return out;
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <QString>
+
+#include "match/CowChunks.hpp"
+#include "match/GalleryUser.hpp"
+
+// 갤러리 검색 인덱스 (정확 탐색)
+//  - 행은 사용자 블록(GalleryUser)이 가진 L2 정규화 + 0 패딩 float 행을 그대로 가리킨다 (mmap 된 저장소 포함, 복사 없음)
+//  - 사용자당 프로토타입 여러 행, 사용자 점수 = 자기 행들 중 최대 유사도
+//  - 유사도 = 내적 1회. 128 차원은 컴파일 타임 고정 커널 (NEON / AVX2+FMA / 스칼라)
+//  - top-K 는 한 번의 스캔에서 유지, 큰 갤러리는 청크 단위 병렬 스캔 후 병합
+//  - 양자화 모드(F16/I8): 사용자별 압축 코드로 1차 스캔 -> 상위 후보만 다시 계산
+//    mmap 된 사용자는 매핑의 float 행으로 정확 재계산, 자기 버퍼 사용자는 코드 전용 블록(fit)이라 float 질의 x 코드
+//  - 사용자 칸은 COW 청크: 복사본은 칸 표만 공유하고 upsert/remove 가 닿은 청크만 새로 만든다
+//    (삭제는 빈 칸으로 남기고 일정 비율을 넘으면 압축)
+// 게시 후에는 읽기 전용: 바꿀 때는 복사본을 고쳐 새 스냅샷으로
+class GalleryIndex {
+	public:
+		// F32: 블록 float 행 그대로 / F16: 반정밀도 코드 (1/2) / I8: 행별 대칭 스케일 int8 코드 (1/4)
+		enum class Storage { F32, F16, I8 };
+
+		struct Hit {
+			int		row = -1;		// 사용자 칸 인덱스 (같은 인덱스 인스턴스 안에서만 유효)
+			float	sim = -2.0f;
+		};
+
+		static constexpr int kFixedDim	   = 128;		// 고정 커널 차원 (MobileFaceNet/SFace)
+		static constexpr int kParallelRows = 4096;		// 이 이상이면 병렬 스캔
+		static constexpr int kQuantRerank  = 8;			// 양자화 모드에서 정확 재계산할 후보 수 (k 보다 작으면 k)
+		static constexpr int kCompactMin   = 64;		// 빈 칸이 이보다 많고 1/4 을 넘으면 압축
+
+		// 사용자 블록은 공유로 잡아 둠 (gallery 벡터 자체는 유지할 필요 없음). 같은 id 는 뒤의 것
+		void build(const std::vector<GalleryUserPtr>& gallery, Storage storage = Storage::F32);
+		// 한 명 추가/교체 (같은 id 면 그 칸을 교체, 차원이 다르면 거부) / 삭제
+		bool upsert(const GalleryUserPtr& u);
+		bool remove(int id);
+		void clear();
+
+		int size() const { return live_; }			// 사용자 수
+		int slotCount() const { return static_cast<int>(slots_.size()); }		// 칸 수 (빈 칸 포함, Hit::row 범위)
+		int rows() const { return rows_; }			// 프로토타입 행 수
+		int dim() const { return dim_; }
+		bool empty() const { return live_ == 0; }
+		Storage storage() const { return storage_; }
+		size_t bytes() const;				// 검색 행 메모리 (F32: 블록 행, F16/I8: 코드 + 스케일)
+
+		int slotOf(int id) const;			// 없으면 -1
+		const GalleryUserPtr& user(int u) const { return slots_[static_cast<size_t>(u)].user; }		// 빈 칸이면 nullptr
+		int id(int u) const { return user(u)->id; }
+		const QString& name(int u) const { return user(u)->name; }
+
+		// q 는 정규화 안 된 값이어도 됨 (내부에서 정규화). 결과는 sim 내림차순, 최대 k 개
+		std::vector<Hit> topK(const std::vector<float>& q, int k) const;
+		// 지정한 사용자만 정확 점수 계산 후 상위 k 개 (근사 인덱스 후보 재정렬용)
+		std::vector<Hit> rerank(const std::vector<float>& q, const std::vector<int>& users, int k) const;
+
+		// 두 벡터의 내적 (SIMD). a/b 는 paddedDim(dim) 길이로 0 패딩돼 있어야 함 (사용자 블록 행은 항상 만족)
+		static float dot(const float* a, const float* b, int dim);
+		static int paddedDim(int dim);
+
+		// 저장 형식에 맞춘 사용자 블록 (스냅샷에 넣기 전)
+		//  F16/I8: 자기 버퍼 사용자는 코드 전용 블록으로 (float 행은 버림), mmap 사용자는 그대로
+		//  F32: 코드 전용 블록은 복원한 float 행으로
+		static GalleryUserPtr fit(const GalleryUserPtr& u, Storage storage);
+		// 코드 행 r -> float dim 개 / 정규화 + 0 패딩된 q 와 코드 행 r 의 내적 (I8 도 질의는 float)
+		static void decodeRow(const GalleryCodes& c, int r, int dim, float* dst);
+		static float dotCodes(const float* q, const GalleryCodes& c, int r, int dim);
+
+	private:
+		using FreeDeleter = GalleryCodes::FreeDeleter;
+
+		struct Slot {
+			GalleryUserPtr						user;		// 빈 칸(삭제)이면 nullptr
+			std::shared_ptr<const GalleryCodes> codes;		// F32 이면 없음 (코드 전용 사용자는 블록의 코드 공유)
+		};
+
+		// 정규화 + 패딩된 질의 (I8 은 코드/스케일도)
+		struct Query {
+			std::unique_ptr<float, FreeDeleter>	 f;
+			std::unique_ptr<int8_t, FreeDeleter> q8;
+			float								 scale = 0.f;
+		};
+		bool makeQuery(const std::vector<float>& q, Query& out) const;
+
+		void  scan(const Query& q, int begin, int end, int k, Hit* best) const;
+		float rowScore(const Query& q, const Slot& s, int r) const;	// 행 하나, 저장 형식 그대로의 점수
+		float approx(const Query& q, const Slot& s) const;		// 사용자 최대, 저장 형식 그대로
+		float exact(const Query& q, const Slot& s) const;		// 사용자 최대, 블록 float 행 (코드 전용이면 float 질의 x 코드)
+		std::vector<Hit> topKScan(const Query& q, int k) const;
+		void  compact();
+
+		Storage				 storage_ = Storage::F32;
+		CowVector<Slot>		 slots_;
+		CowIdMap<int>		 slotById_;			// 사용자 ID -> 칸
+		size_t				 stride_ = 0;		// 행 간격 (원소 개수, 32 배수 -> 모든 행 시작 정렬)
+		int					 rows_	 = 0;
+		int					 live_	 = 0;
+		int					 dim_	 = 0;
+};
@@ -0,0 +1,112 @@
+#include "match/GallerySnapshot.hpp"
+
+#include <QtCore/QDebug>
+#include <algorithm>
+
+GallerySnapshot::Ptr GallerySnapshot::build(const std::vector<GalleryUserPtr>& users, GalleryIndex::Storage storage,
+											uint64_t version, const HnswIndex* seed)
+{
+	std::shared_ptr<GallerySnapshot> s(new GallerySnapshot());
+	s->version_ = version;
+	for (const auto& u : users) {
+		if (!u) continue;
+		s->users_.set(u->id, GalleryIndex::fit(u, storage));
+		s->maxId_ = std::max(s->maxId_, u->id);
+	}
+
+	// 인덱스는 사용자 블록의 행을 그대로 가리킴 (mmap 된 저장소면 매핑 그대로, 코드 전용 블록이면 그 코드)
+	const std::vector<GalleryUserPtr> list = s->users();
+	s->index_.build(list, storage);
+	if (seed) s->ann_ = *seed;
+	s->ann_.sync(list);
+
+	s->log();
+	return s;
+}
+
+GallerySnapshot::Ptr GallerySnapshot::derive(const GallerySnapshot& prev, const GalleryDelta& delta,
+											 GalleryIndex::Storage storage)
+{
+	if (delta.clear || storage != prev.index_.storage()) {
+		std::vector<GalleryUserPtr> users;
+		if (!delta.clear) {
+			users = prev.users();
+			users.erase(std::remove_if(users.begin(), users.end(), [&] (const GalleryUserPtr& u) {
+				return std::find(delta.removes.begin(), delta.removes.end(), u->id) != delta.removes.end();
+			}), users.end());
+		}
+		users.insert(users.end(), delta.upserts.begin(), delta.upserts.end());
+		// 저장 형식만 바뀐 경우 그래프는 그대로 (벡터가 같으면 sync 가 블록만 연결)
+		return build(users, storage, prev.version_ + 1, delta.clear ? nullptr : &prev.ann_);
+	}
+
+	// 표만 복사 (청크/블록/노드는 공유) -> 바뀐 ID 만 반영
+	std::shared_ptr<GallerySnapshot> s(new GallerySnapshot());
+	s->version_ = prev.version_ + 1;
+	s->users_	= prev.users_;
+	s->index_	= prev.index_;
+	s->ann_		= prev.ann_;
+	s->maxId_	= prev.maxId_;
+
+	for (int id : delta.removes) s->remove(id);
+	for (const auto& u : delta.upserts) s->upsert(u);
+
+	s->log();
+	return s;
+}
+
+void GallerySnapshot::upsert(const GalleryUserPtr& in)
+{
+	if (!in) return;
+	// 양자화 모드면 자기 버퍼 사용자는 코드 전용으로 (float 행은 delta 와 함께 해제)
+	const GalleryUserPtr u = GalleryIndex::fit(in, index_.storage());
+	users_.set(u->id, u);
+	maxId_ = std::max(maxId_, u->id);
+	if (index_.upsert(u)) {
+		ann_.upsert(u);
+		return;
+	}
+	// 인덱스가 거부 (차원 불일치 등): 블록은 users_ 에 두되 옛 칸/노드는 지움 -> 이전 벡터로 검색되지 않게
+	index_.remove(u->id);
+	ann_.remove(u->id);
+}
+
+void GallerySnapshot::remove(int id)
+{
+	if (!users_.erase(id)) return;
+	index_.remove(id);
+	ann_.remove(id);
+
+	// 최대 ID 가 빠졌을 때만 다시 찾음
+	if (id == maxId_) {
+		maxId_ = -1;
+		users_.forEach([this] (int k, const GalleryUserPtr&) { maxId_ = std::max(maxId_, k); });
+	}
+}
+
+void GallerySnapshot::log() const
+{
+	qDebug() << "[GallerySnapshot] v" << version_ << "users=" << size()
+			 << "rows=" << index_.rows() << "bytes=" << index_.bytes() << "ann=" << ann_.size();
+}
+
+GallerySnapshot::Ptr GallerySnapshot::empty()
+{
+	static const Ptr e(new GallerySnapshot());
+	return e;
+}
+
+std::vector<GalleryUserPtr> GallerySnapshot::users() const
+{
+	std::vector<GalleryUserPtr> out;
+	out.reserve(users_.size());
+	users_.forEach([&] (int, const GalleryUserPtr& u) { out.push_back(u); });
+	std::sort(out.begin(), out.end(), [] (const GalleryUserPtr& a, const GalleryUserPtr& b) { return a->id < b->id; });
+	return out;
+}
+
+const GalleryUser* GallerySnapshot::find(int id) const
+{
+	const GalleryUserPtr* u = users_.find(id);
+	return u ? u->get() : nullptr;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "match/CowChunks.hpp"
+#include "match/GalleryIndex.hpp"
+#include "match/HnswIndex.hpp"
+
+// 직전 스냅샷 대비 변경 (바뀐 사용자만)
+struct GalleryDelta {
+	bool						clear = false;		// 먼저 전부 비움 (그 뒤 upserts)
+	std::vector<int>			removes;			// 사용자 ID
+	std::vector<GalleryUserPtr>	upserts;			// 같은 ID 면 교체
+
+	bool empty() const { return !clear && removes.empty() && upserts.empty(); }
+};
+
+// 불변 갤러리 스냅샷 (RCU)
+//  - 사용자 블록 맵 + 검색 인덱스(GalleryIndex/HNSW)를 한 버전으로 묶어 만든 뒤 다시는 바꾸지 않는다
+//  - 블록은 저장 형식에 맞춰 넣음 (GalleryIndex::fit: F16/I8 이면 자기 버퍼 사용자는 코드만 보관)
+//  - 다음 버전은 derive(): 세 구조 모두 COW 청크라 표만 공유해 복사하고 바뀐 ID 만 반영
+//    (사용자 블록, 인덱스 칸, HNSW 노드 모두 이전 버전과 공유, 닿은 청크/노드만 새로)
+//  - 쓰기 측은 새 스냅샷을 만들어 shared_ptr 를 원자적으로 교체, 읽기 측은 잡아 둔 포인터로 락 없이 사용
+//  - 이전 버전은 마지막 읽기 측이 포인터를 놓을 때 해제
+class GallerySnapshot {
+	public:
+		using Ptr = std::shared_ptr<const GallerySnapshot>;
+
+		// 전체 구성 (로드 시). seed(파일에서 로드한 그래프나 이전 버전의 HNSW)가 있으면 그 복사본에 차이만 반영
+		static Ptr build(const std::vector<GalleryUserPtr>& users, GalleryIndex::Storage storage,
+						 uint64_t version, const HnswIndex* seed = nullptr);
+		// prev + delta. 저장 형식이 바뀌었거나 clear 면 전체 구성
+		static Ptr derive(const GallerySnapshot& prev, const GalleryDelta& delta, GalleryIndex::Storage storage);
+		static Ptr empty();
+
+		GallerySnapshot(const GallerySnapshot&) = delete;
+		GallerySnapshot& operator=(const GallerySnapshot&) = delete;
+
+		uint64_t version() const { return version_; }
+		// 사용자 블록 목록 (ID 순). 매번 모아 만드는 O(N) 사본 -> 저장/목록용, 검색 경로에서는 쓰지 말 것
+		std::vector<GalleryUserPtr> users() const;
+		int size() const { return static_cast<int>(users_.size()); }
+		bool isEmpty() const { return users_.empty(); }
+		int maxId() const { return maxId_; }			// 없으면 -1
+
+		const GalleryIndex& index() const { return index_; }
+		const HnswIndex& ann() const { return ann_; }
+
+		const GalleryUser* find(int id) const;			// 없으면 nullptr
+		int indexRowOf(int id) const { return index_.slotOf(id); }		// GalleryIndex 사용자 칸, 없으면 -1
+
+	private:
+		GallerySnapshot() = default;
+
+		void upsert(const GalleryUserPtr& u);
+		void remove(int id);
+		void log() const;
+
+		uint64_t					 version_ = 0;
+		CowIdMap<GalleryUserPtr>	 users_;				// 사용자 ID -> 블록 (차원이 달라 인덱스에 못 들어간 사용자 포함)
+		GalleryIndex				 index_;
+		HnswIndex					 ann_;
+		int							 maxId_ = -1;
+};
@@ -0,0 +1,95 @@
+#include "match/GalleryUser.hpp"
+#include "match/GalleryIndex.hpp"		// paddedDim
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// 정규화 + 0 패딩 (dst 는 0 초기화돼 있음)
+void writeRow(const float* v, int dim, float* dst)
+{
+	double s = 0.0;
+	for (int i = 0; i < dim; ++i) s += double(v[i]) * v[i];
+	const float inv = s > 1e-24 ? float(1.0 / std::sqrt(s)) : 0.f;
+	for (int i = 0; i < dim; ++i) dst[i] = v[i] * inv;
+}
+
+} // namespace
+
+GalleryUserPtr GalleryUser::make(int id, const QString& name, int dim, const float* mean,
+								 const float* protos, int nProtos)
+{
+	if (dim <= 0 || !mean) return nullptr;
+	nProtos = protos ? std::max(0, nProtos) : 0;
+
+	// [평균][프로토타입...] 한 블록 (64B 정렬, 행 시작도 정렬)
+	const size_t stride = static_cast<size_t>(GalleryIndex::paddedDim(dim));
+	const size_t bytes	= (1 + static_cast<size_t>(nProtos)) * stride * sizeof(float);
+	float* buf = static_cast<float*>(std::aligned_alloc(64, bytes));
+	if (!buf) return nullptr;
+	std::memset(buf, 0, bytes);
+
+	writeRow(mean, dim, buf);
+	for (int k = 0; k < nProtos; ++k) writeRow(protos + static_cast<size_t>(k) * dim, dim, buf + (1 + k) * stride);
+
+	auto u = std::make_shared<GalleryUser>();
+	u->id		  = id;
+	u->name		  = name;
+	u->dim		  = dim;
+	u->stride	  = stride;
+	u->prototypes = nProtos > 0;
+	u->rows		  = std::max(nProtos, 1);
+	u->mean		  = buf;
+	u->data		  = nProtos > 0 ? buf + stride : buf;
+	u->owner	  = std::shared_ptr<const void>(buf, [] (const void* p) { std::free(const_cast<void*>(p)); });
+	return u;
+}
+
+GalleryUserPtr GalleryUser::make(const UserEmbedding& u)
+{
+	const int dim = static_cast<int>(u.embedding.size());
+	std::vector<float> protos;
+	int n = 0;
+	for (const auto& p : u.prototypes) {
+		if (static_cast<int>(p.size()) != dim) continue;
+		protos.insert(protos.end(), p.begin(), p.end());
+		++n;
+	}
+	return make(u.id, u.name, dim, u.embedding.data(), protos.data(), n);
+}
+
+void GalleryCodes::FreeDeleter::operator()(void* p) const { std::free(p); }
+
+void GalleryUser::copyRow(int r, float* dst) const
+{
+	if (hasRows()) {
+		std::memcpy(dst, r < 0 ? mean : row(r), static_cast<size_t>(dim) * sizeof(float));
+		return;
+	}
+	if (codes) GalleryIndex::decodeRow(*codes, r < 0 ? codes->meanRow : r, dim, dst);
+	else	   std::fill(dst, dst + dim, 0.f);
+}
+
+float GalleryUser::dotRow(const float* q, int r) const
+{
+	if (hasRows()) return GalleryIndex::dot(q, r < 0 ? mean : row(r), dim);
+	return codes ? GalleryIndex::dotCodes(q, *codes, r < 0 ? codes->meanRow : r, dim) : 0.f;
+}
+
+// 행 비교 (코드 전용 블록은 복원값, 저장소에 쓰이는 값과 같음)
+bool GalleryUser::sameVectors(const GalleryUser& o) const
+{
+	if (dim != o.dim || rows != o.rows || prototypes != o.prototypes) return false;
+	std::vector<float> a(static_cast<size_t>(dim)), b(static_cast<size_t>(dim));
+	const size_t n = a.size() * sizeof(float);
+	for (int r = -1; r < rows; ++r) {
+		copyRow(r, a.data());
+		o.copyRow(r, b.data());
+		if (std::memcmp(a.data(), b.data(), n) != 0) return false;
+	}
+	return true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <QString>
+
+#include "include/types.hpp"		// UserEmbedding
+
+// 양자화 코드 (GalleryIndex F16/I8). 행 간격 = stride, 0 패딩. I8 은 행별 대칭 스케일
+//  행 0..rows-1 = 매칭 행. 코드 전용 사용자 블록은 평균 행도 (meanRow, 프로토타입이 없으면 0 = 매칭 행)
+struct GalleryCodes {
+	struct FreeDeleter { void operator()(void* p) const; };
+
+	std::unique_ptr<uint16_t, FreeDeleter> half;
+	std::unique_ptr<int8_t, FreeDeleter>   i8;
+	std::vector<float>					   scales;
+	int									   meanRow = 0;
+};
+
+// 갤러리 사용자 한 명 (불변)
+//  - 벡터는 L2 정규화 + 0 패딩 행 (stride = GalleryIndex::paddedDim(dim)): 평균 한 행 + 매칭 행 rows 개
+//  - 행 메모리는 owner 가 보관: mmap 된 EmbeddingStore(id/이름만 만들고 행은 매핑을 그대로 가리킴)
+//    또는 make() 가 만든 자기 버퍼
+//  - 양자화 모드의 자기 버퍼 사용자는 스냅샷에 들어갈 때 코드 전용 블록으로 바뀜 (mean/data 없음, codes 만)
+//    float 행이 필요한 곳(저장/저널/HNSW)은 copyRow/dotRow 로 읽는다
+//  - 스냅샷끼리 포인터로 공유하고 바뀐 사용자만 새로 만든다
+struct GalleryUser {
+	using Ptr = std::shared_ptr<const GalleryUser>;
+
+	int			 id	 = -1;
+	QString		 name;
+	int			 dim = 0;
+	size_t		 stride = 0;
+	int			 rows = 0;					// 매칭 행 수
+	bool		 prototypes = false;		// false 면 매칭 행 = 평균 하나
+	bool		 mapped = false;			// 행이 mmap 된 저장소를 가리킴
+	const float* mean = nullptr;
+	const float* data = nullptr;			// rows x stride (코드 전용이면 nullptr)
+	std::shared_ptr<const void> owner;
+	std::shared_ptr<const GalleryCodes> codes;		// 코드 전용 블록만
+
+	const float* row(int r) const { return data + static_cast<size_t>(r) * stride; }
+	int protoCount() const { return prototypes ? rows : 0; }
+	bool hasRows() const { return data != nullptr; }
+
+	// 행 r (-1 = 평균) 을 dst 에 dim 개 (코드 전용이면 복원값)
+	void copyRow(int r, float* dst) const;
+	// 정규화 + 0 패딩된 q 와 행 r (-1 = 평균) 의 내적
+	float dotRow(const float* q, int r) const;
+
+	// 자기 버퍼로 (정규화 + 패딩). protos 는 nProtos x dim 연속 float, 정렬 불필요
+	static Ptr make(int id, const QString& name, int dim, const float* mean, const float* protos, int nProtos);
+	// dim 이 맞는 프로토타입만. embedding 이 비어 있으면 nullptr
+	static Ptr make(const UserEmbedding& u);
+
+	bool sameVectors(const GalleryUser& o) const;		// 재등록으로 벡터가 바뀌었는지 비교용
+};
+
+using GalleryUserPtr = GalleryUser::Ptr;
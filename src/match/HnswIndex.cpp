@@ -0,0 +1,541 @@
+#include "match/HnswIndex.hpp"
+#include "match/GalleryIndex.hpp"		// dot / paddedDim
+#include "match/EmbeddingStore.hpp"		// crc32c
+
+#include <QtCore/QDebug>
+#include <QFile>
+#include <QSaveFile>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <queue>
+#include <unordered_set>
+
+namespace {
+
+constexpr uint32_t kMagic	= 0x57534e48;		// "HNSW"
+constexpr uint32_t kVersion = 3;				// 2: 벡터 대신 CRC (벡터는 사용자 블록), 3: 파일 끝 전체 CRC32C
+
+// 검색별 방문 표시 (스레드별 재사용, epoch 증가로 초기화 생략)
+struct Visited {
+	std::vector<uint32_t> mark;
+	uint32_t			  epoch = 0;
+
+	void reset(size_t n)
+	{
+		if (mark.size() < n) mark.resize(n, 0);
+		if (++epoch == 0) { std::fill(mark.begin(), mark.end(), 0); epoch = 1; }
+	}
+	bool test_set(uint32_t n)
+	{
+		if (mark[n] == epoch) return true;
+		mark[n] = epoch;
+		return false;
+	}
+};
+
+Visited& visited()
+{
+	thread_local Visited v;
+	return v;
+}
+
+struct ByLower  { bool operator()(const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b) const { return a.first > b.first; } };
+struct ByHigher { bool operator()(const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b) const { return a.first < b.first; } };
+
+// 쓰면서 CRC32C 누적 (파일 끝에 한 번)
+struct CrcWriter {
+	QSaveFile& f;
+	uint32_t   crc = 0;
+
+	bool write(const char* p, qint64 n)
+	{
+		crc = EmbeddingStore::crc32c(p, static_cast<size_t>(n), crc);
+		return f.write(p, n) == n;
+	}
+	template<typename T>
+	bool pod(const T& v) { return write(reinterpret_cast<const char*>(&v), sizeof(T)); }
+};
+
+template<typename T>
+bool readPod(QFile& f, T& v) { return f.read(reinterpret_cast<char*>(&v), sizeof(T)) == sizeof(T); }
+
+} // namespace
+
+void HnswIndex::clear()
+{
+	dim_	= 0;
+	stride_ = 0;
+	nodes_.clear();
+	byLabel_.clear();
+	entry_	  = -1;
+	maxLevel_ = -1;
+	live_	  = 0;
+}
+
+
+HnswIndex::Vertex& HnswIndex::mutNode(Node n)
+{
+	auto& v = nodes_.mut(n);
+	if (v.use_count() != 1) v = std::make_shared<Vertex>(*v);
+	return *v;
+}
+
+// 저장소에 쓰이는 평균 행 기준 (코드 전용 블록은 복원값 = 다시 읽은 저장소의 행)
+uint32_t HnswIndex::rowCrc(const GalleryUser& u)
+{
+	std::vector<float> mean(static_cast<size_t>(u.dim));
+	u.copyRow(-1, mean.data());
+	return EmbeddingStore::crc32c(mean.data(), mean.size() * sizeof(float));
+}
+
+// 블록 없는 노드는 0 행
+float HnswIndex::simTo(const float* q, Node n) const
+{
+	const GalleryUserPtr& u = node(n).user;
+	return u ? u->dotRow(q, -1) : 0.f;
+}
+
+// 노드끼리: a 의 평균 행이 float 이면 그대로, 코드 전용이면 복원해서
+float HnswIndex::simNodes(Node a, Node b) const
+{
+	const GalleryUserPtr& u = node(a).user;
+	if (!u) return 0.f;
+	if (u->hasRows()) return simTo(u->mean, b);
+	thread_local std::vector<float> buf;
+	meanOf(*u, buf);
+	return simTo(buf.data(), b);
+}
+
+// 평균 행 (stride_ 개, 0 패딩)
+void HnswIndex::meanOf(const GalleryUser& u, std::vector<float>& out) const
+{
+	out.assign(stride_, 0.f);
+	u.copyRow(-1, out.data());
+}
+
+void HnswIndex::normalizeInto(const float* src, float* dst) const
+{
+	double s = 0.0;
+	for (int i = 0; i < dim_; ++i) s += double(src[i]) * src[i];
+	const float inv = s > 1e-24 ? float(1.0 / std::sqrt(s)) : 0.f;
+	for (int i = 0; i < dim_; ++i) dst[i] = src[i] * inv;
+	std::fill(dst + dim_, dst + stride_, 0.f);
+}
+
+int HnswIndex::randomLevel()
+{
+	// P(level >= l) = M^-l
+	std::uniform_real_distribution<double> u(std::numeric_limits<double>::min(), 1.0);
+	const double mult = 1.0 / std::log(double(std::max(2, p_.M)));
+	return static_cast<int>(-std::log(u(rng_)) * mult);
+}
+
+HnswIndex::Node HnswIndex::greedy(const float* q, Node ep, int level) const
+{
+	float best = simTo(q, ep);
+	for (bool moved = true; moved; ) {
+		moved = false;
+		for (Node nb : node(ep).links[static_cast<size_t>(level)]) {
+			const float s = simTo(q, nb);
+			if (s > best) { best = s; ep = nb; moved = true; }
+		}
+	}
+	return ep;
+}
+
+// 한 레벨에서 ef 개 후보 탐색. 삭제 노드도 경유는 하되 결과 판단은 호출 측
+void HnswIndex::searchLayer(const float* q, Node ep, int ef, int level, std::vector<Cand>& out) const
+{
+	Visited& vis = visited();
+	vis.reset(nodes_.size());
+
+	std::priority_queue<Cand, std::vector<Cand>, ByHigher> cand;		// 가장 가까운 것부터 확장
+	std::priority_queue<Cand, std::vector<Cand>, ByLower>  top;		// 현재 ef 개 (가장 먼 것이 top)
+
+	const float s0 = simTo(q, ep);
+	vis.test_set(ep);
+	cand.emplace(s0, ep);
+	top.emplace(s0, ep);
+
+	while (!cand.empty()) {
+		const Cand c = cand.top();
+		if (static_cast<int>(top.size()) >= ef && c.first < top.top().first) break;
+		cand.pop();
+
+		for (Node nb : node(c.second).links[static_cast<size_t>(level)]) {
+			if (vis.test_set(nb)) continue;
+			const float s = simTo(q, nb);
+			if (static_cast<int>(top.size()) < ef || s > top.top().first) {
+				cand.emplace(s, nb);
+				top.emplace(s, nb);
+				if (static_cast<int>(top.size()) > ef) top.pop();
+			}
+		}
+	}
+
+	out.clear();
+	out.reserve(top.size());
+	while (!top.empty()) { out.push_back(top.top()); top.pop(); }
+	std::reverse(out.begin(), out.end());		// sim 내림차순
+}
+
+// 휴리스틱 선택: 이미 고른 이웃보다 질의에 더 가까운 후보만 (그래프가 한 방향에 몰리지 않게)
+void HnswIndex::selectNeighbors(std::vector<Cand>& cands, int m) const
+{
+	if (static_cast<int>(cands.size()) <= m) return;
+
+	std::vector<Cand> picked;
+	picked.reserve(static_cast<size_t>(m));
+	for (const Cand& c : cands) {
+		bool keep = true;
+		for (const Cand& p : picked) {
+			if (simNodes(c.second, p.second) > c.first) { keep = false; break; }
+		}
+		if (keep) picked.push_back(c);
+		if (static_cast<int>(picked.size()) >= m) break;
+	}
+	// 너무 적게 남으면 가까운 순으로 채움
+	for (const Cand& c : cands) {
+		if (static_cast<int>(picked.size()) >= m) break;
+		if (std::find(picked.begin(), picked.end(), c) == picked.end()) picked.push_back(c);
+	}
+	cands.swap(picked);
+}
+
+// nb 의 이웃 목록에 n 추가. 넘치면 nb 기준으로 다시 선택
+void HnswIndex::link(Node n, Node nb, int level)
+{
+	auto& l = mutNode(nb).links[static_cast<size_t>(level)];
+	l.push_back(n);
+	if (static_cast<int>(l.size()) <= maxLinks(level)) return;
+
+	std::vector<Cand> c;
+	c.reserve(l.size());
+	for (Node x : l) c.emplace_back(simNodes(nb, x), x);
+	std::sort(c.begin(), c.end(), [](const Cand& a, const Cand& b) { return a.first > b.first; });
+	selectNeighbors(c, maxLinks(level));
+	l.clear();
+	for (const Cand& x : c) l.push_back(x.second);
+}
+
+bool HnswIndex::insert(const GalleryUserPtr& u)
+{
+	if (!u || u->dim <= 0) return false;
+	if (dim_ != 0 && u->dim != dim_) {
+		qWarning() << "[HnswIndex] dim mismatch label=" << u->id << u->dim << "!=" << dim_;
+		return false;
+	}
+	remove(u->id);		// 마지막 노드였다면 clear() 로 차원도 초기화됨
+	if (dim_ == 0) {
+		dim_	= u->dim;
+		stride_ = static_cast<size_t>(GalleryIndex::paddedDim(dim_));
+	}
+
+	const Node n	 = static_cast<Node>(nodes_.size());
+	const int  level = randomLevel();
+	auto v = std::make_shared<Vertex>();
+	v->label = u->id;
+	v->user	 = u;
+	v->links.resize(static_cast<size_t>(level + 1));
+	nodes_.push_back(std::move(v));
+	byLabel_.set(u->id, n);
+	++live_;
+
+	if (entry_ < 0) {
+		entry_	  = static_cast<int>(n);
+		maxLevel_ = level;
+		return true;
+	}
+
+	std::vector<float> qbuf;
+	if (!u->hasRows()) meanOf(*u, qbuf);
+	const float* q = u->hasRows() ? u->mean : qbuf.data();
+	Node ep = static_cast<Node>(entry_);
+	for (int l = maxLevel_; l > level; --l) ep = greedy(q, ep, l);
+
+	std::vector<Cand> cands;
+	for (int l = std::min(level, maxLevel_); l >= 0; --l) {
+		searchLayer(q, ep, p_.efConstruction, l, cands);
+		ep = cands.front().second;
+
+		cands.erase(std::remove_if(cands.begin(), cands.end(), [n](const Cand& c) { return c.second == n; }), cands.end());
+		selectNeighbors(cands, p_.M);
+		for (const Cand& c : cands) {
+			mutNode(n).links[static_cast<size_t>(l)].push_back(c.second);
+			link(n, c.second, l);
+		}
+	}
+
+	if (level > maxLevel_) {
+		entry_	  = static_cast<int>(n);
+		maxLevel_ = level;
+	}
+	return true;
+}
+
+bool HnswIndex::remove(int label)
+{
+	const Node* at = byLabel_.find(label);
+	if (!at) return false;
+
+	mutNode(*at).deleted = 1;
+	byLabel_.erase(label);
+	--live_;
+
+	if (live_ == 0) { clear(); return true; }
+
+	// 삭제 노드가 1/4 을 넘으면 살아 있는 노드로 재구성
+	const int dead = static_cast<int>(nodes_.size()) - live_;
+	if (dead > 64 && dead * 4 > static_cast<int>(nodes_.size())) compact();
+	else if (entry_ >= 0 && node(static_cast<Node>(entry_)).deleted) pickEntry();
+	return true;
+}
+
+// 진입점이 삭제되면 살아 있는 노드 중 가장 높은 레벨로 교체
+void HnswIndex::pickEntry()
+{
+	entry_	  = -1;
+	maxLevel_ = -1;
+	byLabel_.forEach([this] (int, Node n) {
+		const int lv = static_cast<int>(node(n).links.size()) - 1;
+		if (lv > maxLevel_) { maxLevel_ = lv; entry_ = static_cast<int>(n); }
+	});
+}
+
+// 살아 있는 노드만 다시 삽입 (블록이 없는 노드는 sync 가 다시 넣음)
+void HnswIndex::compact()
+{
+	std::vector<GalleryUserPtr> keep;
+	keep.reserve(static_cast<size_t>(live_));
+	byLabel_.forEach([&] (int, Node n) {
+		if (node(n).user) keep.push_back(node(n).user);
+	});
+	clear();
+	for (const auto& u : keep) insert(u);
+	qDebug() << "[HnswIndex] compacted live=" << live_;
+}
+
+// 이미 있는 노드에 블록만 연결/교체할 수 있으면 true (삽입이 필요하면 false)
+bool HnswIndex::bind(const GalleryUserPtr& u)
+{
+	const Node* at = byLabel_.find(u->id);
+	if (!at) return false;
+	const Node n = *at;
+	const Vertex& v = node(n);
+	if (v.user == u) return true;
+
+	// 파일에서 읽은 노드: 같은 벡터면 블록에 연결만
+	if (!v.user) {
+		if (v.crc != rowCrc(*u)) return false;
+		mutNode(n).user = u;
+		return true;
+	}
+	// 재등록(또는 다시 읽은 저장소)으로 블록이 바뀐 사용자: 벡터가 같으면 블록만 교체
+	if (u->dim != dim_) return false;
+	std::vector<float> mean;
+	meanOf(*u, mean);
+	if (v.user->dotRow(mean.data(), -1) >= 0.9999f) {
+		mutNode(n).user = u;
+		return true;
+	}
+	return false;
+}
+
+bool HnswIndex::upsert(const GalleryUserPtr& u)
+{
+	if (!u) return false;
+	return bind(u) || insert(u);
+}
+
+void HnswIndex::sync(const std::vector<GalleryUserPtr>& gallery)
+{
+	// 모델 교체 등으로 차원이 바뀌면 전부 다시
+	for (const auto& u : gallery) {
+		if (!u) continue;
+		if (dim_ != 0 && u->dim != dim_) clear();
+		break;
+	}
+
+	std::unordered_set<int> present;
+	std::vector<GalleryUserPtr> pending;		// 새로 넣거나 다시 넣을 사용자
+	int changed = 0, removed = 0, bound = 0;
+
+	// 1) 기존 노드에 블록부터 연결 (삽입 중 탐색이 0 벡터 노드를 지나지 않게)
+	for (const auto& u : gallery) {
+		if (!u) continue;
+		present.insert(u->id);
+
+		const Node* at = byLabel_.find(u->id);
+		const bool unbound = at && !node(*at).user;
+		if (bind(u)) {
+			if (unbound) ++bound;
+			continue;
+		}
+		if (at) ++changed;
+		pending.push_back(u);
+	}
+
+	// 2) 빠진 사용자 삭제
+	std::vector<int> gone;
+	byLabel_.forEach([&] (int label, Node) {
+		if (!present.count(label)) gone.push_back(label);
+	});
+	for (int label : gone) { remove(label); ++removed; }
+
+	// 3) 삽입 (insert 가 같은 라벨의 옛 노드를 지움)
+	for (const auto& u : pending) insert(u);
+	const int added = static_cast<int>(pending.size()) - changed;
+
+	if (added || changed || removed || bound) {
+		qDebug() << "[HnswIndex] sync live=" << live_ << "added=" << added << "changed=" << changed
+				 << "removed=" << removed << "bound=" << bound;
+	}
+}
+
+std::vector<HnswIndex::Hit> HnswIndex::search(const std::vector<float>& q, int k) const
+{
+	std::vector<Hit> out;
+	if (entry_ < 0 || k <= 0 || static_cast<int>(q.size()) != dim_) return out;
+
+	std::vector<float> qn(stride_);
+	normalizeInto(q.data(), qn.data());
+
+	Node ep = static_cast<Node>(entry_);
+	for (int l = maxLevel_; l > 0; --l) ep = greedy(qn.data(), ep, l);
+
+	std::vector<Cand> cands;
+	searchLayer(qn.data(), ep, std::max(p_.efSearch, k), 0, cands);
+
+	for (const Cand& c : cands) {
+		const Vertex& v = node(c.second);
+		if (v.deleted) continue;
+		out.push_back({ v.label, c.first });
+		if (static_cast<int>(out.size()) >= k) break;
+	}
+	return out;
+}
+
+// [magic][version][dim][M][maxLevel][entry][nodes] [node...] [fileCrc]
+//  node: [label][deleted][levels][crc] { [count][ids...] } x levels   (벡터는 사용자 블록, crc 는 연결 확인용)
+//  fileCrc: 앞의 전체 바이트 CRC32C
+bool HnswIndex::save(const std::string& path) const
+{
+	QSaveFile f(QString::fromStdString(path));
+	if (!f.open(QIODevice::WriteOnly)) {
+		qWarning() << "[HnswIndex] open failed:" << QString::fromStdString(path);
+		return false;
+	}
+
+	CrcWriter w{ f };
+	const uint32_t nodes = static_cast<uint32_t>(nodes_.size());
+	bool ok = w.pod(kMagic) && w.pod(kVersion)
+		   && w.pod(int32_t(dim_)) && w.pod(int32_t(p_.M))
+		   && w.pod(int32_t(maxLevel_)) && w.pod(int32_t(entry_)) && w.pod(nodes);
+
+	for (uint32_t n = 0; ok && n < nodes; ++n) {
+		const Vertex& v = node(n);
+		const uint32_t crc = v.user ? rowCrc(*v.user) : v.crc;
+		ok = w.pod(int32_t(v.label)) && w.pod(v.deleted)
+		  && w.pod(uint32_t(v.links.size())) && w.pod(crc);
+		for (const auto& l : v.links) {
+			if (!ok) break;
+			const qint64 lb = qint64(l.size() * sizeof(Node));
+			ok = w.pod(uint32_t(l.size())) && (lb == 0 || w.write(reinterpret_cast<const char*>(l.data()), lb));
+		}
+	}
+	const uint32_t fileCrc = w.crc;
+	ok = ok && f.write(reinterpret_cast<const char*>(&fileCrc), sizeof(fileCrc)) == sizeof(fileCrc);
+
+	if (!ok) {
+		f.cancelWriting();
+		qWarning() << "[HnswIndex] write failed:" << QString::fromStdString(path);
+		return false;
+	}
+	return f.commit();
+}
+
+// 그래프만 읽음. 노드 벡터는 다음 sync 에서 사용자 블록에 연결될 때까지 0 행
+//  전체 CRC + 그래프 불변식(이웃 id 범위, 레벨 l 이웃은 l 보다 높은 레벨까지 있음, 진입점 레벨 = maxLevel)을
+//  확인하고 하나라도 어긋나면 false -> 호출 측이 갤러리에서 새로 구성 (greedy/searchLayer 의 links[level] 범위 보장)
+bool HnswIndex::load(const std::string& path)
+{
+	QFile f(QString::fromStdString(path));
+	if (!f.open(QIODevice::ReadOnly)) return false;
+
+	const auto corrupt = [&] (const char* why) {
+		qWarning() << "[HnswIndex]" << why << "-> ignore (rebuild)" << QString::fromStdString(path);
+		return false;
+	};
+
+	const QByteArray all = f.readAll();
+	uint32_t fileCrc = 0;
+	if (all.size() < qint64(sizeof(fileCrc))) return corrupt("truncated");
+	const size_t body = static_cast<size_t>(all.size()) - sizeof(fileCrc);
+	std::memcpy(&fileCrc, all.constData() + body, sizeof(fileCrc));
+	if (EmbeddingStore::crc32c(all.constData(), body) != fileCrc) return corrupt("crc mismatch");
+	if (!f.seek(0)) return false;
+
+	uint32_t magic = 0, version = 0, nodes = 0;
+	int32_t dim = 0, m = 0, maxLevel = -1, entry = -1;
+	if (!readPod(f, magic) || magic != kMagic || !readPod(f, version) || version != kVersion
+		|| !readPod(f, dim) || !readPod(f, m) || !readPod(f, maxLevel) || !readPod(f, entry) || !readPod(f, nodes)
+		|| dim <= 0 || m != p_.M) {
+		qWarning() << "[HnswIndex] header mismatch -> ignore" << QString::fromStdString(path);
+		return false;
+	}
+
+	HnswIndex tmp(p_);
+	tmp.dim_	= dim;
+	tmp.stride_ = static_cast<size_t>(GalleryIndex::paddedDim(dim));
+	tmp.nodes_.reserve(nodes);
+
+	for (uint32_t n = 0; n < nodes; ++n) {
+		auto vp = std::make_shared<Vertex>();
+		Vertex& v = *vp;
+		tmp.nodes_.push_back(std::move(vp));
+		int32_t label = -1;
+		uint32_t levels = 0;
+		if (!readPod(f, label) || !readPod(f, v.deleted) || !readPod(f, levels) || levels == 0 || levels > 64
+			|| !readPod(f, v.crc)) return corrupt("bad node");
+
+		v.label = label;
+		v.links.resize(levels);
+		for (auto& l : v.links) {
+			uint32_t cnt = 0;
+			if (!readPod(f, cnt) || cnt > nodes) return corrupt("bad link count");
+			l.resize(cnt);
+			const qint64 lb = qint64(cnt * sizeof(Node));
+			if (lb && f.read(reinterpret_cast<char*>(l.data()), lb) != lb) return corrupt("truncated links");
+			for (Node x : l) if (x >= nodes) return corrupt("link out of range");
+		}
+		if (!v.deleted) {
+			if (tmp.byLabel_.find(label)) return corrupt("duplicate live label");	// remove/bind 가 어느 노드인지 모름
+			tmp.byLabel_.set(label, n);
+			++tmp.live_;
+		}
+	}
+	if (f.pos() != qint64(body)) return corrupt("trailing bytes");
+	if (entry >= int32_t(nodes) || (nodes > 0 && entry < 0)) return corrupt("bad entry");
+	if (nodes > 0 && maxLevel != int32_t(tmp.node(static_cast<Node>(entry)).links.size()) - 1) {
+		return corrupt("maxLevel != entry level");
+	}
+	// 레벨 l 의 이웃은 레벨 l 이 있는 노드여야 함 (탐색이 그 노드의 links[l] 을 읽음)
+	for (uint32_t n = 0; n < nodes; ++n) {
+		const Vertex& v = tmp.node(n);
+		for (size_t l = 0; l < v.links.size(); ++l) {
+			for (Node x : v.links[l]) {
+				if (tmp.node(x).links.size() <= l) return corrupt("link to lower-level node");
+			}
+		}
+	}
+	tmp.entry_	  = entry;
+	tmp.maxLevel_ = maxLevel;
+	if (tmp.live_ == 0) tmp.clear();
+	else if (tmp.node(static_cast<Node>(entry)).deleted) tmp.pickEntry();
+
+	*this = std::move(tmp);
+	qInfo() << "[HnswIndex] loaded live=" << live_ << "nodes=" << nodes << "from" << QString::fromStdString(path);
+	return true;
+}
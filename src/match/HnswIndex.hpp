@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "match/CowChunks.hpp"
+#include "match/GalleryUser.hpp"
+
+// 근사 최근접 탐색 인덱스 (HNSW, 내적 = 코사인)
+//  - 사용자 등록/삭제 시 증분 삽입/삭제 (삭제는 표시만 하고 일정 비율 넘으면 압축 재구성)
+//  - 노드 벡터 = 사용자 블록의 평균 행 (블록을 잡아 둘 뿐 복사하지 않음, 코드 전용 블록은 코드로 계산)
+//  - 결과는 근사 후보. 최종 점수는 호출 측(FaceMatcher)에서 GalleryIndex 로 정확 재계산
+//  - 바이너리 파일로 저장/로드 (임베딩 파일 옆). 파일에는 그래프와 노드별 벡터 CRC 만 두고
+//    로드 후 sync 가 같은 label + 같은 CRC 의 사용자 블록에 연결 (어긋난 노드는 삭제 처리 후 다시 삽입)
+//  - 노드 표와 label 맵은 COW 청크, 노드는 shared_ptr: 복사본은 표만 공유하고
+//    삽입/삭제가 건드린 노드(새 노드 + 이웃 목록이 바뀐 노드)와 그 청크만 새로 만든다
+// 동기화 없음: 갱신과 검색을 같은 시점에 호출하지 말 것 (스냅샷에서는 복사본을 고친 뒤 게시)
+class HnswIndex {
+	public:
+		struct Params {
+			int M				= 16;		// 노드당 이웃 수 (레벨 0 은 2M)
+			int efConstruction	= 100;		// 삽입 시 후보 폭
+			int efSearch		= 64;		// 검색 시 후보 폭 (k 보다 작으면 k)
+		};
+
+		struct Hit {
+			int		label = -1;				// 사용자 ID
+			float	sim	  = -2.0f;
+		};
+
+		HnswIndex() = default;
+		explicit HnswIndex(const Params& p) : p_(p) {}
+
+		void clear();
+
+		// 같은 label 이 있으면 교체 (벡터 = u->mean)
+		bool insert(const GalleryUserPtr& u);
+		bool remove(int label);
+		// 한 명 반영: 같은 벡터면 블록만 연결/교체, 아니면 insert
+		bool upsert(const GalleryUserPtr& u);
+
+		// 갤러리 전체와 비교해 추가/변경/삭제된 사용자만 반영 (로드한 노드는 여기서 블록에 연결)
+		//  O(N): 로드 직후 한 번. 이후 변경은 upsert/remove 로
+		void sync(const std::vector<GalleryUserPtr>& gallery);
+
+		std::vector<Hit> search(const std::vector<float>& q, int k) const;
+
+		int size() const { return live_; }
+		int dim() const { return dim_; }
+
+		bool save(const std::string& path) const;
+		bool load(const std::string& path);
+
+	private:
+		using Node = uint32_t;
+		using Cand = std::pair<float, Node>;		// (sim, node)
+
+		// 노드 하나: 로드 직후(연결 전)나 연결 실패 노드는 user 가 없고 벡터는 0 행 (simTo = 0)
+		struct Vertex {
+			int			   label	= -1;
+			uint8_t		   deleted	= 0;
+			uint32_t	   crc		= 0;		// 평균 행 CRC (파일에서 읽은 노드 연결용)
+			GalleryUserPtr user;
+			std::vector<std::vector<Node>> links;		// [level] -> 이웃
+		};
+
+		const Vertex& node(Node n) const { return *nodes_[n]; }
+		Vertex& mutNode(Node n);				// 공유 중인 노드면 복사 후 교체
+		float simTo(const float* q, Node n) const;
+		float simNodes(Node a, Node b) const;
+		void meanOf(const GalleryUser& u, std::vector<float>& out) const;
+		void normalizeInto(const float* src, float* dst) const;
+		static uint32_t rowCrc(const GalleryUser& u);
+		int  maxLinks(int level) const { return level == 0 ? 2 * p_.M : p_.M; }
+		int  randomLevel();
+
+		Node greedy(const float* q, Node ep, int level) const;
+		void searchLayer(const float* q, Node ep, int ef, int level, std::vector<Cand>& out) const;
+		void selectNeighbors(std::vector<Cand>& cands, int m) const;		// cands: sim 내림차순
+		void link(Node n, Node nb, int level);
+		bool bind(const GalleryUserPtr& u);
+		void pickEntry();
+		void compact();
+
+		Params				p_;
+		int					dim_	= 0;
+		size_t				stride_ = 0;
+		CowVector<std::shared_ptr<Vertex>> nodes_;
+		CowIdMap<Node>		byLabel_;					// 살아 있는 노드만
+		int					entry_	  = -1;
+		int					maxLevel_ = -1;
+		int					live_	  = 0;
+		std::mt19937		rng_{0x5eed};
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "include/types.hpp"		// FaceDet
+#include "include/states.hpp"		// DetectedStatus
+#include "capture/V4l2Capture.hpp"	// CapturedFrame
+#include "liveness/TemporalLiveness.hpp"	// LiveVerdict
+
+// 파이프라인 스테이지 사이를 흐르는 프레임 단위 작업
+//  capture -> detect(검출/정렬/품질) -> embed(임베딩/매칭/판정/표시)
+struct FrameJob {
+	uint64_t		seq			= 0;		// 캡처 순번
+	int64_t			tsMs		= 0;		// 캡처 시각 (CLOCK_MONOTONIC ms, 간격 계산 전용 - 벽시계 아님)
+
+	CapturedFrame	raw;					// 캡처 원본 버퍼 참조 (인증 로그 스냅샷, 커널 타임스탬프)
+	cv::Mat			frame;					// BGR 프레임 (오버레이/프리뷰용, YUYV 입력은 embed 스테이지에서 생성)
+	float			previewScale = 1.0f;	// frame 좌표 = 원본 좌표 * previewScale (MJPEG 축소 프리뷰)
+
+	bool			wantReg		= false;	// 캡처 시점의 등록 모드 여부
+	bool			holdDetect	= false;	// 쿨다운 중 -> 검출 생략
+
+	// detect 스테이지 결과 (face.embedding 은 embed 스테이지에서 채움)
+	bool			hasFace		= false;
+	FaceSample		face;
+	DetectedStatus	status		= DetectedStatus::FaceNotDetected;
+	LiveVerdict		live		= LiveVerdict::Pending;		// 시간축 라이브니스 (인식 모드에서만)
+
+	// FrameSelector 가 이번에 고른 임베딩 대상 (이 프레임 또는 같은 트랙의 직전 후보, 없으면 비어 있음)
+	//  face 는 항상 현재 프레임 (박스/오버레이용)
+	FaceSample		pick;
+	float			pickScore	= -1.0f;
+
+	bool needsEmbedding() const {
+		return hasFace && !wantReg && status == DetectedStatus::FaceDetected
+			&& !pick.empty() && !pick.hasEmbedding();
+	}
+};
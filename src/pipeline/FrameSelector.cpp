@@ -0,0 +1,104 @@
+#include "pipeline/FrameSelector.hpp"
+#include <QtCore/QDebug>
+#include <algorithm>
+#include <cmath>
+
+void FrameSelector::reset()
+{
+	cands_.clear();
+	trackId_	 = -1;
+	windowStart_ = 0;
+	lastPick_	 = 0;
+	lastTs_		 = 0;
+}
+
+// 검출 0.25 + 선명도 0.35 + 정면도 0.25 + 크기 0.15
+//  정면도: 코의 눈 중점 대비 가로 치우침(요) + 눈 선 기울기(롤)
+float FrameSelector::score(const FaceDet& fd, double blurVar) const
+{
+	const cv::Point2f& le = fd.lmk[0];
+	const cv::Point2f& re = fd.lmk[1];
+	const cv::Point2f  eye = (le + re) * 0.5f;
+	const float iod = std::hypot(re.x - le.x, re.y - le.y);
+
+	float pose = 0.0f;
+	if (iod > 1.0f) {
+		const float yaw	 = std::abs(fd.lmk[2].x - eye.x) / iod;		// 정면 0, 크게 돌리면 ~0.3
+		const float roll = std::abs(std::atan2(re.y - le.y, re.x - le.x));
+		pose = std::clamp(1.0f - 2.5f * yaw - roll / 0.6f, 0.0f, 1.0f);
+	}
+	const float sharp = static_cast<float>(std::min(1.0, blurVar / opt_.sharpBlurVar));
+	const float size  = std::min(1.0f, static_cast<float>(fd.box.width) / opt_.fullFacePx);
+	const float det	  = std::clamp(fd.score, 0.0f, 1.0f);
+
+	return 0.25f * det + 0.35f * sharp + 0.25f * pose + 0.15f * size;
+}
+
+float FrameSelector::effective(const Candidate& c, int64_t nowMs) const
+{
+	const int64_t age = std::max<int64_t>(0, nowMs - c.tsMs);
+	return c.score - opt_.agePenalty * static_cast<float>(age) / 1000.0f;
+}
+
+float FrameSelector::take(Candidate&& c, FaceSample& pick, int64_t nowMs)
+{
+	const float sc = c.score;			// c 는 cands_ 의 원소일 수 있음 -> clear 전에 꺼냄
+	pick	  = std::move(c.face);
+	lastPick_ = nowMs;
+	cands_.clear();
+	++stats_.picked;
+	if (stats_.picked % 100 == 0) {
+		qDebug() << "[FrameSelector] offered=" << stats_.offered << "picked=" << stats_.picked
+				 << "immediate=" << stats_.immediate;
+	}
+	return sc;
+}
+
+float FrameSelector::offer(const FaceDet& fd, double blurVar, int64_t tsMs,
+						   const FaceSample& face, FaceSample& pick)
+{
+	++stats_.offered;
+	if (fd.trackId != trackId_) {
+		cands_.clear();
+		trackId_ = fd.trackId;
+	}
+
+	// 시각이 뒤로 갔으면 (시계 기준이 바뀐 카메라 재시작 등) 기준 시각을 지금으로:
+	//  음수 간격으로 선택이 시계가 따라잡을 때까지 막히지 않게
+	if (tsMs < lastTs_) {
+		cands_.clear();
+		lastPick_ = std::min(lastPick_, tsMs - opt_.minIntervalMs);
+	}
+	lastTs_ = tsMs;
+
+	Candidate c{ score(fd, blurVar), tsMs, face };
+	const bool spaced = tsMs - lastPick_ >= opt_.minIntervalMs;
+
+	// 충분히 좋은 프레임은 바로
+	if (spaced && c.score >= opt_.highScore) {
+		++stats_.immediate;
+		return take(std::move(c), pick, tsMs);
+	}
+
+	// 오래된 후보 정리 후 상위 K 유지 (가득 차면 현재 기준 가장 낮은 후보와 교체)
+	cands_.erase(std::remove_if(cands_.begin(), cands_.end(),
+			[&] (const Candidate& o) { return tsMs - o.tsMs > opt_.maxAgeMs; }), cands_.end());
+	if (cands_.empty()) windowStart_ = tsMs;
+
+	if (static_cast<int>(cands_.size()) < std::max(1, opt_.topK)) {
+		cands_.push_back(std::move(c));
+	}
+	else {
+		auto worst = std::min_element(cands_.begin(), cands_.end(),
+				[&] (const Candidate& a, const Candidate& b) { return effective(a, tsMs) < effective(b, tsMs); });
+		if (effective(*worst, tsMs) < c.score) *worst = std::move(c);
+	}
+
+	// 주기가 차면 나이 감점 반영한 최고 후보 하나
+	if (spaced && tsMs - windowStart_ >= opt_.periodMs) {
+		auto best = std::max_element(cands_.begin(), cands_.end(),
+				[&] (const Candidate& a, const Candidate& b) { return effective(a, tsMs) < effective(b, tsMs); });
+		return take(std::move(*best), pick, tsMs);
+	}
+	return -1.0f;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "include/types.hpp"		// FaceDet, FaceSample
+
+// 품질 순 프레임 선택 (임베딩할 프레임 고르기)
+//  - 품질 게이트를 통과한 얼굴마다 점수 = 검출 점수 + 선명도 + 정면도 + 크기 (0..1)
+//  - 트랙별 상위 K 후보만 보관, periodMs 마다 그중 최고(오래된 후보는 감점) 하나만 임베딩으로
+//  - 점수가 highScore 이상이면 주기를 기다리지 않고 바로 (단 minIntervalMs 간격은 지킴)
+//  - 트랙이 바뀌면 후보를 버리고 새로 시작
+//  - 고른 프레임이 embed 큐에서 밀려 버려지면 그 주기는 건너뜀 (다음 주기에 다시 고름)
+// detect 스테이지 스레드 전용 (동기화 없음)
+class FrameSelector {
+	public:
+		struct Options {
+			int		topK		  = 3;			// 트랙별 후보 수
+			int		periodMs	  = 300;		// 최소 이 주기로 최고 후보 하나를 내보냄
+			int		minIntervalMs = 120;		// 연속 선택 최소 간격 (인증 streak 간격과 맞춤)
+			float	highScore	  = 0.85f;		// 이 점수 이상이면 즉시 선택
+			float	agePenalty	  = 0.5f;		// 후보 나이 1초당 감점
+			int		maxAgeMs	  = 600;		// 이보다 오래된 후보는 버림
+
+			// 점수 정규화 기준
+			double	sharpBlurVar  = 150.0;		// Laplacian 분산이 이 이상이면 선명도 만점
+			int		fullFacePx	  = 160;		// 박스 폭이 이 이상이면 크기 만점
+		};
+
+		struct Stats {
+			uint64_t offered   = 0;			// 들어온 후보 수
+			uint64_t picked	   = 0;			// 임베딩으로 보낸 수
+			uint64_t immediate = 0;			// 그중 highScore 즉시 선택
+		};
+
+		FrameSelector() = default;
+		explicit FrameSelector(const Options& opt) : opt_(opt) {}
+
+		void setOptions(const Options& opt) { opt_ = opt; reset(); }
+		void reset();
+
+		// 0..1 품질 점수 (blurVar: LivenessGate 의 FaceStats::blurVar)
+		float score(const FaceDet& fd, double blurVar) const;
+
+		// 후보 하나를 넣는다. 이번에 임베딩할 얼굴이 정해지면 pick 에 채우고 그 점수를 반환, 아니면 -1
+		//  pick 은 이 프레임일 수도, 같은 트랙의 직전 후보일 수도 있음
+		float offer(const FaceDet& fd, double blurVar, int64_t tsMs, const FaceSample& face, FaceSample& pick);
+
+		const Stats& stats() const { return stats_; }
+
+	private:
+		struct Candidate {
+			float		score = 0.0f;
+			int64_t		tsMs  = 0;
+			FaceSample	face;
+		};
+
+		float effective(const Candidate& c, int64_t nowMs) const;
+		float take(Candidate&& c, FaceSample& pick, int64_t nowMs);
+
+		Options					opt_;
+		std::vector<Candidate>	cands_;
+		int						trackId_	 = -1;
+		int64_t					windowStart_ = 0;		// 현재 후보 묶음의 첫 후보 시각
+		int64_t					lastPick_	 = 0;
+		int64_t					lastTs_		 = 0;		// 직전 offer 시각 (뒤로 간 시계 감지)
+		Stats					stats_;
+};
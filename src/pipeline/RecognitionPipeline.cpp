@@ -0,0 +1,198 @@
+#include "pipeline/RecognitionPipeline.hpp"
+
+#include <QtCore/QDebug>
+#include <QDateTime>
+#include <chrono>
+#include <exception>
+
+namespace {
+inline int64_t nowUs() {
+	using namespace std::chrono;
+	return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+constexpr std::chrono::milliseconds kIdleWait{20};		// 입력 없을 때 최대 대기
+} // namespace
+
+RecognitionPipeline::~RecognitionPipeline()
+{
+	stop();
+}
+
+bool RecognitionPipeline::start(Stages stages, const Options& opt)
+{
+	if (running()) {
+		qDebug() << "[Pipeline] start() ignored: already running";
+		return false;
+	}
+	if (!stages.capture || !stages.detect || !stages.embed) {
+		qWarning() << "[Pipeline] start() failed: stage callback missing";
+		return false;
+	}
+
+	stages_ = std::move(stages);
+	opt_    = opt;
+	detectQ_ = std::make_unique<StageQueue<FrameJob>>(opt_.detectQueue);
+	embedQ_  = std::make_unique<StageQueue<FrameJob>>(opt_.embedQueue);
+	seq_ = 0;
+	lastLogMs_ = QDateTime::currentMSecsSinceEpoch();
+
+	running_.store(true, std::memory_order_release);
+
+	// 역순으로 띄워서 소비자가 먼저 대기하도록
+	embTh_ = spawn("PipeEmbed",	  [this] { embedLoop(); },	 QThread::InheritPriority);
+	detTh_ = spawn("PipeDetect",  [this] { detectLoop(); },	 QThread::InheritPriority);
+	capTh_ = spawn("PipeCapture", [this] { captureLoop(); }, opt_.capturePriority);
+
+	qInfo() << "[Pipeline] started detectQ=" << detectQ_->capacity()
+			<< "embedQ=" << embedQ_->capacity();
+	return true;
+}
+
+void RecognitionPipeline::stop()
+{
+	if (!running_.exchange(false, std::memory_order_acq_rel)) return;
+
+	if (detectQ_) detectQ_->wakeAll();
+	if (embedQ_)  embedQ_->wakeAll();
+
+	// 생산자부터 정리 (capture -> detect -> embed)
+	join(capTh_);
+	join(detTh_);
+	join(embTh_);
+
+	// 남은 프레임 참조 해제
+	if (detectQ_) detectQ_->reset();
+	if (embedQ_)  embedQ_->reset();
+
+	qInfo() << "[Pipeline] stopped";
+}
+
+QThread* RecognitionPipeline::spawn(const char* name, std::function<void()> body, QThread::Priority prio)
+{
+	QThread* th = QThread::create(std::move(body));
+	th->setObjectName(QString::fromLatin1(name));
+	th->start(prio);
+	return th;
+}
+
+void RecognitionPipeline::join(QThread*& th)
+{
+	if (!th) return;
+	th->wait();
+	delete th;
+	th = nullptr;
+}
+
+void RecognitionPipeline::captureLoop()
+{
+	qDebug() << "[Pipeline] capture thread enter";
+	while (running()) {
+		try {
+			FrameJob job;
+			const int64_t t0 = nowUs();
+			if (!stages_.capture(job)) continue;
+			capCnt_.add(static_cast<uint64_t>(nowUs() - t0));
+
+			job.seq = ++seq_;
+			if (job.tsMs == 0) job.tsMs = nowUs() / 1000;		// 커널 타임스탬프 없음(폴백 경로) -> 같은 단조 시계
+			detectQ_->pushLatest(std::move(job));
+		}
+		catch (const std::exception& e) {
+			qWarning() << "[Pipeline] capture exception:" << e.what();
+		}
+	}
+	qDebug() << "[Pipeline] capture thread exit";
+}
+
+void RecognitionPipeline::detectLoop()
+{
+	qDebug() << "[Pipeline] detect thread enter";
+	while (running()) {
+		if (!detectQ_->waitNonEmpty(kIdleWait)) continue;
+
+		FrameJob job;
+		if (!detectQ_->popLatest(job)) continue;
+
+		try {
+			const int64_t t0 = nowUs();
+			stages_.detect(job);
+			detCnt_.add(static_cast<uint64_t>(nowUs() - t0));
+		}
+		catch (const std::exception& e) {
+			qWarning() << "[Pipeline] detect exception:" << e.what();
+			continue;
+		}
+		embedQ_->pushLatest(std::move(job));
+	}
+	qDebug() << "[Pipeline] detect thread exit";
+}
+
+void RecognitionPipeline::embedLoop()
+{
+	qDebug() << "[Pipeline] embed thread enter";
+	while (running()) {
+		if (!embedQ_->waitNonEmpty(kIdleWait)) continue;
+
+		FrameJob job;
+		if (!embedQ_->popLatest(job)) continue;
+
+		try {
+			const int64_t t0 = nowUs();
+			stages_.embed(job);
+			embCnt_.add(static_cast<uint64_t>(nowUs() - t0));
+		}
+		catch (const std::exception& e) {
+			qWarning() << "[Pipeline] embed exception:" << e.what();
+		}
+
+		maybeLogStats();
+	}
+	qDebug() << "[Pipeline] embed thread exit";
+}
+
+RecognitionPipeline::StageStats RecognitionPipeline::makeStats(const Counter& c)
+{
+	StageStats s;
+	s.processed = c.processed.load(std::memory_order_relaxed);
+	const uint64_t busy = c.busyUs.load(std::memory_order_relaxed);
+	s.avgMs = (s.processed > 0) ? (busy / 1000.0) / double(s.processed) : 0.0;
+	return s;
+}
+
+RecognitionPipeline::Stats RecognitionPipeline::stats() const
+{
+	Stats st;
+	st.capture = makeStats(capCnt_);
+	st.detect  = makeStats(detCnt_);
+	st.embed   = makeStats(embCnt_);
+
+	if (detectQ_) {
+		st.detect.depth    = detectQ_->depth();
+		st.detect.capacity = detectQ_->capacity();
+		st.detect.dropped  = detectQ_->dropped();
+	}
+	if (embedQ_) {
+		st.embed.depth     = embedQ_->depth();
+		st.embed.capacity  = embedQ_->capacity();
+		st.embed.dropped   = embedQ_->dropped();
+	}
+	return st;
+}
+
+void RecognitionPipeline::maybeLogStats()
+{
+	if (opt_.statsLogMs <= 0) return;
+
+	const int64_t now = QDateTime::currentMSecsSinceEpoch();
+	if (now - lastLogMs_ < opt_.statsLogMs) return;
+	lastLogMs_ = now;
+
+	const Stats st = stats();
+	qInfo().noquote() << QString("[Pipeline] cap=%1(%2ms) | det=%3(%4ms) q=%5/%6 drop=%7"
+								 " | emb=%8(%9ms) q=%10/%11 drop=%12")
+		.arg(st.capture.processed).arg(st.capture.avgMs, 0, 'f', 1)
+		.arg(st.detect.processed).arg(st.detect.avgMs, 0, 'f', 1)
+		.arg(st.detect.depth).arg(st.detect.capacity).arg(st.detect.dropped)
+		.arg(st.embed.processed).arg(st.embed.avgMs, 0, 'f', 1)
+		.arg(st.embed.depth).arg(st.embed.capacity).arg(st.embed.dropped);
+}
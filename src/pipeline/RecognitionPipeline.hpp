@@ -0,0 +1,97 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <QThread>
+
+#include "pipeline/FrameJob.hpp"
+#include "pipeline/StageQueue.hpp"
+
+// capture -> detect -> embed 3단 파이프라인 엔진
+//  - 스테이지마다 전용 스레드, 스테이지 사이는 lock-free bounded 큐 (latest-frame-wins)
+//  - 스테이지 본문은 서비스가 콜백으로 공급 (엔진은 스레드/큐/통계만 담당)
+class RecognitionPipeline {
+	public:
+		struct Stages {
+			std::function<bool(FrameJob&)> capture;		// false = 이번엔 프레임 없음
+			std::function<void(FrameJob&)> detect;		// 검출 + 정렬 + 품질 게이트
+			std::function<void(FrameJob&)> embed;		// 임베딩 + 매칭 + 판정 + 표시
+		};
+
+		struct Options {
+			size_t detectQueue	= 2;		// capture -> detect 큐 크기
+			size_t embedQueue	= 2;		// detect  -> embed  큐 크기
+			int    statsLogMs	= 5000;		// 통계 로그 주기 (0 = 끔)
+
+			// 캡처는 드라이버 버퍼를 제때 돌려줘야 프레임이 안 밀림 -> 기존 캡처 스레드와 같은 우선순위
+			QThread::Priority capturePriority = QThread::TimeCriticalPriority;
+		};
+
+		struct StageStats {
+			uint64_t processed	= 0;		// 스테이지가 처리한 작업 수
+			uint64_t dropped	= 0;		// 입력 큐에서 버려진 작업 수
+			size_t   depth		= 0;		// 현재 입력 큐 깊이
+			size_t   capacity	= 0;		// 입력 큐 용량
+			double   avgMs		= 0.0;		// 작업당 평균 처리 시간
+		};
+
+		struct Stats {
+			StageStats capture;
+			StageStats detect;
+			StageStats embed;
+		};
+
+		RecognitionPipeline() = default;
+		~RecognitionPipeline();
+
+		RecognitionPipeline(const RecognitionPipeline&) = delete;
+		RecognitionPipeline& operator=(const RecognitionPipeline&) = delete;
+
+		bool start(Stages stages, const Options& opt);
+		bool start(Stages stages) { return start(std::move(stages), Options{}); }
+		void stop();
+		bool running() const { return running_.load(std::memory_order_acquire); }
+
+		Stats stats() const;
+
+	private:
+		// 스테이지별 누적 카운터 (스레드 1개가 쓰고 누구나 읽음)
+		struct Counter {
+			std::atomic<uint64_t> processed{0};
+			std::atomic<uint64_t> busyUs{0};
+			void add(uint64_t us) {
+				processed.fetch_add(1, std::memory_order_relaxed);
+				busyUs.fetch_add(us, std::memory_order_relaxed);
+			}
+		};
+
+		void captureLoop();
+		void detectLoop();
+		void embedLoop();
+		void maybeLogStats();
+
+		static QThread* spawn(const char* name, std::function<void()> body, QThread::Priority prio);
+		static void join(QThread*& th);
+
+		static StageStats makeStats(const Counter& c);
+
+		Stages  stages_;
+		Options opt_;
+
+		std::unique_ptr<StageQueue<FrameJob>> detectQ_;
+		std::unique_ptr<StageQueue<FrameJob>> embedQ_;
+
+		QThread* capTh_ = nullptr;
+		QThread* detTh_ = nullptr;
+		QThread* embTh_ = nullptr;
+
+		std::atomic<bool>	  running_{false};
+		uint64_t			  seq_ = 0;				// 캡처 스레드 전용
+
+		Counter capCnt_;
+		Counter detCnt_;
+		Counter embCnt_;
+
+		int64_t lastLogMs_ = 0;						// embed 스레드 전용
+};
@@ -0,0 +1,170 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+// 스테이지 사이에 두는 고정 크기 lock-free 큐 (Vyukov bounded MPMC ring)
+//  - tryPush()/tryPop() : 데이터 경로는 CAS만 사용 (락 없음)
+//  - pushLatest()       : 가득 차면 가장 오래된 항목을 버리고 넣는다 (latest-frame-wins)
+//  - popLatest()        : 밀린 항목은 버리고 가장 최신 항목만 꺼낸다
+//  - waitNonEmpty()     : 소비자 스레드 재우기 전용 (데이터 경로와 무관)
+template <typename T>
+class StageQueue {
+public:
+	explicit StageQueue(size_t capacity = 2)
+	{
+		size_t cap = 2;
+		while (cap < capacity) cap <<= 1;		// 2의 거듭제곱으로 맞춤
+		mask_  = cap - 1;
+		cells_ = std::make_unique<Cell[]>(cap);
+		for (size_t i = 0; i < cap; ++i) cells_[i].seq.store(i, std::memory_order_relaxed);
+	}
+
+	StageQueue(const StageQueue&) = delete;
+	StageQueue& operator=(const StageQueue&) = delete;
+
+	// 가득 차면 false (v는 그대로 남는다)
+	bool tryPush(T&& v)
+	{
+		Cell* c = nullptr;
+		size_t pos = enq_.load(std::memory_order_relaxed);
+		for (;;) {
+			c = &cells_[pos & mask_];
+			const size_t seq = c->seq.load(std::memory_order_acquire);
+			const intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+			if (dif == 0) {
+				if (enq_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+			}
+			else if (dif < 0) {
+				return false;						// full
+			}
+			else {
+				pos = enq_.load(std::memory_order_relaxed);
+			}
+		}
+		c->data = std::move(v);
+		c->seq.store(pos + 1, std::memory_order_release);
+		pushed_.fetch_add(1, std::memory_order_relaxed);
+		notify();
+		return true;
+	}
+
+	bool tryPop(T& out)
+	{
+		Cell* c = nullptr;
+		size_t pos = deq_.load(std::memory_order_relaxed);
+		for (;;) {
+			c = &cells_[pos & mask_];
+			const size_t seq = c->seq.load(std::memory_order_acquire);
+			const intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+			if (dif == 0) {
+				if (deq_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+			}
+			else if (dif < 0) {
+				return false;						// empty
+			}
+			else {
+				pos = deq_.load(std::memory_order_relaxed);
+			}
+		}
+		out = std::move(c->data);
+		c->data = T{};							// 프레임 버퍼 참조 등을 즉시 놓아준다
+		c->seq.store(pos + mask_ + 1, std::memory_order_release);
+		return true;
+	}
+
+	// latest-frame-wins: 소비자가 밀리면 오래된 프레임부터 버린다
+	void pushLatest(T&& v)
+	{
+		while (!tryPush(std::move(v))) {
+			T stale;
+			if (tryPop(stale)) dropped_.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	// 큐에 쌓인 것 중 가장 최신 것만 꺼낸다 (건너뛴 항목은 drop으로 집계)
+	bool popLatest(T& out)
+	{
+		if (!tryPop(out)) return false;
+		T newer;
+		while (tryPop(newer)) {
+			out = std::move(newer);
+			dropped_.fetch_add(1, std::memory_order_relaxed);
+		}
+		return true;
+	}
+
+	// 비어 있으면 최대 timeout 동안 잠든다 (true = 항목 있음)
+	bool waitNonEmpty(std::chrono::milliseconds timeout)
+	{
+		if (depth() > 0) return true;
+		sleepers_.fetch_add(1, std::memory_order_seq_cst);
+		bool ok = false;
+		{
+			std::unique_lock<std::mutex> lk(waitMu_);
+			ok = waitCv_.wait_for(lk, timeout, [this] { return depth() > 0 || woken_; })
+				&& depth() > 0;
+		}
+		sleepers_.fetch_sub(1, std::memory_order_seq_cst);
+		return ok;
+	}
+
+	// stop() 시 잠든 소비자 깨우기
+	void wakeAll()
+	{
+		{ std::lock_guard<std::mutex> lk(waitMu_); woken_ = true; }
+		waitCv_.notify_all();
+	}
+
+	void reset()
+	{
+		T tmp;
+		while (tryPop(tmp)) {}
+		std::lock_guard<std::mutex> lk(waitMu_);
+		woken_ = false;
+	}
+
+	size_t depth() const
+	{
+		const size_t e = enq_.load(std::memory_order_acquire);
+		const size_t d = deq_.load(std::memory_order_acquire);
+		return (e > d) ? (e - d) : 0;
+	}
+	size_t   capacity() const { return mask_ + 1; }
+	uint64_t pushed()   const { return pushed_.load(std::memory_order_relaxed); }
+	uint64_t dropped()  const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+	void notify()
+	{
+		// 데이터 경로는 락 없이 끝났고, 잠든 소비자가 있을 때만 깨운다
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (sleepers_.load(std::memory_order_seq_cst) == 0) return;
+		{ std::lock_guard<std::mutex> lk(waitMu_); }
+		waitCv_.notify_one();
+	}
+
+	struct Cell {
+		std::atomic<size_t> seq{0};
+		T data{};
+	};
+
+	std::unique_ptr<Cell[]> cells_;
+	size_t mask_ = 0;
+
+	alignas(64) std::atomic<size_t> enq_{0};
+	alignas(64) std::atomic<size_t> deq_{0};
+
+	std::atomic<uint64_t> pushed_{0};
+	std::atomic<uint64_t> dropped_{0};
+
+	std::mutex              waitMu_;
+	std::condition_variable waitCv_;
+	bool                    woken_ = false;
+	std::atomic<int>        sleepers_{0};
+};
@@ -5,12 +5,16 @@ MainPresenter::MainPresenter(MainWindow* view, QObject* p)
 {
 	db_ = new QSqliteService(); 
 
+	// 갤러리 메타데이터 단일 소스 (인식 서비스가 게시, BLE/GUI 는 읽기만)
+	galleryService = new GalleryService(this);
+
 	faceRecognitionService = new FaceRecognitionService(nullptr, nullptr, db_);
 	faceRecognitionThread = new QThread();
 	faceRecognitionService->moveToThread(faceRecognitionThread);
 
 	faceRecognitionPresenter = new FaceRecognitionPresenter(faceRecognitionService, view, view);
 	faceRecognitionService->setPresenter(faceRecognitionPresenter);
+	faceRecognitionService->setGalleryService(galleryService);
 	connect(faceRecognitionThread, &QThread::started, faceRecognitionService, [=]() {
 		faceRecognitionService->startDirectCapture(-1);
 	}, Qt::QueuedConnection);
@@ -21,6 +25,7 @@ MainPresenter::MainPresenter(MainWindow* view, QObject* p)
 	bleServer = new BleServer(nullptr, faceRecognitionService);
 	bleServer->setInterfaceName("hci0");
 	bleServer->setDbPath("/root/trunk/faceRecognizer_Doorlock/assert/db/doorlock.db");
+	bleServer->setGalleryService(galleryService);
 
 	// 스레드 이동
 	bleServer->moveToThread(bleThread);
@@ -40,7 +45,7 @@ MainPresenter::MainPresenter(MainWindow* view, QObject* p)
 	connect(bleThread, &QThread::started, bleServer, &BleServer::run, Qt::QueuedConnection);
 
 
-	userImageService = new UserImageService(nullptr);
+	userImageService = new UserImageService(nullptr, galleryService);
 	userImagePresenter = new UserImagePresenter(userImageService, view);
 	userImageService->setPresenter(userImagePresenter);
 
@@ -104,6 +109,12 @@ void MainPresenter::stopBle()
 
 void MainPresenter::stopFaceEngine() 
 {
+	// 파이프라인 스테이지 스레드는 서비스 멤버(검출기/매처)를 씀 -> 서비스 스레드에서 먼저 정지
+	if (faceRecognitionThread->isRunning()) {
+		QMetaObject::invokeMethod(faceRecognitionService, [svc = faceRecognitionService]() {
+			svc->stopDirectCapture();
+		}, Qt::BlockingQueuedConnection);
+	}
 	faceRecognitionThread->quit();
 	faceRecognitionThread->wait();
 
@@ -12,6 +12,7 @@
 
 #include "FaceRecognitionService.hpp"
 #include "UserImageService.hpp"
+#include "GalleryService.hpp"
 #include "QSqliteService.hpp"
 
 #include "ble/BleServer.hpp"
@@ -58,6 +59,7 @@ private:
 
 		FaceRecognitionService* faceRecognitionService;
 		UserImageService* userImageService;
+		GalleryService* galleryService;
 		QSqliteService* db_;
 		BleServer* bleServer;
 
@@ -10,7 +10,7 @@ UserImagePresenter::UserImagePresenter(UserImageService* service, MainWindow* vi
 void UserImagePresenter::onShowImages()
 {
 		qDebug() << "[UserImagePresenter] handleShowImages called";
-		QList<UserImage> images = UserImageService::getUserImages();
+		QList<UserImage> images = service->getUserImages();
 
 		if (images.isEmpty()) {
 				view->showInfo("정보", "등록된 이미지가 없습니다.");
@@ -22,7 +22,7 @@ void UserImagePresenter::onShowImages()
 
 void UserImagePresenter::handleDeleteImage(const QString& imagePath)
 {
-		if (UserImageService::deleteImage(imagePath)) {
+		if (service->deleteImage(imagePath)) {
 				QPointer<QDialog> dialogToClose = view->getGalleryDialog();
 				if (dialogToClose && dialogToClose->isVisible()) {
 						dialogToClose->close();
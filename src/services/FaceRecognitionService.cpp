@@ -14,6 +14,7 @@
 #include <vector>
 #include <algorithm>		// for std::max_element
 #include <cmath>			// for std::hypot
+#include <sys/stat.h>
 
 #include <opencv2/imgproc.hpp>
 #include <opencv2/imgcodecs.hpp>
@@ -32,6 +33,9 @@
 #include "log/SystemLogger.hpp"
 #include "services/QSqliteService.hpp"
 #include "util/textDrawUtil.hpp"
+#include "capture/YuyvConvert.hpp"
+#include "capture/JpegDecode.hpp"
+#include "include/recog_params.hpp"
 
 
 // #define DEBUG 
@@ -88,6 +92,39 @@ FaceRecognitionService::FaceRecognitionService(QObject* parent, FaceRecognitionP
 			/*inputW*/320, /*inputH*/240, 
 			/*scoreThr*/0.6f, /*nmsThr*/0.3f, /*topK*/500);
 
+	// 검출 정책: 인식 모드는 품질 게이트에서 탈락할 영역/해상도를 처음부터 검출하지 않고
+	//  등록 모드는 전체 프레임 (모드별 값은 DETECT_* 설정)
+	{
+		auto makePolicy = [] (int scale, bool centerWindow) {
+			DetectPolicy pol;
+			pol.scale		 = static_cast<DetectPolicy::Scale>(std::clamp(scale, 0, 2));
+			pol.centerWindow = centerWindow;
+			pol.centerOffset = static_cast<float>(LivenessGate::kMaxCenterOffset);
+			pol.minFacePx	 = LivenessGate::kMinFaceBox;
+			return pol;
+		};
+		recogPolicy_ = makePolicy(DETECT_RECOG_SCALE, DETECT_RECOG_CENTER_WINDOW != 0);
+		regPolicy_	 = makePolicy(DETECT_REG_SCALE, DETECT_REG_CENTER_WINDOW != 0);
+		detector_.setPolicy(recogPolicy_);
+	}
+	tracker_.init(detect_model_name);		// ROI 추적용 YuNet (전체 검출은 detector_)
+
+	// 시간축 라이브니스 기준 (LIVENESS_* 설정)
+	{
+		TemporalLiveness::Options lo;
+		lo.window			  = LIVENESS_WINDOW;
+		lo.minFrames		  = LIVENESS_MIN_FRAMES;
+		lo.minParallax		  = LIVENESS_MIN_PARALLAX;
+		lo.minMotion		  = LIVENESS_MIN_MOTION;
+		lo.maxNonUniform	  = LIVENESS_MAX_NONUNIFORM;
+		lo.fallbackFrames	  = LIVENESS_FALLBACK_FRAMES;
+		lo.fallbackNonUniform = LIVENESS_FALLBACK_NONUNIFORM;
+		temporalLive_.setOptions(lo);
+	}
+#if ALIGN_DEBUG_DUMP
+	aligner_.setDebugDump(ALIGN_DEBUG_DUMP_DIR);
+#endif
+
 	// 6) Decision init
 	decision_.setParams(DecisionParams {
 			.acceptSim				= 0.90f,
@@ -108,6 +145,23 @@ void FaceRecognitionService::setPresenter(FaceRecognitionPresenter* _presenter)
 	presenter = _presenter;
 }
 
+FaceRecognitionService::~FaceRecognitionService()
+{
+	// 스테이지 스레드가 다른 멤버를 쓰는 동안 그 멤버가 먼저 소멸되지 않게 가장 먼저 정지
+	stopDirectCapture();
+	storeWatcher_.disconnect(this);
+	reloadDebounce_.stop();
+	if (reloadTh_.joinable()) reloadTh_.join();
+}
+
+void FaceRecognitionService::setGalleryService(GalleryService* gallery)
+{
+	galleryService_ = gallery;
+	if (!galleryService_) return;
+	publishGallery();
+	galleryService_->refreshImages();
+}
+
 
 void FaceRecognitionService::init()
 {
@@ -127,16 +181,12 @@ void FaceRecognitionService::init()
 
 bool FaceRecognitionService::idExists(int id) const
 {
-	return std::any_of(gallery_.begin(), gallery_.end(),
-			[&] (const UserEmbedding& u) { return u.id == id; });
+	return gallery()->find(id) != nullptr;
 }
 
 void FaceRecognitionService::rebuildNextIdFromGallery()
 {
-	int maxId = 0; 		// Start ID or Last ID 
-	for (const auto& u : gallery_) {			// 유저 버퍼에서 다음 ID를 찾음
-		if (u.id > maxId) maxId = u.id;
-	}
+	const int maxId = std::max(0, gallery()->maxId());		// Start ID or Last ID (스냅샷이 유지, 순회 없음)
 
 	if (maxId == 0) {							// ID가 0이면 0부터 시작하고 0이 아니면 +1을 하여 Counter에 셋팅
 		nextIdCounter_.store(maxId, std::memory_order_relaxed);
@@ -165,30 +215,14 @@ bool FaceRecognitionService::ensureEmbFile()
 	if (QFile::exists(embeddingsPath_)) return false;
 
 	int dim = 128;
+	if (dnnEmbedder_ && dnnEmbedder_->embeddingDim() > 0) dim = dnnEmbedder_->embeddingDim();
 
-	QJsonObject root;
-	root["version"] = 1;
-	root["dim"]			= dim;					// TODO: 실제 임베딩 파일에서 DIM을 받아오기
-	root["count"]		= 0;
-	root["items"]		= QJsonArray{};
-
-	const QByteArray out = QJsonDocument(root).toJson(QJsonDocument::Indented);
-
-	QFile f(embeddingsPath_);
-	if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-		qWarning() << "[ensureEmbFile] open failed:" << embeddingsPath_ << f.errorString();
-		return false;
-	}
-
-	if (f.write(out) != out.size()) {
-		qWarning() << "[ensureEmbFile] write failed:" << embeddingsPath_;
-		f.close();
-		QFile::remove(embeddingsPath_);
+	if (!EmbeddingStore::save(embeddingsPath_, {}, dim)) {
+		qWarning() << "[ensureEmbFile] create failed:" << embeddingsPath_;
 		return false;
 	}
-	f.close();
 
-	qInfo() << "[ensureEmbFile] created empty file:" << embeddingsPath_
+	qInfo() << "[ensureEmbFile] created empty store:" << embeddingsPath_
 		<< "dim=" << dim;
 	return true;
 }
@@ -218,6 +252,8 @@ bool FaceRecognitionService::loadRecognizer()
 	opt.inputSize	= 112;
 	opt.useRGB		= true;
 	opt.norm		= Embedder::Options::Norm::MinusOneToOne;		//  입력 정규화 방식
+	opt.tta			= Embedder::Options::Tta::OnDemand;				//  인식: 애매할 때만 flip, 등록: 항상(N=2 배치)
+	opt.instances	= 2;											//  인식 스트림과 등록/재임베딩이 서로 대기하지 않게
 
 	dnnEmbedder_ = std::make_unique<Embedder>(opt);
 	if (!dnnEmbedder_) {
@@ -234,6 +270,10 @@ bool FaceRecognitionService::loadRecognizer()
 	}
 
 	matcher_ = std::make_unique<FaceMatcher>(dnnEmbedder_);	
+	matcher_->setStorage(GALLERY_STORAGE == 2 ? GalleryIndex::Storage::I8
+						 : GALLERY_STORAGE == 1 ? GalleryIndex::Storage::F16
+						 : GalleryIndex::Storage::F32);
+	matcher_->loadAnnIndex(annIndexPath());		// 없거나 어긋나면 갤러리 로드 시 새로 구성
 
 	qInfo() << "[loadRecognizer] Sface recognizer is loaded(" << modelQ << ")";
 
@@ -246,27 +286,37 @@ bool FaceRecognitionService::loadRecognizer()
 bool FaceRecognitionService::loadEmbJsonFile()
 {
 	bool rc = false;
-	const QString embPath = QStringLiteral(EMBEDDING_JSON_PATH) + QStringLiteral(EMBEDDING_JSON);
-	embeddingsPath_ = embPath.toUtf8().constData();
-	if (!QFile::exists(embPath)) {
+	const QString embPath = QStringLiteral(EMBEDDING_JSON_PATH) + QStringLiteral(EMBEDDING_STORE);
+	embeddingsPath_ = embPath;
+	if (!QFile::exists(embPath) && !migrateLegacyJson()) {
 		ensureEmbFile();
 	}
 
+	// 변경 저널 (기반 저장소 이후의 추가/삭제)
+	if (!journal_) {
+		journal_ = std::make_unique<EmbeddingJournal>(journalPath());
+		if (!journal_->open()) {
+			qWarning() << "[loadEmbJsonFile] journal open failed ->" << journalPath() << "(full save fallback)";
+			journal_.reset();
+		}
+	}
 
-	// 3) Embedding.json 파일 로드 -> 사용자 DB
+	// 3) 임베딩 저장소 매핑 -> 사용자 DB
 	rc = loadEmbeddingsFromFile();
 	if (!rc) {
-		SystemLogger::error("FRS", QString("Embedding json file is not found(%1)").arg(embPath));
+		SystemLogger::error("FRS", QString("Embedding store is not found(%1)").arg(embPath));
 		qDebug() << "[loadEmbJosnFile] File load failed to embeddings";	
-		gallery_.clear();
+		updateGallery([] (const GallerySnapshot&, GalleryDelta& d) { d.clear = true; });
 		rc = false;
 	}
 	else {
-		qInfo() << "[loadEmbJsonFile] Loaded embeddings:" << (int)gallery_.size()
+		qInfo() << "[loadEmbJsonFile] Loaded embeddings:" << gallery()->size()
 			<< "users from" << embPath;
 		rc = true;
 	}
 
+	// 이후 변경은 감시 -> 재적재 (retrain 버튼 없이)
+	watchEmbeddingStore();
 	return rc;
 }
 
@@ -285,6 +335,20 @@ bool FaceRecognitionService::initializeDnnOnly()
 
 	if (!loadEmbJsonFile()) rc--;
 
+	// 모델 교체(임베딩 차원 변경) 또는 임베딩 파일 유실 -> 등록 이미지로 재임베딩
+	if (dnnEmbedder_ && dnnEmbedder_->isReady()) {
+		const int dim = dnnEmbedder_->embeddingDim();
+		const auto g = gallery();
+		const auto users = g->users();
+		const bool stale = std::any_of(users.begin(), users.end(),
+				[&] (const GalleryUserPtr& u) { return u->dim != dim; });
+		const bool lost  = g->isEmpty() && fs::exists(USER_FACES_DIR) && !fs::is_empty(USER_FACES_DIR);
+		if (dim > 0 && (stale || lost)) {
+			qInfo() << "[FRS] gallery migration needed (dim=" << dim << "stale=" << stale << "lost=" << lost << ")";
+			if (!rebuildGalleryFromImages()) rc--;
+		}
+	}
+
 	// 사용자 ID 초기화
 	rebuildNextIdFromGallery();
 
@@ -348,7 +412,7 @@ void FaceRecognitionService::forceAbortRegistration() {
 	registeringUserName_.clear();
 	registeringUserId_	 = -1;
 
-	regEmbedsBuffers_.clear();		// 임베딩 제이슨 파일에 저장할 버퍼 초기화
+	regEmbeds_.clear();				// 등록 임베딩 버퍼 초기화
 	regImageBuffers_.clear();		// 메모리에 저장할 이미지 버퍼
 
 	m_isAngleRegActive = false;
@@ -373,7 +437,7 @@ void FaceRecognitionService::startRegistering(const QString& name)
 	registeringUserName_ = name;
 	registeringUserId_ = nextSequentialId();
 	captureCount = 0;
-	regEmbedsBuffers_.clear();
+	regEmbeds_.clear();
 	regImageBuffers_.clear();		// 메모리에 저장할 이미지 버퍼
 
 	m_isAngleRegActive = true;
@@ -398,60 +462,236 @@ void FaceRecognitionService::startRegistering(const QString& name)
 // UI에서 호출 예정
 QString FaceRecognitionService::getUserName() const { return registeringUserName_; }
 
-// === 임베딩 json파일에 저장===
-// gallery_ -> 파일 (안전하게 임시 파일에 쓴 뒤 rename) 
+// === 임베딩 저장소에 저장 ===
+// 갤러리 스냅샷 -> 바이너리 저장소 (QSaveFile: 임시 파일에 쓴 뒤 rename)
 bool FaceRecognitionService::saveEmbeddingsToFile() const
 {
 	if (embeddingsPath_.isEmpty()) return false;
 
-	// snapshot
-	std::vector<UserEmbedding> snapshot;
-	{ QMutexLocker lk(&embMutex_); snapshot = gallery_; }
+	// 전체 다시 쓰기 -> 저널은 비움. 그 사이 다른 변경이 끼지 않게 쓰기 측 락 유지
+	QMutexLocker lk(&embMutex_);
+	if (journal_) journal_->waitCompaction();
+
+	// snapshot (복사 없이 현재 버전 고정)
+	const GallerySnapshot::Ptr snapshot = gallery();
 
 	// dim
-	int dim = 128;				// TODO: 실제 임베더에 DIM 구하는 함수 구현
+	int dim = 128;
 	if (dnnEmbedder_) {
-		//int d = dnnEmbedder_->embeddingDim();
-		//if (d > 0) dim = d;
-	}
-
-	QJsonArray items;
-	for (const auto& ue : snapshot) {
-		QJsonObject o;
-		o["id"] = ue.id;
-		o["name"] = ue.name;
-		QJsonArray emb;
-		for (float v : ue.embedding) emb.append(double(v));
-		o["embedding"] = emb;
-		items.append(o);
-	}
-
-	QJsonObject root;
-	root["count"] = int(items.size());
-	root["dim"] = dim;
-	root["items"] = items;
-	root["version"] = 1;
-
-	const QByteArray out = QJsonDocument(root).toJson(QJsonDocument::Indented);
-	const QString tmp = embeddingsPath_ + ".tmp";
-	const QString bak = embeddingsPath_ + ".bak";
-
-	QFile tf(tmp);
-	if (!tf.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-		qWarning() << "[Embedding] temp open failed:" << tmp << "err=" << tf.errorString();
+		int d = dnnEmbedder_->embeddingDim();
+		if (d > 0) dim = d;
+	}
+
+	if (!EmbeddingStore::save(embeddingsPath_, snapshot->users(), dim)) {
+		qWarning() << "[Embedding] store save failed:" << embeddingsPath_;
 		return false;
 	}
-	if (tf.write(out) != out.size()) { tf.close(); tf.remove(); return false; }
-	tf.close();
+	noteOwnBaseWrite();
 
-	QFile::remove(bak);
-	if (QFile::exists(embeddingsPath_)) QFile::copy(embeddingsPath_, bak);
-	QFile::remove(embeddingsPath_);
-	if (!QFile::rename(tmp, embeddingsPath_)) {
-		qWarning() << "[Embedding] rename tmp->final failed:" << tmp;
+#if EMBEDDING_JSON_EXPORT
+	// 디버깅용 사본 (로드에는 쓰지 않음)
+	if (!EmbeddingStore::exportJson(legacyJsonPath(), snapshot->users(), dim)) {
+		qWarning() << "[Embedding] json export failed:" << legacyJsonPath();
+	}
+#endif
+
+	// HNSW 그래프도 같은 시점에 저장 (다음 부팅 시 재구성 생략)
+	if (matcher_ && !matcher_->saveAnnIndex(annIndexPath())) {
+		qWarning() << "[Embedding] ann index save failed:" << annIndexPath();
+	}
+
+	if (journal_ && !journal_->reset()) {
+		qWarning() << "[Embedding] journal reset failed:" << journalPath();
+	}
+	return true;
+}
+
+QString FaceRecognitionService::journalPath()
+{
+	return QStringLiteral(EMBEDDING_JSON_PATH) + QStringLiteral(EMBEDDING_JOURNAL);
+}
+
+// === 갤러리 변경 확정 ===
+// embMutex_ 밖에서 호출: 저널 레코드(seq)를 fdatasync 로 확정 (동시에 들어온 변경과 한 번에)
+// 확정됐으면 크기만 보고 압축, 저널이 없거나 쓰기/확정 실패면 전체 저장
+void FaceRecognitionService::commitGalleryChange(uint64_t seq)
+{
+	if (seq == 0 || !journal_ || !journal_->sync(seq)) {
+		if (!saveEmbeddingsToFile()) qWarning() << "[Embedding] store save failed after change";
+		return;
+	}
+	if (journal_->bytes() >= EMBEDDING_JOURNAL_COMPACT_BYTES) compactGalleryAsync();
+}
+
+// === 저널 압축 (백그라운드) ===
+// 표시 시점 = 현재 스냅샷. 둘 다 embMutex_ 안에서 잡아야 저널 내용과 스냅샷이 어긋나지 않음
+void FaceRecognitionService::compactGalleryAsync()
+{
+	if (!journal_ || !matcher_) return;
+
+	QMutexLocker lk(&embMutex_);
+	if (journal_->compacting()) return;
+
+	const GallerySnapshot::Ptr snapshot = gallery();
+	int dim = 128;
+	if (dnnEmbedder_) {
+		int d = dnnEmbedder_->embeddingDim();
+		if (d > 0) dim = d;
+	}
+	const QString path = embeddingsPath_;
+
+	journal_->compactAsync([this, snapshot, path, dim] {
+		QElapsedTimer t;
+		t.start();
+		if (!EmbeddingStore::save(path, snapshot->users(), dim)) {
+			qWarning() << "[Embedding] compaction: store save failed:" << path;
+			return false;
+		}
+		noteOwnBaseWrite();
+		// HNSW 는 스냅샷이 들고 있는 그래프 그대로
+		if (!snapshot->ann().save(annIndexPath().toStdString())) {
+			qWarning() << "[Embedding] compaction: ann index save failed:" << annIndexPath();
+		}
+		qInfo() << "[Embedding] compaction: base written users=" << snapshot->size()
+				<< "in" << t.elapsed() << "ms";
+		return true;
+	});
+}
+
+FaceRecognitionService::StoreStamp FaceRecognitionService::storeStamp(const QString& path)
+{
+	StoreStamp s;
+	struct stat st {};
+	if (::stat(QFile::encodeName(path).constData(), &st) != 0) return s;
+	s.ino	= static_cast<quint64>(st.st_ino);
+	s.size	= static_cast<qint64>(st.st_size);
+	s.mtime = static_cast<qint64>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+	return s;
+}
+
+void FaceRecognitionService::noteOwnBaseWrite() const
+{
+	const StoreStamp s = storeStamp(embeddingsPath_);
+	std::lock_guard<std::mutex> sl(stampMutex_);
+	baseStamp_ = s;
+}
+
+// 기반 저장소가 마지막으로 읽거나 쓴 것과 다르거나, 저널 크기가 내가 쓴 양과 다르면 외부 변경
+bool FaceRecognitionService::storeChangedExternally()
+{
+	const StoreStamp base = storeStamp(embeddingsPath_);
+	if (base.ino == 0) return false;				// 없음 (초기화 중) -> 읽을 것도 없음
+	{
+		std::lock_guard<std::mutex> sl(stampMutex_);
+		if (!(base == baseStamp_)) return true;
+	}
+	if (journal_) {
+		const StoreStamp jnl = storeStamp(journalPath());
+		if (jnl.ino != 0 && jnl.size != journal_->bytes()) return true;
+	}
+	return false;
+}
+
+// === 저장소 감시 ===
+// 디렉터리 + 파일. QSaveFile/압축은 rename 으로 교체하므로 파일 감시가 풀림 -> 이벤트마다 다시 추가
+void FaceRecognitionService::watchEmbeddingStore()
+{
+	if (!storeWatcher_.directories().isEmpty()) return;
+
+	const QString dir = QStringLiteral(EMBEDDING_JSON_PATH);
+	if (!storeWatcher_.addPath(dir)) {
+		qWarning() << "[FRS] store watch failed:" << dir;
+		return;
+	}
+	rewatchStoreFiles();
+
+	reloadDebounce_.setSingleShot(true);
+	reloadDebounce_.setInterval(EMBEDDING_RELOAD_DEBOUNCE_MS);
+	connect(&storeWatcher_, &QFileSystemWatcher::directoryChanged, this, [this] (const QString&) {
+		rewatchStoreFiles();
+		reloadDebounce_.start();
+	});
+	connect(&storeWatcher_, &QFileSystemWatcher::fileChanged, this, [this] (const QString&) {
+		rewatchStoreFiles();
+		reloadDebounce_.start();
+	});
+	connect(&reloadDebounce_, &QTimer::timeout, this, &FaceRecognitionService::reloadGalleryAsync);
+	qInfo() << "[FRS] watching gallery store:" << dir;
+}
+
+void FaceRecognitionService::rewatchStoreFiles()
+{
+	const QStringList watched = storeWatcher_.files();
+	for (const QString& f : { embeddingsPath_, journalPath() }) {
+		if (!watched.contains(f) && QFile::exists(f)) storeWatcher_.addPath(f);
+	}
+}
+
+// === 외부 변경 재적재 (백그라운드) ===
+// 인식은 기존 스냅샷으로 계속, 끝나면 새 스냅샷 게시 (HNSW 는 이전 그래프에 차이만 반영)
+// 기반 저장소 자체가 바뀌었으면 로컬 저널은 버리고 새 기반만 읽음 (loadEmbeddingsFromFile)
+void FaceRecognitionService::reloadGalleryAsync()
+{
+	if (embeddingsPath_.isEmpty() || !matcher_) return;
+	if (reloading_.load(std::memory_order_acquire)) {
+		reloadDebounce_.start();				// 진행 중이면 끝난 뒤 다시 확인
+		return;
+	}
+	if (!storeChangedExternally()) return;		// 자기 쓰기 (등록/압축)
+
+	if (reloadTh_.joinable()) reloadTh_.join();
+	reloading_.store(true, std::memory_order_release);
+	reloadTh_ = std::thread([this] {
+		QElapsedTimer t;
+		t.start();
+		const uint64_t before = gallery()->version();
+		if (loadEmbeddingsFromFile()) {
+			rebuildNextIdFromGallery();
+			if (galleryService_) galleryService_->refreshImages();
+			qInfo() << "[FRS] gallery hot-reloaded v" << before << "->" << gallery()->version()
+					<< "users=" << gallery()->size() << "in" << t.elapsed() << "ms";
+			SystemLogger::info("FRS", QString("Gallery reloaded from store(users:%1)").arg(gallery()->size()));
+		}
+		else {
+			qWarning() << "[FRS] gallery hot-reload failed ->" << embeddingsPath_;
+		}
+		reloading_.store(false, std::memory_order_release);
+	});
+}
+
+QString FaceRecognitionService::annIndexPath()
+{
+	return QStringLiteral(EMBEDDING_JSON_PATH) + QStringLiteral(EMBEDDING_ANN);
+}
+
+QString FaceRecognitionService::legacyJsonPath()
+{
+	return QStringLiteral(EMBEDDING_JSON_PATH) + QStringLiteral(EMBEDDING_JSON);
+}
+
+// === 구버전 embeddings.json -> 바이너리 저장소 (한 번만) ===
+bool FaceRecognitionService::migrateLegacyJson()
+{
+	const QString json = legacyJsonPath();
+	if (!QFile::exists(json)) return false;
+
+	std::vector<UserEmbedding> legacy;
+	if (!EmbeddingStore::importJson(json, legacy)) {
+		qWarning() << "[Embedding] legacy json parse failed:" << json;
 		return false;
 	}
-	qInfo() << "[Embedding] saved users=" << items.size() << "to" << embeddingsPath_;
+	std::vector<GalleryUserPtr> users;
+	users.reserve(legacy.size());
+	for (const auto& ue : legacy) {
+		if (GalleryUserPtr u = GalleryUser::make(ue)) users.push_back(std::move(u));
+	}
+
+	int dim = users.empty() ? 0 : users.front()->dim;
+	if (dim <= 0 && dnnEmbedder_) dim = dnnEmbedder_->embeddingDim();
+	if (dim <= 0) dim = 128;
+	if (!EmbeddingStore::save(embeddingsPath_, users, dim)) return false;
+
+	qInfo() << "[Embedding] migrated" << int(users.size()) << "users from" << json << "->" << embeddingsPath_;
 	return true;
 }
 
@@ -461,93 +701,180 @@ int FaceRecognitionService::appendUserEmbedding(const QString& name, const std::
 
 	// 새 id: 현재 갤러리 id 최대값+1
 	int newId = 0;
-	{
-		QMutexLocker lk(&embMutex_);
-		for (const auto& g : gallery_) newId = std::max(newId, g.id + 1);
-		UserEmbedding ue;
-		ue.id = newId;
-		ue.name = name;
-		ue.embedding = emb;
-		gallery_.push_back(std::move(ue));
-	}
-	if (!saveEmbeddingsToFile()) {
-		qWarning() << "[Embedding] save failed after append";
-	}
+	const uint64_t seq = updateGallery([&] (const GallerySnapshot& g, GalleryDelta& d) {
+		newId = g.maxId() + 1;
+		d.upserts.push_back(GalleryUser::make(newId, name, int(emb.size()), emb.data(), nullptr, 0));
+	});
+	commitGalleryChange(seq);
 	return newId;
 }
 
 bool FaceRecognitionService::loadEmbeddingsFromFile()
 {
-	gallery_.clear();
-
-	QFile f(embeddingsPath_);
-	if (!f.exists()) {
-		qWarning() << "[loadEmbeddingsFromFile] file not found ->" << embeddingsPath_;
-		return false;
-	}
-	if (!f.open(QIODevice::ReadOnly)) {
-		qWarning() << "[loadEmbeddingsFromFile]: open failed ->" << embeddingsPath_ << f.errorString();
+	if (!matcher_) {
+		qWarning() << "[loadEmbeddingsFromFile] matcher is null";
 		return false;
 	}
 
-	const QJsonDocument jd = QJsonDocument::fromJson(f.readAll());
-	f.close();
-	if (!jd.isObject()) return false;
+	// 매핑/CRC/재적용/스냅샷 구성은 embMutex_ 밖. 락은 짧게 두 번:
+	//  1) 압축 완료 대기 + 기반 교체 판단 (저장소와 저널을 같은 시점으로 읽기)
+	//  2) 게시 (updateGallery 와 같은 publish(prev, next) 재시도)
+	//  그 사이 등록이 게시했거나(publish 실패) 압축이 기반을 바꿨으면(stamp) 처음부터 다시 읽음
+	for (int attempt = 1; ; ++attempt) {
+		const GallerySnapshot::Ptr prev = matcher_->gallery();
 
-	const auto root		= jd.object();
-	const auto items  = root.value("items").toArray();
+		// 파싱 없이 매핑 + CRC 확인, 행은 사용자 블록 -> GalleryIndex/HNSW 가 그대로 가리킴
+		//  stamp 는 먼저 (사이에 바뀌면 아래 확인에서 다시 읽음)
+		const StoreStamp stamp = storeStamp(embeddingsPath_);
+		EmbeddingStore::Ptr store = EmbeddingStore::load(embeddingsPath_);
+		if (!store) {
+			qWarning() << "[loadEmbeddingsFromFile] load failed ->" << embeddingsPath_;
+			return false;
+		}
 
-	std::vector<UserEmbedding> temp;
-	temp.reserve(items.size());
+		{
+			QMutexLocker lk(&embMutex_);
+			if (journal_) journal_->waitCompaction();
+			if (!(storeStamp(embeddingsPath_) == stamp)) {
+				qDebug() << "[loadEmbeddingsFromFile] store replaced while mapping, retry" << attempt;
+				continue;
+			}
+			bool baseReplaced = false;
+			{
+				std::lock_guard<std::mutex> sl(stampMutex_);
+				baseReplaced = baseStamp_.ino != 0 && !(stamp == baseStamp_);
+				baseStamp_ = stamp;
+			}
 
-	for (const auto& v : items) {
-		const auto o = v.toObject();
-		UserEmbedding ue;
-		ue.id		= o.value("id").toInt(-1);
-		ue.name = o.value("name").toString();
+			// 기반 저장소가 밖에서 통째로 바뀜 -> 로컬 저널은 이전 기반 위의 변경이라 재적용하면
+			//  새 기반에서 지운 사용자가 되살아남. 새 기반을 기준으로 삼고 저널은 버림
+			if (baseReplaced && journal_ && journal_->bytes() > EmbeddingJournal::kHeaderBytes) {
+				qWarning() << "[loadEmbeddingsFromFile] base replaced externally -> discarding local journal"
+						   << journal_->bytes() << "bytes";
+				SystemLogger::warn("FRS", "Embedding store replaced externally, local journal discarded");
+				if (!journal_->reset()) qWarning() << "[loadEmbeddingsFromFile] journal reset failed ->" << journalPath();
+			}
+		}
 
-		const auto embArr = o.value("embedding").toArray();
-		ue.embedding.reserve(embArr.size());
-		for (const auto& ev : embArr) ue.embedding.push_back(float(ev.toDouble()));
+		// 사용자 블록은 id/이름만, 행은 매핑 그대로
+		std::vector<GalleryUserPtr> users = store->users();
 
-		if (!ue.embedding.empty()) {
-			ue.proto = cv::Mat(1, int(ue.embedding.size()), CV_32F, ue.embedding.data()).clone();
+		// 저장소 이후 변경 재적용 (바뀐 사용자만 자기 버퍼 블록, 나머지는 매핑 그대로)
+		int replayed = 0;
+		if (journal_) {
+			replayed = journal_->replay(users);
+			if (replayed < 0) {
+				qWarning() << "[loadEmbeddingsFromFile] journal replay failed ->" << journalPath();
+				replayed = 0;
+			}
 		}
-		if (ue.id >= 0) temp.push_back(std::move(ue));
-	}
 
-	{ QMutexLocker lk(&embMutex_); gallery_ = std::move(temp); }
-	qInfo() << "[loadEmbeddingsFromFile] " << int(gallery_.size()) << "users from" << embeddingsPath_;
-	return true;
+		const int loaded = int(users.size());
+		const GallerySnapshot::Ptr next = matcher_->rebuild(*prev, users);
+		{
+			QMutexLocker lk(&embMutex_);
+			// 재적용 중 압축이 끝났으면 저널은 이미 잘렸는데 기반은 이전 것 -> 다시
+			if (!(storeStamp(embeddingsPath_) == stamp)) {
+				qDebug() << "[loadEmbeddingsFromFile] store compacted meanwhile, retry" << attempt;
+				continue;
+			}
+			if (!matcher_->publish(prev, next)) {
+				qDebug() << "[loadEmbeddingsFromFile] gallery changed meanwhile, retry" << attempt;
+				continue;
+			}
+		}
+		publishGallery();
+
+		qInfo() << "[loadEmbeddingsFromFile] " << loaded << "users from" << embeddingsPath_
+				<< "journal records=" << replayed;
+		// 재적용분은 다음 부팅 때 다시 읽지 않게 기반 저장소로 합침
+		if (replayed > 0) compactGalleryAsync();
+		return true;
+	}
 }
 
 MatchTop2 FaceRecognitionService::bestMatchTop2(const std::vector<float>& emb) const
 {
-	return matcher_->bestMatchTop2(emb, gallery_, true);
+	return matcher_->bestMatchTop2(emb, true);
 }
-std::vector<FaceDet> FaceRecognitionService::detectAllYuNet(const cv::Mat& bgr) const
+std::vector<FaceDet> FaceRecognitionService::detectAllYuNet(const cv::Mat& bgr)
 {
 	return detector_.detectAll(bgr);
 }
 
-std::optional<FaceDet> FaceRecognitionService::detectBestYuNet(const cv::Mat& bgr) const
+std::optional<FaceDet> FaceRecognitionService::detectBestYuNet(const cv::Mat& bgr)
 {
 	return detector_.detectBest(bgr);
 }
 
 
-// === 중볻된 얼굴인지 체크 ===
-bool FaceRecognitionService::isDuplicateFaceDNN(const cv::Mat& alignedFace, int* dupId, float* simOut) const
+// === 샘플 임베딩 (이미 있으면 재사용) ===
+bool FaceRecognitionService::ensureEmbedding(FaceSample& sample) const
 {
-	if (!dnnEmbedder_) return false;
+	if (sample.hasEmbedding()) return true;
+	if (!dnnEmbedder_ || sample.empty()) return false;
+	if (!dnnEmbedder_->extract(sample.aligned, sample.embedding)) sample.embedding.clear();
+	return sample.hasEmbedding();
+}
 
-	std::vector<float> emb;
-	cv::Mat alignedBGR;
-	cv::cvtColor(alignedFace, alignedBGR, cv::COLOR_RGB2BGR);
-	if (!dnnEmbedder_->extract(alignedBGR, emb) || emb.empty()) return false;
+// === 갤러리 스냅샷 ===
+// 매처가 현재 버전을 보관 (매처가 없으면 빈 갤러리)
+GallerySnapshot::Ptr FaceRecognitionService::gallery() const
+{
+	return matcher_ ? matcher_->gallery() : GallerySnapshot::empty();
+}
 
-	// Top-2 매칭
-	MatchResult r = matcher_->bestMatch(alignedFace, gallery_);
+// 현재 스냅샷 + 변경분(delta) -> 새 스냅샷은 embMutex_ 밖에서 만들고, 락은 교체와 저널 기록에만
+//  그 사이 다른 쓰기가 먼저 게시했으면 그 스냅샷으로 다시 (edit 은 여러 번 불릴 수 있음: 부작용 없이 delta 만 채울 것)
+//  반환: 마지막 저널 레코드 seq. 기록할 게 없거나(clear 포함) 기록 실패면 0 -> commitGalleryChange 가 전체 저장
+uint64_t FaceRecognitionService::updateGallery(const std::function<void(const GallerySnapshot&, GalleryDelta&)>& edit)
+{
+	if (!matcher_) {
+		qWarning() << "[FRS] updateGallery: matcher is null";
+		return 0;
+	}
+
+	for (int attempt = 1; ; ++attempt) {
+		const GallerySnapshot::Ptr prev = matcher_->gallery();
+		GalleryDelta delta;
+		edit(*prev, delta);
+		if (delta.empty()) return 0;
+		const GallerySnapshot::Ptr next = matcher_->derive(*prev, delta);
+
+		uint64_t seq = 0;
+		{
+			QMutexLocker lk(&embMutex_);
+			if (!matcher_->publish(prev, next)) {
+				qDebug() << "[FRS] updateGallery: gallery changed meanwhile, retry" << attempt;
+				continue;
+			}
+			// 저널 순서 = 게시 순서 (clear 는 호출 측이 전체 저장/초기화)
+			if (journal_ && !delta.clear) {
+				bool ok = true;
+				for (int id : delta.removes)		{ seq = journal_->appendDelete(id);  ok = ok && seq != 0; }
+				for (const auto& u : delta.upserts) { seq = journal_->appendUpsert(*u); ok = ok && seq != 0; }
+				if (!ok) seq = 0;
+			}
+		}
+		publishGallery();
+		return seq;
+	}
+}
+
+void FaceRecognitionService::publishGallery()
+{
+	if (galleryService_) galleryService_->publish(gallery());
+}
+
+// === 중볻된 얼굴인지 체크 ===
+// 샘플 임베딩은 여기서 한 번 채워지고 각도 체크/저장 단계가 그대로 재사용
+bool FaceRecognitionService::isDuplicateFaceDNN(FaceSample& sample, int* dupId, float* simOut) const
+{
+	if (!matcher_) return false;
+
+	MatchResult r = matcher_->bestMatch(sample);
+	if (dupId)  *dupId  = r.id;
+	if (simOut) *simOut = r.sim;
 	if (r.sim >= params_.recogEnter) {
 		return true;
 	}
@@ -632,7 +959,7 @@ void FaceRecognitionService::drawProgressBar(cv::Mat& frame)
 	}
 }
 
-DetectedStatus FaceRecognitionService::handleRegistration(Mat& frame, const Rect& face, const Mat& alignedFace, QString& labelText, Scalar& boxColor)
+DetectedStatus FaceRecognitionService::handleRegistration(Mat& frame, const Rect& face, FaceSample& sample, QString& labelText, Scalar& boxColor)
 {
 	qDebug() << "[FaceRecognitionService] handleRegistration()";
 	DetectedStatus rc;
@@ -649,7 +976,7 @@ DetectedStatus FaceRecognitionService::handleRegistration(Mat& frame, const Rect
 	if (captureCount <=  9) {
 		int dupId = -1;
 		float sim = 0.f;
-		if (isDuplicateFaceDNN(alignedFace, &dupId, &sim)) {
+		if (isDuplicateFaceDNN(sample, &dupId, &sim)) {
 			qDebug() << "[dep] dep?";
 			// 이미 등록된 사용자로 판단 -> 중복 처리
 			isRegisteringAtomic.storeRelaxed(0);
@@ -703,9 +1030,8 @@ DetectedStatus FaceRecognitionService::handleRegistration(Mat& frame, const Rect
 				drawProgressBar(frame);
 			}
 
-			// 2) 현재 프레임 임베딩 추출 (기존 extract() 그대로 사용, BGR alignedFace 준수)
-			std::vector<float> curEmbed;
-			if (!dnnEmbedder_->extract(alignedFace, curEmbed) && !curEmbed.empty()) {
+			// 2) 현재 프레임 임베딩 (중복 체크에서 이미 추출한 것 재사용)
+			if (!ensureEmbedding(sample)) {
 				// 추출 실패면 이번 프레임은 패스
 				labelText = QStringLiteral("임베딩 추출 실패");
 				boxColor = cv::Scalar(0, 0, 255);
@@ -715,7 +1041,7 @@ DetectedStatus FaceRecognitionService::handleRegistration(Mat& frame, const Rect
 			// 3) 동일 단계 내 과도한 유사도(=자세 안바뀜)면 캡처 보류 + 보조 문구
 			bool tooSimilar = false;
 			for (const auto& prev : m_recentEmbedsThisStep) {
-				float sim = dnnEmbedder_->cosine(curEmbed, prev);
+				float sim = Embedder::cosine(sample.embedding, prev);
 				if (sim >= m_dupSimThreshold) { tooSimilar = true; break; }
 			}
 			if (tooSimilar) {
@@ -727,7 +1053,7 @@ DetectedStatus FaceRecognitionService::handleRegistration(Mat& frame, const Rect
 
 			// 4) 여기까지 왔다면 "채택 가능한 각도" → 실제 저장 로직 직전에
 			//    (기존 저장 경로를 건드리지 않고, '사전 동의'처럼 흔적만 남김)
-			m_recentEmbedsThisStep.push_back(std::move(curEmbed));
+			m_recentEmbedsThisStep.push_back(sample.embedding);
 			m_stepCaptured++;
 
 			// 5) 단계 충족 시 다음 단계로
@@ -742,7 +1068,10 @@ DetectedStatus FaceRecognitionService::handleRegistration(Mat& frame, const Rect
 			}
 		}
 
-		saveCapturedFace(face, alignedFace, colorFace); 
+		// 임베딩은 중복 검사에서 이미 추출됨 (그때 실패했으면 여기서 한 번 더, 그래도 실패면 이 프레임은 버림)
+		if (!ensureEmbedding(sample)) return rc;
+
+		saveCapturedFace(sample, colorFace);
 		captureCount++;
 
 		if (captureCount >= 10) {
@@ -761,7 +1090,7 @@ DetectedStatus FaceRecognitionService::handleRegistration(Mat& frame, const Rect
 }
 
 
-void FaceRecognitionService::saveCapturedFace(const Rect& face, const Mat& alignedFace, const Mat& frame) 
+void FaceRecognitionService::saveCapturedFace(const FaceSample& sample, const Mat& frame)
 {
 	if (!fs::exists(USER_FACES_DIR))
 		fs::create_directory(USER_FACES_DIR);
@@ -771,12 +1100,9 @@ void FaceRecognitionService::saveCapturedFace(const Rect& face, const Mat& align
 	// 이미지 버퍼에 저장 후 finalizeRegistration에서 최종 메모리에 저장
 	regImageBuffers_.push_back(frame);
 
-	// ---- DNN 임시 임베딩 버퍼 추가 ----
+	// ---- 임베딩만 보관 (handleRegistration 에서 채워진 상태, 정렬 얼굴은 이후 안 씀) ----
 	if (dnnEmbedder_) {
-		std::vector<float> e;
-		if (dnnEmbedder_->extract(alignedFace, e) && !e.empty()) {
-			regEmbedsBuffers_.push_back(std::move(e));
-		}
+		if (sample.hasEmbedding()) regEmbeds_.push_back(sample.embedding);
 	}
 	else {
 		qDebug() << "[saveCaptureFace] Embedder is nullptr";
@@ -812,18 +1138,20 @@ void FaceRecognitionService::finalizeRegistration()
 		return;
 	}
 
-	// 2) DNN 평균 임베딩 계산
+	// 2) DNN 평균 임베딩 계산 (샘플마다 캡처 시점에 추출한 임베딩 사용)
 	std::vector<float> meanEmb;
+	std::vector<std::vector<float>> stepEmbs;
 	int used = 0;
-	for (const auto& e : regEmbedsBuffers_) {
+	for (const auto& e : regEmbeds_) {
 		if (e.empty()) continue;
 		if (meanEmb.empty()) meanEmb.assign(e.size(), 0.0f);
 		if (e.size() != meanEmb.size()) continue;
 		for (size_t i = 0; i < e.size(); i++) meanEmb[i] += e[i];
+		stepEmbs.push_back(e);
 		++used;
 	}
 
-	if (regEmbedsBuffers_.empty()) {
+	if (regEmbeds_.empty()) {
 		qDebug() << "[finalizeRegistration] register buffer is empty";
 	}
 
@@ -839,40 +1167,31 @@ void FaceRecognitionService::finalizeRegistration()
 	l2normInPlace(meanEmb);
 	//printVector(meanEmb, "meanEmb(before norm)");
 
-	// 3) gallery_ 업데이트 (registeringUserId_는 UI/흐름에서 미리 지정)
+	// 각도 단계별 포즈를 살리기 위해 평균과 함께 프로토타입 보관 (매칭은 프로토타입 최대값)
+	auto protos = FaceMatcher::makePrototypes(stepEmbs);
+	qDebug() << "[finalizeRegistration] samples=" << used << "prototypes=" << int(protos.size());
+
+	// 3) 갤러리 업데이트 (registeringUserId_는 UI/흐름에서 미리 지정)
 	if (registeringUserId_ < 0) {
 		registeringUserId_ = nextSequentialId();
 	}
 
 
-	// 갤러리 업데이트 락
-	{
-		QMutexLocker lk(&embMutex_);
-		auto it = std::find_if(gallery_.begin(), gallery_.end(),
-				[&] (const UserEmbedding& u) {
-					return u.id == registeringUserId_;
-				});
-
-
-		if (it == gallery_.end()) {
-			UserEmbedding ue;
-			ue.id = registeringUserId_;
-			ue.name = registeringUserName_;
-			ue.embedding = std::move(meanEmb);
-			ue.proto = cv::Mat(1, int(ue.embedding.size()), CV_32F, ue.embedding.data()).clone();
-			gallery_.push_back(std::move(ue));
-		}
-		else {
-			it->embedding = std::move(meanEmb);
-			it->proto = cv::Mat(1, int(it->embedding.size()), CV_32F,
-					it->embedding.data()).clone();
-		}
-	}
+	// 새 스냅샷 게시 (인식 스레드는 이전 버전으로 계속 검색)
+	// 저널 레코드는 게시와 같은 락 안에서 쓰고(순서 일치) 확정은 락 밖에서 -> 완료 통지는 확정 뒤
+	UserEmbedding ue;
+	ue.id		  = registeringUserId_;
+	ue.embedding  = std::move(meanEmb);
+	ue.prototypes = std::move(protos);
+	const uint64_t seq = updateGallery([&] (const GallerySnapshot& g, GalleryDelta& d) {
+		// 재등록이면 기존 이름 유지, 벡터만 새 블록 (다시 불려도 ue 는 그대로)
+		const GalleryUser* old = g.find(ue.id);
+		ue.name = old ? old->name : registeringUserName_;
+		if (GalleryUserPtr u = GalleryUser::make(ue)) d.upserts.push_back(std::move(u));
+	});
 
-	// 4) 파일 저장
-	if (!saveEmbeddingsToFile()) {
-		qWarning() << "[FRS] embeddings.json save failed";
-	}
+	// 4) 파일 저장 (저널 한 건 확정, 커지면 백그라운드 압축)
+	commitGalleryChange(seq);
 
 	if (m_cancelReg.load(std::memory_order_relaxed)) {
 		qDebug() << "[FRS] canceled while composing dataset";
@@ -894,6 +1213,7 @@ void FaceRecognitionService::finalizeRegistration()
 		}
 		++i;
 	}
+	if (galleryService_) galleryService_->refreshImages();
 
 	// 상태 초기화
 	setRegisterRequested(false);						// FSM 등록 요청 스냅샵 비활성화
@@ -901,7 +1221,7 @@ void FaceRecognitionService::finalizeRegistration()
 	captureCount = 0;									// 등록된 이미지수 초기화
 	registeringUserName_.clear();						// 등록 중인 사용자 이름 초기화
 	registeringUserId_ = -1;								// 등록 중인 사용자 아이디 초기화
-	regEmbedsBuffers_.clear();							//  임베딩 임시버퍼 초기화
+	regEmbeds_.clear();									//  등록 임베딩 임시버퍼 초기화
 	regImageBuffers_.clear();								//  이미지 임시버퍼 초기화
 	
 	m_isAngleRegActive = false;
@@ -912,6 +1232,97 @@ void FaceRecognitionService::finalizeRegistration()
 	emit registrationCompleted(true, QStringLiteral("등록 완료"));
 }
 
+// === 등록 이미지로 갤러리 재임베딩 ===
+// face_<id>_<name>_<n>.png 를 사용자별로 모아 검출/정렬 후 extractBatch 로 한 번에 임베딩
+// 생성자 init() 단계에서도 호출되므로 검출기는 로컬 인스턴스 사용
+bool FaceRecognitionService::rebuildGalleryFromImages()
+{
+	if (!dnnEmbedder_ || !dnnEmbedder_->isReady()) return false;
+	if (!fs::exists(USER_FACES_DIR)) return false;
+
+	FaceDetector det;
+	if (!det.init(std::string(YNMODEL_PATH) + YNMODEL, 320, 240, /*scoreThr*/0.6f, /*nmsThr*/0.3f, /*topK*/50)) {
+		qWarning() << "[rebuildGallery] detector init failed";
+		return false;
+	}
+
+	// 1) 파일명 -> (id, name, 경로들)
+	struct Entry { QString name; std::vector<std::string> files; };
+	std::map<int, Entry> users;
+	for (const auto& de : fs::directory_iterator(USER_FACES_DIR)) {
+		if (!de.is_regular_file() || de.path().extension() != ".png") continue;
+		const std::string stem = de.path().stem().string();		// face_<id>_<name>_<n>
+		const size_t a = stem.find('_');
+		const size_t b = (a == std::string::npos) ? a : stem.find('_', a + 1);
+		const size_t c = stem.rfind('_');
+		if (stem.rfind("face_", 0) != 0 || b == std::string::npos || c <= b) continue;
+
+		int id = -1;
+		try { id = std::stoi(stem.substr(a + 1, b - a - 1)); } catch (...) { continue; }
+		if (id < 0) continue;
+
+		Entry& e = users[id];
+		e.name = QString::fromStdString(stem.substr(b + 1, c - b - 1));
+		e.files.push_back(de.path().string());
+	}
+	if (users.empty()) return false;
+
+	// 2) 사용자별 정렬 얼굴 -> 배치 임베딩 -> 평균
+	std::vector<GalleryUserPtr> rebuilt;
+	for (auto& [id, e] : users) {
+		std::vector<cv::Mat> faces;
+		for (const auto& path : e.files) {
+			cv::Mat img = cv::imread(path, cv::IMREAD_COLOR);
+			if (img.empty()) continue;
+			auto fd = det.detectBest(img);
+			if (!fd) continue;
+			cv::Mat aligned = aligner_.alignBy5pts(img, fd->lmk, embedInputSize());
+			if (!aligned.empty()) faces.push_back(std::move(aligned));
+		}
+
+		std::vector<float> meanEmb;
+		std::vector<std::vector<float>> embs;
+		int used = 0;
+		for (auto& v : dnnEmbedder_->extractBatch(faces)) {
+			if (v.empty()) continue;
+			if (meanEmb.empty()) meanEmb.assign(v.size(), 0.0f);
+			if (v.size() != meanEmb.size()) continue;
+			for (size_t i = 0; i < v.size(); i++) meanEmb[i] += v[i];
+			embs.push_back(std::move(v));
+			++used;
+		}
+		if (used == 0) {
+			qWarning() << "[rebuildGallery] no usable face for id=" << id << e.name;
+			continue;
+		}
+		for (auto& v : meanEmb) v /= static_cast<float>(used);
+		l2normInPlace(meanEmb);
+
+		UserEmbedding ue;
+		ue.id		 = id;
+		ue.name		 = e.name;
+		ue.embedding  = std::move(meanEmb);
+		ue.prototypes = FaceMatcher::makePrototypes(embs);
+		if (GalleryUserPtr u = GalleryUser::make(ue)) rebuilt.push_back(std::move(u));
+		qDebug() << "[rebuildGallery] id=" << id << e.name << "faces=" << used << "/" << int(e.files.size());
+	}
+	if (rebuilt.empty()) return false;
+
+	const int rebuiltUsers = int(rebuilt.size());
+	updateGallery([&] (const GallerySnapshot&, GalleryDelta& d) {
+		d.clear	  = true;
+		d.upserts = rebuilt;
+	});
+	rebuildNextIdFromGallery();
+
+	if (!saveEmbeddingsToFile()) {
+		qWarning() << "[rebuildGallery] embeddings.bin save failed";
+		return false;
+	}
+	SystemLogger::info("FRS", QString("Gallery rebuilt from images(users:%1)").arg(rebuiltUsers));
+	return true;
+}
+
 void FaceRecognitionService::resetUnlockFlag()
 {
 	hasAlreadyUnlocked = false;
@@ -928,9 +1339,17 @@ void FaceRecognitionService::fetchReset()
 	QDir dir(USER_FACES_DIR);
 	dir.removeRecursively();
 
+	// 진행 중인 압축이 지운 파일을 되살리지 않도록 저널부터 정리
+	if (journal_) {
+		QMutexLocker lk(&embMutex_);
+		journal_->reset();
+	}
 	QFile::remove(embeddingsPath_);
+	QFile::remove(legacyJsonPath());
+	QFile::remove(annIndexPath());
 
-	gallery_.clear();
+	updateGallery([] (const GallerySnapshot&, GalleryDelta& d) { d.clear = true; });
+	if (galleryService_) galleryService_->refreshImages();
 	registeringUserId_ = -1;
 	registeringUserName_.clear();
 	rebuildNextIdFromGallery();
@@ -941,6 +1360,31 @@ void FaceRecognitionService::fetchReset()
 	presenter->presentReset();
 }
 
+// === 사용자 한 명 삭제 ===
+// 갤러리에서 빼고 저널에 삭제 레코드 하나 (전체 저장 없음), 등록 이미지(face_<id>_*)도 제거
+bool FaceRecognitionService::deleteUser(int id)
+{
+	bool found = false;
+	const uint64_t seq = updateGallery([&] (const GallerySnapshot& g, GalleryDelta& d) {
+		found = g.find(id) != nullptr;
+		if (found) d.removes.push_back(id);
+	});
+	if (!found) {
+		qWarning() << "[FRS] deleteUser: no such id" << id;
+		return false;
+	}
+	commitGalleryChange(seq);
+
+	QDir dir(USER_FACES_DIR);
+	const QStringList files = dir.entryList({ QStringLiteral("face_%1_*").arg(id) }, QDir::Files);
+	for (const QString& f : files) dir.remove(f);
+	if (galleryService_) galleryService_->refreshImages();
+	rebuildNextIdFromGallery();
+
+	SystemLogger::info("FRS", QString("User deleted(id:%1, images:%2)").arg(id).arg(files.size()));
+	return true;
+}
+
 void FaceRecognitionService::drawTransparentBox(Mat& img, Rect rect, Scalar color, double alpha = 0.4)
 {
 	Mat overlay;
@@ -978,7 +1422,7 @@ static inline const QString& getName(const UserEmbedding& u)
 
 recogResult_t FaceRecognitionService::handleRecognition(cv::Mat& frame,
         const cv::Rect& face,
-        const cv::Mat& alignedFace,
+        const FaceSample& sample,
         QString& labelText,
         cv::Scalar& boxColor)
 {
@@ -989,14 +1433,16 @@ recogResult_t FaceRecognitionService::handleRecognition(cv::Mat& frame,
     rv.idx  = -1;
     rv.result = AUTH_FAILED;
 
-    if (!dnnEmbedder_ || alignedFace.empty()) {
+    const cv::Mat& alignedFace = sample.aligned;
+    const std::vector<float>& emb = sample.embedding;
+    if (!dnnEmbedder_ || alignedFace.empty() || emb.empty()) {
         labelText = "Unknown";
         boxColor  = cv::Scalar(0,0,255);
         return rv;
     }
 
 	// 등록된 유저가 없을 때
-    const int numUsers = (int)gallery_.size();
+    const int numUsers = gallery()->size();
     if (numUsers <= 0) {
         labelText = "Unknown";
         boxColor  = cv::Scalar(0,0,255);
@@ -1008,11 +1454,11 @@ recogResult_t FaceRecognitionService::handleRecognition(cv::Mat& frame,
         return rv;
     }
 
-	// ==== Top-1 maching ====
-	MatchResult r = matcher_->bestMatch(alignedFace, gallery_);
+	// ==== Top-1 maching (임베딩은 embed 스테이지에서 이미 계산) ====
+	MatchResult r = matcher_->bestMatch(emb);
 	if (r.sim >= params_.recogEnter) {
 		rv.idx  = r.id;
-		rv.name = gallery_[r.id].name;
+		rv.name = r.name;
 		rv.sim  = r.sim;
 		rv.result = AUTH_SUCCESSED;
 		boxColor  = cv::Scalar(0,255,0);
@@ -1053,7 +1499,7 @@ recogResult_t FaceRecognitionService::handleRecognition(cv::Mat& frame,
 
 
 
-// ArcFace 112x112 템플릿 (출력은 128로 warp)
+// ArcFace 112x112 템플릿
 static const std::array<cv::Point2f, 5> kDst5_112 = {{
 	{38.2946f, 51.6963f}, {73.5318f, 51.5014f},
 		{56.0252f, 71.7366f}, {41.5493f, 92.3655f},
@@ -1147,33 +1593,64 @@ cv::Mat FaceRecognitionService::alignBy5pts(const cv::Mat& srcBgr, const std::ar
 	return aligner_.alignBy5pts(srcBgr, src5_in, outSize);
 }
 
+// 정렬 출력 = 임베더 입력 (중간 resize 없음)
+cv::Size FaceRecognitionService::embedInputSize() const
+{
+	const int s = (dnnEmbedder_ && dnnEmbedder_->inputSize() > 0) ? dnnEmbedder_->inputSize() : 112;
+	return cv::Size(s, s);
+}
+
 bool FaceRecognitionService::startDirectCapture(int cam)
 {
 	stopDirectCapture();
 
-	if (!cap_.open(cam, cv::CAP_V4L2)) {
-		qWarning() << "[startDirectCapture] open failed cam=" << cam;
-		return false;
-	}
+	// V4L2 mmap 링: 드라이버 버퍼를 그대로 참조 (프레임 deep copy 없음)
+	V4l2Capture::Options vopt;
+	vopt.device		 = V4l2Capture::deviceForIndex(cam);
+	vopt.width		 = camCfg_.width;
+	vopt.height		 = camCfg_.height;
+	vopt.fps		 = camCfg_.fps;
+	vopt.fourcc		 = camCfg_.mjpeg ? capfmt::MJPG : capfmt::YUYV;
+	vopt.bufferCount = 8;		// 최대 7개 동시 보유: detect/embed 큐(2+2) + 캡처/검출/임베드 스레드가 1씩, + 여유 1
 
-	// 저지연 튜닝
-	cap_.set(cv::CAP_PROP_BUFFERSIZE, 1);
-	cap_.set(cv::CAP_PROP_FRAME_WIDTH, 640);
-	cap_.set(cv::CAP_PROP_FRAME_HEIGHT, 480);
-	cap_.set(cv::CAP_PROP_FPS, 30);
-	//cap_.set(cv::CAP_PROP_FOURCC, cv::VideoWriter::fourcc('M','J','P','G'));
-	cap_.set(cv::CAP_PROP_FOURCC, cv::VideoWriter::fourcc('Y','U','Y','V'));
+	if (!v4l2_.open(vopt)) {
+		qWarning() << "[startDirectCapture] V4L2 mmap open failed, fallback to cv::VideoCapture";
 
-	running_.storeRelease(1);
+		if (!cap_.open(cam, cv::CAP_V4L2)) {
+			qWarning() << "[startDirectCapture] open failed cam=" << cam;
+			return false;
+		}
 
-	capThread_ = QThread::create([this] {
-			this->loopDirect();
-	});
-	capThread_->setObjectName(QStringLiteral("DirectCapture"));
-	QObject::connect(capThread_, &QThread::finished, capThread_, &QObject::deleteLater);
-	capThread_->start(QThread::TimeCriticalPriority);
+		// 저지연 튜닝
+		cap_.set(cv::CAP_PROP_BUFFERSIZE, 1);
+		cap_.set(cv::CAP_PROP_FRAME_WIDTH, camCfg_.width);
+		cap_.set(cv::CAP_PROP_FRAME_HEIGHT, camCfg_.height);
+		cap_.set(cv::CAP_PROP_FPS, camCfg_.fps);
+		if (camCfg_.mjpeg)
+			cap_.set(cv::CAP_PROP_FOURCC, cv::VideoWriter::fourcc('M','J','P','G'));
+		else
+			cap_.set(cv::CAP_PROP_FOURCC, cv::VideoWriter::fourcc('Y','U','Y','V'));
+	}
+
+	tracker_.reset();
+	lastTrackId_ = -1;
+
+	// capture -> detect -> embed 스테이지를 각자 스레드에서 겹쳐 돌린다
+	RecognitionPipeline::Stages stages;
+	stages.capture = [this](FrameJob& job) { return captureStage(job); };
+	stages.detect  = [this](FrameJob& job) { detectStage(job); };
+	stages.embed   = [this](FrameJob& job) { embedStage(job); };
+
+	if (!pipeline_.start(std::move(stages))) {
+		qWarning() << "[startDirectCapture] pipeline start failed";
+		v4l2_.close();
+		cap_.release();
+		return false;
+	}
 
-	qInfo() << "[startDirectCapture] started 640x480@30, buffersize=1";
+	qInfo() << "[startDirectCapture] started" << camCfg_.width << "x" << camCfg_.height
+			<< "@" << camCfg_.fps << (camCfg_.mjpeg ? "MJPEG" : "YUYV")
+			<< "(pipelined," << (v4l2_.isOpened() ? "v4l2 mmap)" : "VideoCapture)");
 	return true;
 }
 
@@ -1201,20 +1678,14 @@ void FaceRecognitionService::camRestart()
 
 void FaceRecognitionService::stopDirectCapture()
 {
-	if (running_.fetchAndStoreOrdered(0) == 1) {
-		// loopDirect가 정상적으로 탈출하도록 조금 기다렸다가
-	}
+	// 스테이지 스레드 종료 대기/정리 (capture -> detect -> embed 순)
+	pipeline_.stop();
 
 	g_unlockMgr.stop();
 	//g_uls.stop();
 
-	// 스레드 종료 대기/정리
-	if (capThread_) {
-		capThread_->wait();		// returning wait loopDirect()  
-		capThread_ = nullptr;	// finished 연결로 deleteLater 호출됨
-	}
-
-	// 카메라 해제
+	// 카메라 해제 (하위에서 잡고 있던 버퍼는 마지막 참조가 풀릴 때 unmap)
+	v4l2_.close();
 	if (cap_.isOpened()) {
 		cap_.release();
 	}
@@ -1311,322 +1782,478 @@ QString FaceRecognitionService::nameFromId(int userId)
 		return name;
 	}
 	
-	if (gallery_.size() <= 0) {
+	const auto g = gallery();
+	const GalleryUser* u = g->find(userId);
+	if (!u) {
 		name = QStringLiteral("Unkown");
 		return name;
 	}
 
-	name = gallery_[userId].name;	
+	name = u->name;
 	return name;
 }
 
-void FaceRecognitionService::loopDirect()
+void FaceRecognitionService::holdDetectFor(int ms)
 {
-	cv::Mat frame, frameCopy;
-	DetectedStatus dState;
-	recogResult_t recogResult;
-	while (running_.loadAcquire() == 1) {
-		const bool wantReg = (isRegisteringAtomic.loadRelaxed() != 0);
-		bool acceptedThisFrame = false;
-
-		//syncDoorOpenedFromReed();
-		setDoorOpened(false);	
+	detectHoldUntilMs_.store(QDateTime::currentMSecsSinceEpoch() + ms, std::memory_order_relaxed);
+}
 
-		if(!cap_.read(frame) || frame.empty()) {
+// ── capture 스테이지: 카메라에서 한 장 ──
+bool FaceRecognitionService::captureStage(FrameJob& job)
+{
+	if (v4l2_.isOpened()) {
+		// 드라이버 버퍼는 job.raw 가 참조로 잡는다. YUYV/MJPEG 모두 여기서 변환하지 않음
+		if (!v4l2_.read(job.raw)) return false;
+		job.tsMs = job.raw.tsUs / 1000;		// 커널 캡처 타임스탬프 (큐에서 기다린 시간 무관, 없으면 0)
+	}
+	else {
+		if (!cap_.read(job.frame) || job.frame.empty()) {
 			QThread::msleep(2);
-			continue;
+			return false;
 		}
-		else { 
-			// make snapshot image for android app webcam
-			frameCopy = frame.clone();
-			//imwrite("/tmp/snap.jpg", frameCopy);
+		// 폴백 경로: frame 위에 오버레이를 그리므로 인증 로그용 원본은 따로 보관
+		job.raw.reset();
+		job.raw.raw	   = job.frame.clone();
+		job.raw.width  = job.frame.cols;
+		job.raw.height = job.frame.rows;
+	}
+
+	job.wantReg = (isRegisteringAtomic.loadRelaxed() != 0);
+	return true;
+}
+
+// 인증 로그 스냅샷: 오버레이 전 원본 버퍼에서 필요할 때만 BGR 로 만든다
+cv::Mat FaceRecognitionService::snapshotBgr(const FrameJob& job)
+{
+	const CapturedFrame& r = job.raw;
+	if (r.empty()) return job.frame;
+
+	if (r.fourcc == capfmt::YUYV) {
+		cv::Mat bgr;
+		cv::cvtColor(r.raw, bgr, cv::COLOR_YUV2BGR_YUYV);
+		return bgr;
+	}
+	if (r.fourcc == capfmt::MJPG) {
+		return cv::imdecode(r.raw, cv::IMREAD_COLOR);
+	}
+	return r.raw;
+}
+
+QByteArray FaceRecognitionService::snapshotJpeg(const FrameJob& job)
+{
+	// MJPEG 는 드라이버 버퍼가 이미 JPEG
+	if (job.raw.fourcc == capfmt::MJPG && !job.raw.empty()) {
+		return QByteArray(reinterpret_cast<const char*>(job.raw.raw.data),
+						  static_cast<int>(job.raw.raw.total()));
+	}
+
+	std::vector<uchar> buf;
+	cv::imencode(".jpg", snapshotBgr(job), buf);
+	return QByteArray(reinterpret_cast<const char*>(buf.data()), static_cast<int>(buf.size()));
+}
+
+// ── detect 스테이지: 검출 + 정렬 + 품질 게이트 ──
+void FaceRecognitionService::detectStage(FrameJob& job)
+{
+	// 인증 성공/실패 쿨다운 중엔 검출 자체를 생략 (embed 스테이지가 쿨다운 화면 처리)
+	if (QDateTime::currentMSecsSinceEpoch() < detectHoldUntilMs_.load(std::memory_order_relaxed)) {
+		job.holdDetect = true;
+		return;
+	}
+
+	const bool yuyvIn = (job.raw.fourcc == capfmt::YUYV);
+	const bool jpegIn = (job.raw.fourcc == capfmt::MJPG);
+	const cv::Size frameSize = (yuyvIn || jpegIn) ? cv::Size(job.raw.width, job.raw.height)
+												  : job.frame.size();
+
+	// 1) 전체 검출: 원본 BGR 전체를 만들지 않고 축소 입력을 바로 만든다
+	//    YUYV  -> 2x2 평균+색변환 한 패스로 절반 크기
+	//    MJPEG -> DCT 도메인 축소 디코드 (폭 320 이하)
+	const DetectPolicy& pol = job.wantReg ? regPolicy_ : recogPolicy_;
+	auto fullDetect = [&]() -> std::optional<FaceDet> {
+		if (yuyvIn) {
+			cv::Mat half;
+			yuyv::toBgrHalf(job.raw.raw, half);
+			return detector_.detectBest(half, 2.0f, pol);
+		}
+		if (jpegIn) {
+			cv::Mat small;
+			const int denom = jpeg::denomForWidth(frameSize.width, 320);
+			if (!jpeg::decode(job.raw.raw, denom, jpeg::Color::Bgr, small) || small.empty()) return std::nullopt;
+			return detector_.detectBest(small, float(frameSize.width) / float(small.cols), pol);
 		}
+		return detector_.detectBest(job.frame, 1.0f, pol);
+	};
+
+	// 원본 배율 ROI -> BGR (트래커/정렬 공용)
+	auto fetchRoi = [&](const cv::Rect& want, cv::Rect* used) -> cv::Mat {
+		if (yuyvIn) return yuyv::roiToBgr(job.raw.raw, want, used);
+		if (jpegIn) {
+			cv::Mat out;
+			if (!jpeg::decodeRoi(job.raw.raw, want, out, used)) out.release();
+			return out;
+		}
+		const cv::Rect r = want & cv::Rect(0, 0, job.frame.cols, job.frame.rows);
+		if (used) *used = r;
+		return r.area() > 0 ? job.frame(r) : cv::Mat();
+	};
+
+	// 추적 중엔 직전 얼굴 주변 ROI 만 검출, 주기적으로/놓쳤을 때만 전체 검출
+	std::optional<FaceDet> best = tracker_.update(frameSize, fullDetect, fetchRoi);
+	if (!best) {
+		job.status = DetectedStatus::FaceNotDetected;
+		return;
+	}
 
-		// Find CV Frame Color order
-		// drawColorProbe(frame);
-		// cv::imshow("test", frame);
+	const FaceDet& fd = *best;
+
+	// 2) 정렬: 얼굴 주변 ROI 만 원본 배율 BGR 로 만들어 워프 (src 좌표 원점 = srcOrg)
+	cv::Mat src = job.frame;
+	cv::Point srcOrg(0, 0);
+	if (yuyvIn || jpegIn) {
+		cv::Rect used;
+		src	   = fetchRoi(expandRect(fd.box, 2.0f, frameSize), &used);
+		srcOrg = used.tl();
+	}
+
+	std::array<cv::Point2f,5> lmk = fd.lmk;
+	for (auto& p : lmk) p -= cv::Point2f(srcOrg);
+
+	const cv::Size alignSize = embedInputSize();
+	cv::Mat aligned;
+	if (!src.empty()) aligned = alignBy5pts(src, lmk, alignSize);
+	if (aligned.empty() && !src.empty()) {
+		cv::Rect roi = (expandRect(fd.box, 1.3f, frameSize) - srcOrg) & cv::Rect(0, 0, src.cols, src.rows);
+		if (roi.area() > 0) {
+			cv::Mat crop = src(roi).clone();
+			if (!crop.empty()) aligned = letterboxSquare(crop, alignSize.width);
+		}
+	}
+	if (aligned.empty()) {
+		job.status = DetectedStatus::FaceNotDetected;
+		return;
+	}
+
+	job.hasFace = true;
+	job.face.det	 = fd;
+	job.face.aligned = std::move(aligned);
+
+	// 3) 품질 체크 (인식 모드에서만): 얼굴 박스 안만
+	//    YUYV 는 원본 버퍼의 Y 를 바로, 그 외는 정렬에 쓴 ROI(MJPEG 는 이미 디코드됨)를 그대로
+	if (job.wantReg) {
+		job.status = DetectedStatus::Registering;
+		return;
+	}
+	const cv::Mat&	qImg = yuyvIn ? job.raw.raw : src;
+	const cv::Point qOrg = yuyvIn ? cv::Point(0, 0) : srcOrg;
+	FaceStats qs;
+	job.status = liveness_.passQualityForRecog(fd.box, frameSize, qImg, qOrg, &qs);
+	job.face.qualityOk = (job.status == DetectedStatus::FaceDetected);
 
-		// loopDirect() 안에서, frame 읽은 직후쯤
-		// const qint64 now = QDateTime::currentMSecsSinceEpoch();
+	// 4) 시간축 라이브니스: 품질과 무관하게 매 프레임 샘플을 쌓는다 (같은 영상/좌표 규약)
+	job.live = temporalLive_.update(fd, job.tsMs, qImg, qOrg).verdict;
 
-		// "문 열림 화면을 보여줄지"는 두 조건의 OR
-		// 2) 실제 리드센서가 열림 (!g_reed.isClosed())
-		int readDoorState = g_reed.isClosed();
+	// 5) 프레임 선택: 품질 통과 얼굴만 후보로, 고른 프레임에서만 임베딩
+	if (job.face.qualityOk) {
+		job.pickScore = frameSelector_.offer(fd, qs.blurVar, job.tsMs, job.face, job.pick);
+	}
+}
 
-		/*
-		   if (!readDoorState) {
-		   showOpenImage(); // 내부에서 emit frameReady(...)
-		   emit doorStateChanged(States::DoorState::Open);
-		   presenter->onDoorAuth(false, recogResult.idx, recogResult.sim, 1000);
+// ── embed 스테이지: 임베딩 + 매칭 + 인증 판정 + 화면 출력 ──
+void FaceRecognitionService::embedStage(FrameJob& job)
+{
+	// 프리뷰/오버레이용 BGR: 원본 포맷에서 여기서 한 번만 만든다
+	if (job.frame.empty() && job.raw.fourcc == capfmt::YUYV) {
+		cv::cvtColor(job.raw.raw, job.frame, cv::COLOR_YUV2BGR_YUYV);
+	}
+	else if (job.frame.empty() && job.raw.fourcc == capfmt::MJPG) {
+		// 프리뷰는 640 폭이면 충분 -> 720p 이상은 축소 디코드, 오버레이 좌표도 같은 배율로
+		const int denom = jpeg::denomForWidth(job.raw.width, 640);
+		if (!jpeg::decode(job.raw.raw, denom, jpeg::Color::Bgr, job.frame) || job.frame.empty()) return;
+		job.previewScale = float(job.frame.cols) / float(job.raw.width);
+	}
 
-		   {
-		   QMutexLocker lk(&snapMu_);
-		   resetFailCount();					
-		   authManager.resetAuth();
-		   resetUnlockFlag();
-		   setAllowEntry(true);
-		   }
+	cv::Mat& frame = job.frame;
+	const bool wantReg = job.wantReg;
+	bool acceptedThisFrame = false;
+	DetectedStatus dState;
+	recogResult_t recogResult;
 
+	//syncDoorOpenedFromReed();
+	setDoorOpened(false);	
 
-		   QThread::msleep(1);
-		   continue; // 오버레이 중엔 일반 파이프라인 잠시 멈춤
-		   }
-		   else {
-		   emit doorStateChanged(States::DoorState::Locked);
-		   }
-		 */
+	// "문 열림 화면을 보여줄지"는 두 조건의 OR
+	// 2) 실제 리드센서가 열림 (!g_reed.isClosed())
+	int readDoorState = g_reed.isClosed();
 
+	showFarImage(frame);
+	double dist = g_uls.latestDist();
+	if (dist > 50.0) {
 		showFarImage(frame);
-		double dist = g_uls.latestDist();
-		if (dist > 50.0) {
-			showFarImage(frame);
-			//continue;
+		//continue;
+	}
+
+	constexpr int authCooldownMs = 4000;
+	if (authCooldown.isValid() && authCooldown.elapsed() < authCooldownMs) {
+		{
+			QMutexLocker lk(&snapMu_);
+			resetFailCount();
+			resetAuthStreak();
+			authManager.resetAuth();
+			resetUnlockFlag();
+			setAllowEntry(false);
+			setRegisterRequested(false);
+
+			setFacePresent(false);
+			setDetectScore(0.0);
+			setRecogConfidence(0.0);
+			setLivenessOk(true);
+			setAllowEntry(acceptedThisFrame);
+			setDoorSensorOpen(!g_reed.isClosed());
 		}
-		// qDebug() << "[loopframRDirect] dist: " << dist;
+		printFrame(frame, DetectedStatus::AuthSuccessed);
+		return;
+	}
 
-		if (frame.empty()) {
-			qWarning() << "[loopDirect] frame is empty after consume()";
-			continue;
+	constexpr int failCooldownMs = 4000;
+	if (failCooldown.isValid() && failCooldown.elapsed() < failCooldownMs) {
+		{
+			QMutexLocker lk(&snapMu_);
+			resetFailCount();
+			resetAuthStreak();
+			authManager.resetAuth();
+			resetUnlockFlag();
+			setAllowEntry(false);
+			setRegisterRequested(false);
+
+			setFacePresent(false);
+			setDetectScore(0.0);
+			setRecogConfidence(0.0);
+			setLivenessOk(true);
+			setAllowEntry(acceptedThisFrame);
+			setDoorSensorOpen(!g_reed.isClosed());
 		}
+		printFrame(frame, DetectedStatus::AuthFailed);
+		return;
+	}
 
-		// ── 3) trivial 체크 ──
-		/*
-		if (dnnEmbedder_ && dnnEmbedder_->isTrivialFrame(frame, 30.0, 10.0)) {
-			qWarning() << "[loopDirect] Trivial frame. skip";
-			emit frameReady(QImage());
-			continue;
+	// 쿨다운이 막 끝난 프레임: 검출 결과가 없으니 다음 프레임부터 처리
+	if (job.holdDetect) {
+		printFrame(frame, DetectedStatus::FaceNotDetected);
+		return;
+	}
+
+	// ── 4) 얼굴 검출 결과 ──
+	if (!job.hasFace) {
+		printFrame(frame, DetectedStatus::FaceNotDetected); 
+		return;
+	}
+
+	// FSM 상태 초기화
+	{
+		QMutexLocker lk(&snapMu_);
+		setFacePresent(true);
+		setRegisterRequested(wantReg);
+		setLivenessOk(wantReg || job.live == LiveVerdict::Live);
+		setDuplicate(false);
+	}
+
+	// ── 5) 얼굴 처리 ──
+	FaceDet fd = job.face.det;
+	FaceDetector::scaleDet(fd, job.previewScale);		// 프리뷰(frame) 좌표계로
+	const double maxDetect = static_cast<double>(fd.score);
+	setDetectScore(maxDetect);
+
+	// 트랙이 바뀌면(다른 사람) 연속 인식 카운트를 이어가지 않는다
+	if (fd.trackId != lastTrackId_) {
+		if (lastTrackId_ >= 0) {
+			QMutexLocker lk(&snapMu_);
+			resetAuthStreak();
 		}
-		*/
+		lastTrackId_ = fd.trackId;
+		lastRecogLabel_.clear();
+	}
+
+	QString label;
+	cv::Scalar color;
 
-		constexpr int authCooldownMs = 4000;
-		if (authCooldown.isValid() && authCooldown.elapsed() < authCooldownMs) {
+	if (!wantReg) {
+		// 품질 체크 (detect 스테이지 결과)
+		dState = job.status;
+		if (dState != DetectedStatus::FaceDetected) {
+			printFrame(frame, dState);
 			{
 				QMutexLocker lk(&snapMu_);
+
 				resetFailCount();
 				resetAuthStreak();
 				authManager.resetAuth();
 				resetUnlockFlag();
 				setAllowEntry(false);
-				setRegisterRequested(false);
-
-				setFacePresent(false);
-				setDetectScore(0.0);
-				setRecogConfidence(0.0);
-				setLivenessOk(true);
-				setAllowEntry(acceptedThisFrame);
-				setDoorSensorOpen(!g_reed.isClosed());
 			}
-			printFrame(frame, DetectedStatus::AuthSuccessed);
-			continue;
+			return;
 		}
 
-		constexpr int failCooldownMs = 4000;
-		if (failCooldown.isValid() && failCooldown.elapsed() < failCooldownMs) {
+		// 위조 의심: 임베딩/매칭 없이 종료 (FSM 은 livenessOk=false 로 실패 처리)
+		if (job.live == LiveVerdict::Spoof) {
+			printFrame(frame, DetectedStatus::Spoof);
 			{
 				QMutexLocker lk(&snapMu_);
-				resetFailCount();
+
 				resetAuthStreak();
 				authManager.resetAuth();
 				resetUnlockFlag();
 				setAllowEntry(false);
-				setRegisterRequested(false);
-
-				setFacePresent(false);
-				setDetectScore(0.0);
 				setRecogConfidence(0.0);
-				setLivenessOk(true);
-				setAllowEntry(acceptedThisFrame);
-				setDoorSensorOpen(!g_reed.isClosed());
 			}
-			printFrame(frame, DetectedStatus::AuthFailed);
-			continue;
+			return;
 		}
-
-		// ── 4) 얼굴 검출 ──
-		std::vector<FaceDet> faces;
-		if (auto best = detectBestYuNet(frame)) {
-			faces.push_back(*best);
+		const bool live = (job.live == LiveVerdict::Live);
+
+		// 선택 사이 프레임: 임베딩/판정 없이 직전 결과만 표시 (카운터/FSM 입력 유지)
+		if (job.pick.empty()) {
+			if (!lastRecogLabel_.isEmpty()) {
+				drawCornerBox(frame, fd.box, lastRecogColor_, 2, 25);
+				putText(frame, lastRecogLabel_.toStdString(), {fd.box.x, fd.box.y - 10},
+						cv::FONT_HERSHEY_DUPLEX, 0.9, lastRecogColor_, 2);
+			}
+			printFrame(frame, live ? DetectedStatus::FaceDetected : DetectedStatus::LivenessCheck);
+			return;
 		}
-		else {
-			printFrame(frame, DetectedStatus::FaceNotDetected); 
-			continue;
+
+		// 임베딩 (이 스테이지의 주 비용)
+		if (job.needsEmbedding() && dnnEmbedder_) {
+			// 1차 유사도가 판정 임계값에서 멀면 flip-TTA 생략
+			auto needTta = [this](const std::vector<float>& first) {
+				if (gallery()->isEmpty()) return false;
+				const MatchResult r = matcher_->bestMatch(first);
+				return std::abs(r.sim - static_cast<float>(params_.recogEnter)) < recog::TTA_MARGIN;
+			};
+			if (!dnnEmbedder_->extract(job.pick.aligned, job.pick.embedding, needTta)) job.pick.embedding.clear();
 		}
 
-		// FSM 상태 초기화
-		{
-			QMutexLocker lk(&snapMu_);
-			setFacePresent(!faces.empty());
-			setRegisterRequested(wantReg);
-			setLivenessOk(true);
-			setDuplicate(false);
+		// 인식 처리 (선택된 얼굴의 임베딩, 박스는 현재 프레임)
+		recogResult = handleRecognition(frame, fd.box, job.pick, label, color);
+		lastRecogLabel_ = label;
+		lastRecogColor_ = color;
+
+		if (recogResult.result == AUTH_SUCCESSED) {
+			acceptedThisFrame = true;
+			dState = DetectedStatus::FaceDetected;
+		}
+		else if (recogResult.result == AUTH_FAILED) {
+			acceptedThisFrame = false;
 		}
 
-		double maxDetect = 0.0;
-		// ── 5) 얼굴별 처리 ──
-		for (const auto& fd : faces) {
-			maxDetect = std::max(maxDetect, static_cast<double>(fd.score));
-			setDetectScore(maxDetect);
-			//qDebug() << "[loopDirect] maxDetect:" << maxDetect;
-
-			cv::Mat aligned = alignBy5pts(frame, fd.lmk, cv::Size(128,128));
-			if (aligned.empty()) {
-				cv::Rect roi = expandRect(fd.box, 1.3f, frame.size());
-				if (roi.area() > 0) {
-					cv::Mat crop = frame(roi).clone();
-					if (!crop.empty()) aligned = letterboxSquare(crop, 128);
-				}
+		if (!acceptedThisFrame) {
+			{
+				QMutexLocker lk(&snapMu_);
+				setAllowEntry(false);
+				incFailCount();
+				authManager.handleAuthFailure();
+				qDebug() << "[embedStage] failCount:" << failCount_;
+			}
+		} else if (!live) {
+			// 등록된 얼굴이지만 라이브니스 판정 전: 실패로 세지 않고 통과도 보류
+			acceptedThisFrame = false;
+			dState = DetectedStatus::LivenessCheck;
+			{
+				QMutexLocker lk(&snapMu_);
+				setAllowEntry(false);
+			}
+		} else {
+			{
+				QMutexLocker lk(&snapMu_);
+				resetFailCount();
+				tryIncStreakCooldown(recogResult.idx, [&]() { incAuthStreak(); });
+				//incAuthStreak();
 			}
-			if (aligned.empty()) continue;
 
-			QString label;
-			cv::Scalar color;
+			authManager.handleAuthSuccess(authStreak_);
+			if (!hasAlreadyUnlocked && authManager.shouldAllowEntry(recogResult.name)) {
+				setAllowEntry(true);
+				authCooldown.restart();
+				holdDetectFor(authCooldownMs);
+				if	(!g_unlockMgr.running()) {
+					g_unlockMgr.start(); qInfo() << "[embedStage] Unlock started (wait open, then wait close)";
+				}
+				qDebug() << "hasAlreadyUnlocked: " << (int)hasAlreadyUnlocked;
 
+				// DB 로그 저장(JPEG → BLOB)
+				const QByteArray blob = snapshotJpeg(job);
 
-			if (!wantReg) {
-				// 품질 체크
-				dState = liveness_.passQualityForRecog(fd.box, frame);
-				if (dState != DetectedStatus::FaceDetected) {
-					printFrame(frame, dState);
-					{
-						QMutexLocker lk(&snapMu_);
+				db->insertAuthLog(recogResult.name, QStringLiteral("인식 성공"),
+						QDateTime::currentDateTime(), blob);
 
-						resetFailCount();
-						resetAuthStreak();
-						authManager.resetAuth();
-						resetUnlockFlag();
-						setAllowEntry(false);
-					}
+				hasAlreadyUnlocked = true;	
+			}
+		}
+		// FSM 
+		{
+			QMutexLocker lk(&snapMu_);
 
-					continue;
-				}
 
+			// AuthStreak 처리
+			if (authStreak_ >= params_.authThresh) {
+				presenter->onDoorAuth(true, recogResult.idx, recogResult.sim, 1000);
+				resetAuthStreak();
+				authManager.resetAuth();
+				resetUnlockFlag();
+				setAllowEntry(false);
+				setRecogConfidence(0.0);
+			}
 
-				// 인식 처리
-				recogResult = handleRecognition(frame, fd.box, aligned, label, color);
+			// FailCount 처리
+			if (failCount_ >= params_.lockoutFails) {
+				presenter->onDoorAuth(false, recogResult.idx, recogResult.sim, 1000);
 
-				const int nUsers  = std::max(0, (int)gallery_.size());
+				// DB 로그 저장(JPEG → BLOB)
+				const QByteArray blob = snapshotJpeg(job);
 
-				if (recogResult.result == AUTH_SUCCESSED) {
-					acceptedThisFrame = true;
-					dState = DetectedStatus::FaceDetected;
-				}
-				else if (recogResult.result == AUTH_FAILED) {
-					acceptedThisFrame = false;
-				}
+				db->insertAuthLog(recogResult.name, QStringLiteral("인식 실패"),
+						QDateTime::currentDateTime(), blob);
 
-				if (!acceptedThisFrame) {
-					{
-						QMutexLocker lk(&snapMu_);
-						setAllowEntry(false);
-						incFailCount();
-						authManager.handleAuthFailure();
-						qDebug() << "[loopDirect] failCount:" << failCount_;
-					}
-				} else {
-					{
-						QMutexLocker lk(&snapMu_);
-						resetFailCount();
-						tryIncStreakCooldown(recogResult.idx, [&]() { incAuthStreak(); });
-						//incAuthStreak();
-					}
-
-					authManager.handleAuthSuccess(authStreak_);
-					if (!hasAlreadyUnlocked && authManager.shouldAllowEntry(recogResult.name)) {
-						setAllowEntry(true);
-						authCooldown.restart();
-						if	(!g_unlockMgr.running()) {
-							g_unlockMgr.start(); qInfo() << "[loopDirect] Unlock started (wait open, then wait close)";
-							}
-						qDebug() << "hasAlreadyUnlocked: " << (int)hasAlreadyUnlocked;
-
-						// DB 로그 저장(JPEG → BLOB)
-						std::vector<uchar> buf;
-						cv::imencode(".jpg", frameCopy, buf);
-						QByteArray blob(reinterpret_cast<const char*>(buf.data()),
-								static_cast<int>(buf.size()));
-
-						db->insertAuthLog(recogResult.name, QStringLiteral("인식 성공"),
-								QDateTime::currentDateTime(), blob);
-
-						hasAlreadyUnlocked = true;	
-					}
-				}
-				// FSM 
-				{
-					QMutexLocker lk(&snapMu_);
-
-
-					// AuthStreak 처리
-					if (authStreak_ >= params_.authThresh) {
-						presenter->onDoorAuth(true, recogResult.idx, recogResult.sim, 1000);
-						resetAuthStreak();
-						authManager.resetAuth();
-						resetUnlockFlag();
-						setAllowEntry(false);
-						setRecogConfidence(0.0);
-					}
-
-					// FailCount 처리
-					if (failCount_ >= params_.lockoutFails) {
-						presenter->onDoorAuth(false, recogResult.idx, recogResult.sim, 1000);
-
-						// DB 로그 저장(JPEG → BLOB)
-						std::vector<uchar> buf;
-						cv::imencode(".jpg", frameCopy, buf);
-						QByteArray blob(reinterpret_cast<const char*>(buf.data()),
-								static_cast<int>(buf.size()));
-
-						db->insertAuthLog(recogResult.name, QStringLiteral("인식 실패"),
-								QDateTime::currentDateTime(), blob);
-
-						resetFailCount();					
-						authManager.resetAuth();
-						resetUnlockFlag();
-						setAllowEntry(false);
-						setRecogConfidence(0.0);
-
-						failCooldown.restart();
-					}
-
-					setFacePresent(!faces.empty());
-					setDetectScore(maxDetect);
-					setRecogConfidence(recogResult.sim);
-					setLivenessOk(true);
-					setAllowEntry(acceptedThisFrame);
-					setDoorSensorOpen(!g_reed.isClosed());
-				}
-				printFrame(frame, dState);
-			}
-			else {
-				// 등록 모드
-				dState = handleRegistration(frame, fd.box, aligned, label, color);
-
-				{
-					QMutexLocker lk(&snapMu_);
-					resetFailCount();
-					resetAuthStreak();
-					authManager.resetAuth();
-					resetUnlockFlag();
-					setAllowEntry(false);
-					setRegisterRequested(true);
-
-					setFacePresent(!faces.empty());
-					setDetectScore(maxDetect);
-					setRecogConfidence(0.0);
-					setLivenessOk(true);
-					setAllowEntry(acceptedThisFrame);
-					setDoorSensorOpen(!g_reed.isClosed());
-				}
+				resetFailCount();					
+				authManager.resetAuth();
+				resetUnlockFlag();
+				setAllowEntry(false);
+				setRecogConfidence(0.0);
 
-				printFrame(frame, dState);
+				failCooldown.restart();
+				holdDetectFor(failCooldownMs);
 			}
 
-			if (faces.empty()) setRecogConfidence(0.0);
-
+			setFacePresent(true);
+			setDetectScore(maxDetect);
+			setRecogConfidence(recogResult.sim);
+			setLivenessOk(live);
+			setAllowEntry(acceptedThisFrame);
+			setDoorSensorOpen(!g_reed.isClosed());
+		}
+		printFrame(frame, dState);
+	}
+	else {
+		// 등록 모드
+		dState = handleRegistration(frame, fd.box, job.face, label, color);
 
-			// CPU 과점유 방지 (필요 시 0~2ms)
-			QThread::msleep(1);
+		{
+			QMutexLocker lk(&snapMu_);
+			resetFailCount();
+			resetAuthStreak();
+			authManager.resetAuth();
+			resetUnlockFlag();
+			setAllowEntry(false);
+			setRegisterRequested(true);
+
+			setFacePresent(true);
+			setDetectScore(maxDetect);
+			setRecogConfidence(0.0);
+			setLivenessOk(true);
+			setAllowEntry(acceptedThisFrame);
+			setDoorSensorOpen(!g_reed.isClosed());
 		}
+
+		printFrame(frame, dState);
 	}
 }
 
@@ -1682,6 +2309,14 @@ void FaceRecognitionService::printFrame(cv::Mat &frame, DetectedStatus hasBase)
         draw(QStringLiteral("얼굴 중앙이 흐릿해요."));
         break;
     }
+    case DetectedStatus::LivenessCheck: {
+        draw(QStringLiteral("고개를 살짝 움직여주세요."));
+        break;
+    }
+    case DetectedStatus::Spoof: {
+        draw(QStringLiteral("실제 얼굴이 아닙니다."), QColor(255, 0, 0));
+        break;
+    }
     case DetectedStatus::Registering: {
         draw(QStringLiteral("등록 중입니다."), QColor(0,0,255));
         break;
@@ -1741,10 +2376,23 @@ void FaceRecognitionService::printFrame(cv::Mat &frame, DetectedStatus hasBase)
         cv::resize(frame, frame, cv::Size(640, 480), 0, 0, cv::INTER_AREA);
     }
 
-    cv::Mat rgb;
-    cv::cvtColor(frame, rgb, cv::COLOR_BGR2RGB);
-    QImage qimg(rgb.data, rgb.cols, rgb.rows, rgb.step, QImage::Format_RGB888);
-    emit frameReady(qimg.copy());
+    // BGR 버퍼를 그대로 참조하는 QImage (변환/복사 없음)
+    emit frameReady(toQImage(frame));
+}
+
+// cv::Mat 헤더를 QImage 수명에 묶는다: 마지막 QImage 참조가 사라질 때 Mat 참조 해제
+static void releaseMatRef(void* info)
+{
+	delete static_cast<cv::Mat*>(info);
+}
+
+QImage FaceRecognitionService::toQImage(const cv::Mat& bgr)
+{
+	if (bgr.empty() || bgr.type() != CV_8UC3) return QImage();
+
+	auto* hold = new cv::Mat(bgr);		// refcount 증가만 (deep copy 아님)
+	return QImage(hold->data, hold->cols, hold->rows, static_cast<qsizetype>(hold->step),
+				  QImage::Format_BGR888, releaseMatRef, hold);
 }
 
 // === 스냅샷 API ===
@@ -20,10 +20,14 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QElapsedTimer>
+#include <QFileSystemWatcher>
 
 // STL
 #include <atomic>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <map>
 #include <string>
@@ -52,12 +56,22 @@
 #include "services/AuthManager.hpp"
 
 #include "liveness/LivenessGate.hpp"
+#include "liveness/TemporalLiveness.hpp"
 
 #include "match/FaceMatcher.hpp"
+#include "match/EmbeddingJournal.hpp"
+#include "match/EmbeddingStore.hpp"
+#include "services/GalleryService.hpp"
 #include "match/SimilarityDecision.hpp"
 
 #include "detect/LandmarkAligner.hpp"
 #include "detect/FaceDetector.hpp"
+#include "detect/FaceTracker.hpp"
+
+// Pipeline
+#include "capture/V4l2Capture.hpp"
+#include "pipeline/RecognitionPipeline.hpp"
+#include "pipeline/FrameSelector.hpp"
 
 // FSM 
 #include "fsm/recognition_fsm.hpp"
@@ -66,6 +80,46 @@
 // Camera number
 #define CAM_NUM							-1	
 
+// Camera format / resolution (MJPEG 는 USB 대역폭 여유 -> 720p 풀 프레임레이트)
+#define CAM_USE_MJPEG					0
+#define CAM_WIDTH						640
+#define CAM_HEIGHT						480
+
+// Gallery matrix storage (0=F32, 1=F16, 2=INT8 -> 상위 후보는 float 원본으로 정확 재계산)
+#define GALLERY_STORAGE					0
+
+// 검출 정책 축소 방식 (0=Native 입력 그대로, 1=Fixed 320x240 안으로, 2=Auto 최소 얼굴 기준 축소)
+//  CENTER_WINDOW=1 이면 중앙 오프셋 규칙(품질 게이트) 밖 영역은 검출하지 않음
+//  등록은 사용자가 자리 잡는 중이라 기본값이 전체 프레임/원래 해상도
+#define DETECT_RECOG_SCALE				2
+#define DETECT_RECOG_CENTER_WINDOW		1
+#define DETECT_REG_SCALE				0
+#define DETECT_REG_CENTER_WINDOW		0
+
+// 시간축 라이브니스 (TemporalLiveness::Options)
+//  진입은 코 아핀 좌표 흔들림(시차) + 비강체 미세 움직임, 텍스처(LBP 비균일 비율)가 상한을 넘으면 위조
+//  고개를 돌리지 않아 FALLBACK_FRAMES 동안 판정이 안 나면 더 엄격한 텍스처 상한으로 결정
+#define LIVENESS_WINDOW					16
+#define LIVENESS_MIN_FRAMES				8
+#define LIVENESS_MIN_PARALLAX			0.04f
+#define LIVENESS_MIN_MOTION				0.004f
+#define LIVENESS_MAX_NONUNIFORM			0.30f
+#define LIVENESS_FALLBACK_FRAMES		45
+#define LIVENESS_FALLBACK_NONUNIFORM	0.22f
+
+// embeddings.bin 저장 시 디버깅용 JSON 사본도 기록 (embeddings.json)
+#define EMBEDDING_JSON_EXPORT			0
+
+// 갤러리 저널이 이 크기를 넘으면 embeddings.bin 으로 백그라운드 압축 (bytes)
+#define EMBEDDING_JOURNAL_COMPACT_BYTES	(256 * 1024)
+
+// 저장소 외부 변경 감지 후 재적재까지 대기 (연속 쓰기를 한 번으로 묶음, ms)
+#define EMBEDDING_RELOAD_DEBOUNCE_MS	500
+
+// 정렬 얼굴 디버그 덤프 (30프레임마다 한 장, 별도 스레드에서 PNG 저장)
+#define ALIGN_DEBUG_DUMP				0
+#define ALIGN_DEBUG_DUMP_DIR			"/tmp/align_dump/"
+
 // Recognition Result
 #define AUTH_SUCCESSED 					1
 #define AUTH_FAILED						0
@@ -104,6 +158,7 @@ class FaceRecognitionService : public QObject {
 	public:
 		explicit FaceRecognitionService(QObject* parent = nullptr,
 				FaceRecognitionPresenter* presenter = nullptr , QSqliteService* db = nullptr);
+		~FaceRecognitionService() override;
 		int staticDoorStateChange(bool state);	
 
 		void requestedDoorOpen();
@@ -114,6 +169,8 @@ class FaceRecognitionService : public QObject {
 
 		// Presenter 연결
 		void setPresenter(FaceRecognitionPresenter* presenter);
+		// 갤러리 메타데이터 게시 대상 (연결 즉시 현재 갤러리/이미지 게시)
+		void setGalleryService(GalleryService* gallery);
 
 		// 등록 제어
 		void startRegistering(const QString& name);
@@ -129,7 +186,25 @@ class FaceRecognitionService : public QObject {
 		bool startDirectCapture(int cam = 0);
 		void stopDirectCapture(); 
 
+		// 캡처 포맷/해상도 (다음 startDirectCapture / camRestart 부터 적용)
+		struct CaptureConfig {
+			bool mjpeg	= (CAM_USE_MJPEG != 0);
+			int  width	= CAM_WIDTH;
+			int  height	= CAM_HEIGHT;
+			int  fps	= 30;
+		};
+		void setCaptureConfig(const CaptureConfig& cfg) { camCfg_ = cfg; }
+
 		QString nameFromId(int userId);
+
+		// 파이프라인 스테이지별 큐 깊이/드롭 통계
+		RecognitionPipeline::Stats pipelineStats() const { return pipeline_.stats(); }
+
+		// USER_FACES_DIR 의 등록 이미지로 갤러리 재임베딩 (모델 교체/임베딩 파일 유실 시)
+		bool rebuildGalleryFromImages();
+
+		// 사용자 한 명 삭제 (갤러리 + 저널 + 등록 이미지)
+		bool deleteUser(int id);
 signals:
 		// 상태 변경 (FSM → UI)
 		void stateChanged(RecognitionState s);
@@ -177,6 +252,26 @@ public slots:
 		// 파일 IO
 		bool loadEmbeddingsFromFile();
 		bool saveEmbeddingsToFile() const;
+		static QString annIndexPath();
+		static QString journalPath();
+		void commitGalleryChange(uint64_t seq);			// 저널 레코드 확정 후 압축 / 실패 시 전체 저장 (embMutex_ 밖)
+		void compactGalleryAsync();
+
+		// 저장소 감시 (다른 프로세스/프로비저닝 도구의 변경 -> 백그라운드 재적재)
+		struct StoreStamp {
+			quint64 ino	  = 0;
+			qint64	size  = 0;
+			qint64	mtime = 0;				// ns
+			bool operator==(const StoreStamp& o) const { return ino == o.ino && size == o.size && mtime == o.mtime; }
+		};
+		static StoreStamp storeStamp(const QString& path);
+		void noteOwnBaseWrite() const;					// 자기 쓰기는 감시 이벤트에서 제외
+		bool storeChangedExternally();
+		void watchEmbeddingStore();
+		void rewatchStoreFiles();
+		void reloadGalleryAsync();
+		static QString legacyJsonPath();
+		bool migrateLegacyJson();
 		void showOpenImage();
 		void showFarImage(Mat& frame);
 
@@ -197,14 +292,18 @@ public slots:
 		// 등록 파이프라인
 		DetectedStatus handleRegistration(cv::Mat& frame,
 				const cv::Rect& face,
-				const cv::Mat& alignedFace,
+				FaceSample& sample,
 				QString& labelText,
 				cv::Scalar& boxColor);
-		void saveCapturedFace(const cv::Rect& face,
-				const cv::Mat& alignedFace,
+		void saveCapturedFace(const FaceSample& sample,
 				const cv::Mat& frame);
 		void finalizeRegistration();
-		bool isDuplicateFaceDNN(const cv::Mat& alignedFace, int* dupIdOut, float* simOut) const;
+		bool isDuplicateFaceDNN(FaceSample& sample, int* dupIdOut, float* simOut) const;
+		bool ensureEmbedding(FaceSample& sample) const;		// 비어 있을 때만 추출
+		// 갤러리 (RCU): 읽기는 스냅샷 포인터 한 번 잡고 락 없이, 쓰기는 현재 스냅샷 + 변경분(delta) -> 새 스냅샷 게시
+		GallerySnapshot::Ptr gallery() const;
+		uint64_t updateGallery(const std::function<void(const GallerySnapshot&, GalleryDelta&)>& edit);		// 저널 seq (없으면 0)
+		void publishGallery();							// 매처의 현재 스냅샷 -> GalleryService
 
 		void drawAnglePrompt(cv::Mat& frame, const QString& text);
 		void drawProgressBar(cv::Mat& frame);
@@ -214,7 +313,7 @@ public slots:
 		// 인식 파이프라인
 		recogResult_t handleRecognition(cv::Mat& frame,
 				const cv::Rect& face,
-				const cv::Mat& alignedFace,
+				const FaceSample& sample,
 				QString& labelText,
 				cv::Scalar& boxColor);
 		MatchTop2 bestMatchTop2(const std::vector<float>& emb) const;
@@ -228,9 +327,10 @@ public slots:
 		// FSM
 		bool computeTimeout(const FsmContext& c);
 		cv::Mat alignBy5pts(const cv::Mat& srcBgr, const std::array<cv::Point2f,5>& src5_in, const cv::Size& outSize);
+		cv::Size embedInputSize() const;
 
-		std::vector<FaceDet> detectAllYuNet(const cv::Mat& bgr) const;
-		std::optional<FaceDet> detectBestYuNet(const cv::Mat& bgr) const;
+		std::vector<FaceDet> detectAllYuNet(const cv::Mat& bgr);
+		std::optional<FaceDet> detectBestYuNet(const cv::Mat& bgr);
 
 		bool detectAndAlign(const cv::Mat& bgr, FaceDet& outDet, cv::Mat& outAligned);
 		static QImage toQImage(const cv::Mat& bgr);
@@ -242,12 +342,20 @@ public slots:
 		// ===== 멤버 =====
 		FaceRecognitionPresenter* presenter = nullptr;
 
-		// 카메라
-		QAtomicInt running_{0};					
-		QThread* capThread_ = nullptr;
+		// 카메라 (V4L2 mmap 우선, 실패 시 cv::VideoCapture 폴백)
+		V4l2Capture		 v4l2_;
 		cv::VideoCapture cap_;
+		CaptureConfig	 camCfg_;
+
+		// capture -> detect -> embed 파이프라인 (pipeline_ 자체는 스테이지가 쓰는 멤버 뒤, 맨 끝에 선언)
+		std::atomic<qint64>  detectHoldUntilMs_{0};		// 쿨다운 중 검출 생략 기한
 
-		void loopDirect();
+		bool captureStage(FrameJob& job);
+		void detectStage(FrameJob& job);
+		void embedStage(FrameJob& job);
+		void holdDetectFor(int ms);
+		static cv::Mat snapshotBgr(const FrameJob& job);
+		static QByteArray snapshotJpeg(const FrameJob& job);
 
 		// YuNet
 		cv::Ptr<cv::FaceDetectorYN> yunet_;
@@ -258,8 +366,15 @@ public slots:
 		// 컨텍스트 스냅샷 -> FSM
 		// 갤러리 및 임베딩 파일 경로
 		QString							embeddingsPath_;
-		std::vector<UserEmbedding>		gallery_;
-		mutable QMutex				    embMutex_;
+		mutable QMutex				    embMutex_;			// 스냅샷 교체 + 저널 기록 순서, 전체 저장, 로드 시 기반 교체 판단 (스냅샷 구성/매핑/재적용은 락 밖, 읽기는 스냅샷)
+		std::unique_ptr<EmbeddingJournal> journal_;			// embeddings.bin 이후 변경 (WAL)
+		GalleryService*					galleryService_ = nullptr;
+		QFileSystemWatcher				storeWatcher_{this};
+		QTimer							reloadDebounce_{this};
+		std::thread						reloadTh_;
+		std::atomic<bool>				reloading_{false};
+		mutable std::mutex				stampMutex_;
+		mutable StoreStamp				baseStamp_;			// 마지막으로 읽거나 쓴 embeddings.bin (stampMutex_)
 		std::atomic<int>				nextIdCounter_{1};
 
 		// 등록 파이프 라인 
@@ -281,7 +396,7 @@ public slots:
 		int								registeringUserId_ = -1;
 		int								captureCount = 0;
 
-		std::vector<std::vector<float>> regEmbedsBuffers_;
+		std::vector<std::vector<float>> regEmbeds_;			// 캡처마다 추출한 임베딩 -> finalize 에서 평균 + makePrototypes
 		std::vector<cv::Mat>            regImageBuffers_;
 
 
@@ -330,8 +445,16 @@ public slots:
 		QElapsedTimer failCooldown;
 
 		LivenessGate		liveness_;
+		TemporalLiveness	temporalLive_;		// detect 스테이지 전용
 		LandmarkAligner		aligner_;
 		FaceDetector		detector_;
+		DetectPolicy		recogPolicy_;		// 인식 모드 검출 정책 (기본 정책으로도 설정)
+		DetectPolicy		regPolicy_;			// 등록 모드 검출 정책
+		FaceTracker			tracker_;			// detect 스테이지 전용
+		FrameSelector		frameSelector_;		// detect 스테이지 전용
+		int					lastTrackId_ = -1;	// embed 스테이지 전용
+		QString				lastRecogLabel_;	// embed 스테이지 전용: 선택 프레임 사이 오버레이
+		cv::Scalar			lastRecogColor_;
 		SimilarityDecision  decision_;
 		std::unique_ptr<FaceMatcher> matcher_;
 
@@ -339,6 +462,8 @@ public slots:
 
 		uint32_t seq_ = 0;
 
+		// 스테이지 스레드가 위 멤버(카메라/검출기/매처/...)를 쓰므로 마지막에 선언 -> 가장 먼저 소멸 (스레드 join)
+		RecognitionPipeline pipeline_;
 };
 
 
@@ -0,0 +1,202 @@
+#include "services/GalleryService.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDebug>
+
+#include "include/common_path.hpp"
+
+namespace {
+
+// face_<id>_<name>_<n>.png -> id (형식이 아니면 -1)
+int idFromFileName(const QString& file)
+{
+	if (!file.startsWith(QStringLiteral("face_"))) return -1;
+	bool ok = false;
+	const int id = file.section('_', 1, 1).toInt(&ok);
+	return ok ? id : -1;
+}
+
+} // namespace
+
+const GalleryUserInfo* GalleryService::View::find(int id) const
+{
+	auto it = std::lower_bound(users.begin(), users.end(), id,
+			[] (const GalleryUserInfo& u, int v) { return u.id < v; });
+	return (it != users.end() && it->id == id) ? &*it : nullptr;
+}
+
+GalleryService::Delta GalleryService::View::since(quint64 since) const
+{
+	Delta d;
+	d.full = since == 0 || since > version || since < horizon;
+	for (const auto& u : users) {
+		if (d.full || u.changed > since) d.users.push_back(&u);
+	}
+	if (d.full) return d;
+
+	auto it = std::upper_bound(removed.begin(), removed.end(), since,
+			[] (quint64 v, const Removed& r) { return v < r.version; });
+	for (; it != removed.end(); ++it) d.removed.push_back(it->id);
+	return d;
+}
+
+GalleryService::GalleryService(QObject* parent)
+	: QObject(parent), gallery_(GallerySnapshot::empty())
+{
+	auto v = std::make_shared<View>();
+	v->epoch = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch());
+	view_ = std::move(v);
+}
+
+GalleryService::ViewPtr GalleryService::view() const
+{
+	return std::atomic_load(&view_);
+}
+
+void GalleryService::publish(const GallerySnapshot::Ptr& g)
+{
+	quint64 v = 0;
+	bool bumped = false;
+	{
+		QMutexLocker lk(&writeMutex_);
+		// 쓰기 측은 락 밖에서 게시 -> 늦게 도착한 이전 버전으로 되돌아가지 않게
+		if (g && g->version() < gallery_->version()) return;
+		const GallerySnapshot::Ptr prev = std::move(gallery_);
+		gallery_ = g ? g : GallerySnapshot::empty();
+		bumped = rebuildLocked(prev.get());
+		v = view_->version;
+	}
+	if (bumped) emit changed(v);
+}
+
+void GalleryService::refreshImages()
+{
+	QDir dir(USER_FACES_DIR);
+	QStringList files = dir.entryList(QStringList() << "*.png" << "*.jpg", QDir::Files, QDir::Name);
+
+	quint64 v = 0;
+	bool bumped = false;
+	{
+		QMutexLocker lk(&writeMutex_);
+		files_ = std::move(files);
+		bumped = rebuildLocked();
+		v = view_->version;
+	}
+	if (bumped) emit changed(v);
+}
+
+bool GalleryService::removeImage(const QString& path)
+{
+	if (!QFile::remove(path)) return false;
+
+	quint64 v = 0;
+	bool bumped = false;
+	{
+		QMutexLocker lk(&writeMutex_);
+		files_.removeAll(QFileInfo(path).fileName());
+		bumped = rebuildLocked();
+		v = view_->version;
+	}
+	if (bumped) emit changed(v);
+	return true;
+}
+
+// 사용자 목록(갤러리) + 이미지 목록(files_) -> 새 View
+//  사용자별 changed 는 이전 View 와 비교해 달라진 것만 새 버전으로, 사라진 ID 는 삭제 기록으로
+//  달라진 게 없으면(같은 내용 재게시, 이미지 재탐색 등) 버전은 그대로 두고 기반 갤러리 번호만 갱신
+bool GalleryService::rebuildLocked(const GallerySnapshot* prevGallery)
+{
+	const ViewPtr prev = view_;
+	auto next = std::make_shared<View>();
+	next->version = prev->version + 1;
+	next->epoch	  = prev->epoch;
+	next->horizon = prev->horizon;
+	next->gallery = gallery_->version();
+
+	const auto& users = gallery_->users();
+	next->users.reserve(static_cast<int>(users.size()));
+	for (const auto& u : users) {
+		GalleryUserInfo info;
+		info.id			= u->id;
+		info.name		= u->name;
+		info.dim		= u->dim;
+		info.prototypes = u->protoCount();
+		next->users.push_back(std::move(info));
+	}
+	std::sort(next->users.begin(), next->users.end(),
+			[] (const GalleryUserInfo& a, const GalleryUserInfo& b) { return a.id < b.id; });
+
+	const QDir dir(USER_FACES_DIR);
+	next->images.reserve(files_.size());
+	for (const QString& file : files_) {
+		GalleryImage img;
+		img.filePath = dir.filePath(file);
+		img.userId	 = idFromFileName(file);
+
+		auto owner = std::lower_bound(next->users.begin(), next->users.end(), img.userId,
+				[] (const GalleryUserInfo& u, int v) { return u.id < v; });
+		if (img.userId >= 0 && owner != next->users.end() && owner->id == img.userId) {
+			img.userName = owner->name;
+			owner->images.append(img.filePath);
+		}
+		else {
+			img.userName = file.section('_', 2, 2);
+		}
+		next->images.push_back(std::move(img));
+	}
+
+	// 변경 표시: 이름/이미지/프로토타입 수가 다르거나 임베딩이 바뀐(재등록) 사용자
+	const qint64 now = QDateTime::currentMSecsSinceEpoch();
+	bool dirty = next->users.size() != prev->users.size() || next->images.size() != prev->images.size();
+	for (qsizetype i = 0; !dirty && i < next->images.size(); ++i) {
+		dirty = next->images[i].filePath != prev->images[i].filePath
+			 || next->images[i].userName != prev->images[i].userName;
+	}
+	for (auto& u : next->users) {
+		const GalleryUserInfo* old = prev->find(u.id);
+		bool same = old && old->name == u.name && old->dim == u.dim
+				 && old->prototypes == u.prototypes && old->images == u.images;
+		if (same && prevGallery && prevGallery != gallery_.get()) {
+			// 블록을 공유하면 그대로, 다시 읽어 온 블록이면 행 비교
+			const GalleryUser* a = prevGallery->find(u.id);
+			const GalleryUser* b = gallery_->find(u.id);
+			same = a && b && (a == b || a->sameVectors(*b));
+		}
+		u.changed	= same ? old->changed	: next->version;
+		u.changedMs = same ? old->changedMs : now;
+		dirty = dirty || !same;
+	}
+
+	// 사용자 수가 같고 모두 그대로면 사라진 ID 도 없음 -> 버전 유지
+	if (!dirty) {
+		if (prev->gallery != next->gallery) {
+			auto same = std::make_shared<View>(*prev);
+			same->gallery = next->gallery;
+			std::atomic_store(&view_, ViewPtr(std::move(same)));
+		}
+		return false;
+	}
+
+	// 삭제 기록: 다시 생긴 ID 는 지우고, 사라진 ID 는 추가
+	for (const auto& r : prev->removed) {
+		if (!next->find(r.id)) next->removed.push_back(r);
+	}
+	for (const auto& u : prev->users) {
+		if (!next->find(u.id)) next->removed.push_back(Removed{ u.id, next->version });
+	}
+	if (next->removed.size() > kMaxRemoved) {
+		const int drop = next->removed.size() - kMaxRemoved;
+		next->horizon = next->removed[drop - 1].version;
+		next->removed.remove(0, drop);
+	}
+
+	std::atomic_store(&view_, ViewPtr(std::move(next)));
+	qDebug() << "[GalleryService] v" << view_->version << "gallery v" << view_->gallery
+			 << "users=" << view_->users.size() << "images=" << view_->images.size();
+	return true;
+}
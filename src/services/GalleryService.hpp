@@ -0,0 +1,89 @@
+#pragma once
+#include <memory>
+#include <QObject>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "match/GallerySnapshot.hpp"
+
+// 갤러리 메타데이터 단일 소스 (BLE / GUI / 인식)
+//  - 사용자(ID, 이름, 차원, 프로토타입 수) + 등록 이미지 경로를 한 버전(View)으로 묶어 메모리에 보관
+//  - 읽기: view() 로 불변 스냅샷을 잡고 락 없이 사용 (파일 파싱 없음)
+//  - 쓰기: 인식 서비스가 새 GallerySnapshot 을 게시할 때 / 등록 이미지가 바뀔 때만
+//    사용자 목록/메타데이터/이미지가 실제로 달라졌을 때만 버전 +1, changed() 통지
+//  - 버전은 메모리에만 있음 -> epoch(서비스 시작 시각)가 같은 클라이언트에게만 변경분이 의미 있음
+struct GalleryUserInfo {
+	int			id			= -1;
+	QString		name;
+	int			dim			= 0;
+	int			prototypes	= 0;			// 0 이면 평균 임베딩 하나
+	QStringList images;						// USER_FACES_DIR 의 등록 이미지 경로
+	quint64		changed		= 0;			// 마지막으로 바뀐 View 버전 (추가/재등록/이름/이미지)
+	qint64		changedMs	= 0;			// 그 시각 (UTC ms)
+};
+
+struct GalleryImage {
+	QString filePath;
+	int		userId	 = -1;					// 파일 이름에서 읽은 ID (해석 불가 -1)
+	QString userName;						// 갤러리에 있으면 갤러리 이름, 아니면 파일 이름
+};
+
+class GalleryService : public QObject {
+	Q_OBJECT
+	public:
+		static constexpr int kMaxRemoved = 256;			// 보관하는 삭제 기록 수 (넘치면 오래된 것부터 버리고 horizon 이동)
+
+		struct Removed {
+			int		id		= -1;
+			quint64 version = 0;							// 삭제된 View 버전
+		};
+
+		// since 이후 변경분 (full 이면 users 가 전체 목록, removed 는 비어 있음)
+		struct Delta {
+			bool							full = false;
+			QVector<const GalleryUserInfo*> users;			// View 가 살아 있는 동안만 유효
+			QVector<int>					removed;
+		};
+
+		struct View {
+			quint64						version	= 0;		// 이 서비스의 변경 번호
+			quint64						epoch	= 0;		// 서비스 시작 시각 (재부팅하면 버전 체계가 바뀜)
+			quint64						horizon	= 0;		// 이 버전 이후로는 삭제 기록이 빠짐없이 남아 있음
+			quint64						gallery	= 0;		// 기반 GallerySnapshot 버전
+			QVector<GalleryUserInfo>	users;				// ID 오름차순
+			QVector<GalleryImage>		images;				// 파일 이름순 (갤러리에 없는 사용자 이미지 포함)
+			QVector<Removed>			removed;			// 삭제 기록, 버전 오름차순
+
+			const GalleryUserInfo* find(int id) const;		// 없으면 nullptr
+			// since 를 본 클라이언트가 따라오는 데 필요한 변경분
+			//  since == 0 / 미래 버전 / horizon 이전이면 전체 목록
+			Delta since(quint64 since) const;
+		};
+		using ViewPtr = std::shared_ptr<const View>;
+
+		explicit GalleryService(QObject* parent = nullptr);
+
+		ViewPtr view() const;
+		quint64 version() const { return view()->version; }
+
+		// 인식 서비스가 갤러리를 바꾼 뒤 호출 (이미지 목록은 유지)
+		void publish(const GallerySnapshot::Ptr& g);
+		// USER_FACES_DIR 를 다시 읽음 (등록 완료 / 사용자 삭제 / 초기화 후)
+		void refreshImages();
+		// 등록 이미지 한 장 삭제 + 목록 갱신 (디렉터리 재탐색 없음)
+		bool removeImage(const QString& path);
+
+	signals:
+		void changed(quint64 version);
+
+	private:
+		// writeMutex_ 보유. 달라진 게 있어 버전이 올라갔으면 true
+		bool rebuildLocked(const GallerySnapshot* prevGallery = nullptr);
+
+		mutable QMutex				writeMutex_;		// 쓰기 측 직렬화 (읽기는 view_ 원자 교체)
+		ViewPtr						view_;
+		GallerySnapshot::Ptr		gallery_;			// 마지막으로 게시된 갤러리 (writeMutex_)
+		QStringList					files_;				// 등록 이미지 파일 이름 (writeMutex_)
+};
@@ -3,20 +3,24 @@
 #include <QList>
 
 class UserImagePresenter;
+class GalleryService;
 
 struct UserImage {
 		QString filePath;
 		QString userName;
 };
 
+// 사용자/이미지 목록은 GalleryService 의 메모리 스냅샷에서 읽음 (파일 파싱 없음)
 class UserImageService {
 		public:
-				explicit UserImageService(UserImagePresenter* presenter);
+				explicit UserImageService(UserImagePresenter* presenter, GalleryService* gallery = nullptr);
 				void setPresenter(UserImagePresenter* presenter);
-				static QList<UserImage> getUserImages();
-				static bool deleteImage(const QString& path);
+				void setGalleryService(GalleryService* gallery);
+				QList<UserImage> getUserImages() const;
+				bool deleteImage(const QString& path);
 				void fetchUserList();
 
 		private:
 				UserImagePresenter* presenter;
+				GalleryService* gallery = nullptr;
 };
@@ -0,0 +1,405 @@
+// EmbeddingJournal 단위 테스트 (프레임워크 없이 실패 시 0 아닌 종료 코드)
+//  - 왕복: 추가/갱신/삭제 레코드를 쓰고 다시 열어 재적용한 결과가 쓴 내용과 같은지
+//  - 끝 손상: 마지막 레코드가 잘렸거나 CRC 가 틀리면 그 앞까지만 적용하고 파일을 잘라내는지
+//  - 잘못된 레코드: 프레임/CRC 는 맞는데 내용을 쓸 수 없으면 건너뛰고 뒤 레코드는 그대로 적용하는지
+//  - 외부 변경: 다른 인스턴스가 덧붙이거나 파일을 교체해도 재적용이 파일 기준으로 읽는지
+//  - 압축: 기반 저장 중에 덧붙인 레코드가 압축 뒤에도 남고 그 앞 레코드만 빠지는지
+//  - 사용자 삭제: 한 명 삭제가 작은 삭제 레코드 하나로 남고 재적용 시 그 사용자만 빠지는지
+#include "match/EmbeddingJournal.hpp"
+#include "match/EmbeddingStore.hpp"		// crc32c
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <string>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+int g_failed = 0;
+
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+			++g_failed; \
+		} \
+	} while (0)
+
+GalleryUserPtr makeUser(int id, const char* name, int dim, int protos, float seed)
+{
+	UserEmbedding u;
+	u.id   = id;
+	u.name = QString::fromUtf8(name);
+	u.embedding.resize(dim);
+	for (int i = 0; i < dim; ++i) u.embedding[i] = seed + 0.01f * i;
+	for (int k = 0; k < protos; ++k) {
+		std::vector<float> p(dim);
+		for (int i = 0; i < dim; ++i) p[i] = seed - 0.5f * (k + 1) + 0.001f * i;
+		u.prototypes.push_back(std::move(p));
+	}
+	return GalleryUser::make(u);
+}
+
+bool nearRow(const float* a, const float* b, int dim)
+{
+	for (int i = 0; i < dim; ++i) if (std::abs(a[i] - b[i]) > 1e-6f) return false;
+	return true;
+}
+
+// 재적용 블록은 다시 정규화되므로 행은 오차 범위로 비교
+bool sameUser(const GalleryUser& a, const GalleryUser& b)
+{
+	if (a.id != b.id || a.name != b.name || a.dim != b.dim || a.rows != b.rows || a.prototypes != b.prototypes) return false;
+	if (!nearRow(a.mean, b.mean, a.dim)) return false;
+	for (int r = 0; r < a.rows; ++r) if (!nearRow(a.row(r), b.row(r), a.dim)) return false;
+	return true;
+}
+
+const GalleryUser* findUser(const std::vector<GalleryUserPtr>& users, int id)
+{
+	for (const auto& u : users) if (u->id == id) return u.get();
+	return nullptr;
+}
+
+off_t fileSize(const std::string& path)
+{
+	struct stat st{};
+	return ::stat(path.c_str(), &st) == 0 ? st.st_size : -1;
+}
+
+std::string tempDir()
+{
+	char tmpl[] = "/tmp/embjournal_test_XXXXXX";
+	const char* d = ::mkdtemp(tmpl);
+	return d ? std::string(d) : std::string();
+}
+
+// 기반(users) 위에 추가/갱신/삭제 -> 닫고 다시 열어 재적용
+void testRoundTrip(const std::string& dir)
+{
+	const std::string path = dir + "/roundtrip.journal";
+	const GalleryUserPtr alice	= makeUser(1, "alice", 128, 0, 0.10f);
+	const GalleryUserPtr bob	= makeUser(2, "밥", 128, 3, 0.20f);		// UTF-8 이름 + 프로토타입
+	const GalleryUserPtr alice2 = makeUser(1, "alice", 128, 2, 0.30f);	// 재등록
+	const GalleryUserPtr carol	= makeUser(3, "carol", 128, 0, 0.40f);
+
+	{
+		EmbeddingJournal j(QString::fromStdString(path));
+		CHECK(j.open());
+		const uint64_t s1 = j.appendUpsert(*alice);
+		const uint64_t s2 = j.appendUpsert(*bob);
+		const uint64_t s3 = j.appendUpsert(*alice2);
+		const uint64_t s4 = j.appendUpsert(*carol);
+		const uint64_t s5 = j.appendDelete(3);
+		CHECK(s1 > 0 && s2 > s1 && s3 > s2 && s4 > s3 && s5 > s4);
+		CHECK(j.sync(s5));
+		CHECK(j.sync(s2));				// 이미 확정된 순번
+		CHECK(j.bytes() == fileSize(path));
+	}
+
+	EmbeddingJournal j(QString::fromStdString(path));
+	CHECK(j.open());
+
+	// 기반에 있던 사용자(99)는 그대로, 저널의 변경만 반영
+	std::vector<GalleryUserPtr> users{ makeUser(99, "base", 128, 0, 0.9f) };
+	const int applied = j.replay(users);
+	CHECK(applied == 5);
+	CHECK(users.size() == 3);
+	CHECK(findUser(users, 99) != nullptr);
+	CHECK(findUser(users, 1) && sameUser(*findUser(users, 1), *alice2));
+	CHECK(findUser(users, 2) && sameUser(*findUser(users, 2), *bob));
+	CHECK(findUser(users, 3) == nullptr);
+
+	// 재적용은 멱등
+	std::vector<GalleryUserPtr> again = users;
+	CHECK(j.replay(again) == 5);
+	CHECK(again.size() == users.size());
+
+	// reset 후에는 레코드 없음
+	CHECK(j.reset());
+	std::vector<GalleryUserPtr> none;
+	CHECK(j.replay(none) == 0);
+	CHECK(none.empty());
+	CHECK(j.bytes() == EmbeddingJournal::kHeaderBytes);
+}
+
+// 마지막 레코드가 덜 쓰였거나(전원 차단) 내용이 깨진 경우
+void testTornTail(const std::string& dir)
+{
+	const std::string path = dir + "/torn.journal";
+	const GalleryUserPtr a = makeUser(10, "a", 64, 1, 0.1f);
+	const GalleryUserPtr b = makeUser(11, "b", 64, 0, 0.2f);
+	const GalleryUserPtr c = makeUser(12, "c", 64, 0, 0.3f);
+
+	off_t goodSize = 0;
+	{
+		EmbeddingJournal j(QString::fromStdString(path));
+		CHECK(j.open());
+		CHECK(j.sync(j.appendUpsert(*a)));
+		CHECK(j.sync(j.appendUpsert(*b)));
+		goodSize = fileSize(path);
+		CHECK(j.sync(j.appendUpsert(*c)));
+	}
+
+	// 1) 마지막 레코드 중간에서 잘림
+	const off_t full = fileSize(path);
+	CHECK(::truncate(path.c_str(), full - 7) == 0);
+	{
+		EmbeddingJournal j(QString::fromStdString(path));
+		CHECK(j.open());
+		std::vector<GalleryUserPtr> users;
+		CHECK(j.replay(users) == 2);
+		CHECK(users.size() == 2 && findUser(users, 10) && findUser(users, 11) && !findUser(users, 12));
+		CHECK(fileSize(path) == goodSize);			// 잘린 꼬리 제거
+		CHECK(j.bytes() == goodSize);
+
+		// 잘라낸 뒤 이어 쓰기 -> 다시 읽으면 이어 쓴 레코드까지
+		CHECK(j.sync(j.appendUpsert(*c)));
+	}
+	{
+		EmbeddingJournal j(QString::fromStdString(path));
+		CHECK(j.open());
+		std::vector<GalleryUserPtr> users;
+		CHECK(j.replay(users) == 3);
+		CHECK(findUser(users, 12) && sameUser(*findUser(users, 12), *c));
+	}
+
+	// 2) 길이는 온전하지만 마지막 레코드 내용이 깨짐 (CRC 불일치)
+	{
+		const int fd = ::open(path.c_str(), O_RDWR);
+		CHECK(fd >= 0);
+		const char junk = 0x5a;
+		CHECK(::pwrite(fd, &junk, 1, fileSize(path) - 3) == 1);
+		::close(fd);
+	}
+	{
+		EmbeddingJournal j(QString::fromStdString(path));
+		CHECK(j.open());
+		std::vector<GalleryUserPtr> users;
+		CHECK(j.replay(users) == 2);
+		CHECK(!findUser(users, 12));
+		CHECK(fileSize(path) == goodSize);
+	}
+
+	// 3) 레코드 헤더(길이)조차 다 못 쓴 경우
+	CHECK(::truncate(path.c_str(), goodSize + 3) == 0);
+	{
+		EmbeddingJournal j(QString::fromStdString(path));
+		CHECK(j.open());
+		std::vector<GalleryUserPtr> users;
+		CHECK(j.replay(users) == 2);
+		CHECK(fileSize(path) == goodSize);
+	}
+}
+
+// 프레임 [len][crc][payload] 를 직접 덧붙임 (payload 는 레코드 헤더 20바이트만)
+void appendRawRecord(const std::string& path, uint8_t op, int32_t id, uint32_t dim)
+{
+	unsigned char payload[20] = {};
+	payload[0] = op;
+	std::memcpy(payload + 4, &id, 4);
+	std::memcpy(payload + 8, &dim, 4);
+	const uint32_t head[2] = { sizeof(payload), EmbeddingStore::crc32c(payload, sizeof(payload)) };
+
+	const int fd = ::open(path.c_str(), O_WRONLY | O_APPEND);
+	CHECK(fd >= 0);
+	CHECK(::write(fd, head, sizeof(head)) == ssize_t(sizeof(head)));
+	CHECK(::write(fd, payload, sizeof(payload)) == ssize_t(sizeof(payload)));
+	::close(fd);
+}
+
+// 중간의 쓸 수 없는 레코드 (dim 0 블록, 모르는 op) -> 건너뛰고 뒤 레코드 유지, 파일은 그대로
+void testBadRecord(const std::string& dir)
+{
+	const std::string path = dir + "/bad.journal";
+	const GalleryUserPtr a = makeUser(60, "a", 64, 0, 0.1f);
+	const GalleryUserPtr c = makeUser(62, "c", 64, 1, 0.3f);
+	{
+		EmbeddingJournal j(QString::fromStdString(path));
+		CHECK(j.open());
+		CHECK(j.sync(j.appendUpsert(*a)));
+	}
+	appendRawRecord(path, 1, 61, 0);		// Upsert, dim 0 -> 사용자 블록 생성 불가
+	appendRawRecord(path, 9, 60, 0);		// 모르는 op
+	{
+		EmbeddingJournal j(QString::fromStdString(path));
+		CHECK(j.open());
+		CHECK(j.sync(j.appendUpsert(*c)));
+		CHECK(j.sync(j.appendDelete(60)));
+	}
+	const off_t full = fileSize(path);
+
+	EmbeddingJournal j(QString::fromStdString(path));
+	CHECK(j.open());
+	std::vector<GalleryUserPtr> users;
+	CHECK(j.replay(users) == 3);
+	CHECK(users.size() == 1);
+	CHECK(findUser(users, 62) && sameUser(*findUser(users, 62), *c));
+	CHECK(!findUser(users, 61) && !findUser(users, 60));
+	CHECK(fileSize(path) == full);			// 잘라내지 않음
+	CHECK(j.bytes() == full);
+}
+
+// 같은 파일을 연 다른 인스턴스(= 다른 프로세스)가 덧붙임 / 통째로 교체
+void testExternalWriter(const std::string& dir)
+{
+	const std::string path = dir + "/external.journal";
+	const GalleryUserPtr a = makeUser(20, "a", 64, 0, 0.1f);
+	const GalleryUserPtr b = makeUser(21, "b", 64, 2, 0.2f);
+
+	EmbeddingJournal mine(QString::fromStdString(path));
+	CHECK(mine.open());
+	CHECK(mine.sync(mine.appendUpsert(*a)));
+
+	EmbeddingJournal other(QString::fromStdString(path));
+	CHECK(other.open());
+	CHECK(other.sync(other.appendUpsert(*b)));
+	CHECK(mine.bytes() < fileSize(path));			// 아직 모름
+
+	// 재적용은 캐시된 크기가 아니라 파일 끝까지
+	std::vector<GalleryUserPtr> users;
+	CHECK(mine.replay(users) == 2);
+	CHECK(findUser(users, 21) && sameUser(*findUser(users, 21), *b));
+	CHECK(mine.bytes() == fileSize(path));
+
+	// 다른 쪽이 초기화(rename 교체) -> 내 fd 는 지난 파일, 재적용 시 새 파일로 다시 열어야 함
+	CHECK(other.sync(other.appendDelete(20)));
+	CHECK(other.reset());
+	CHECK(other.sync(other.appendUpsert(*a)));
+	std::vector<GalleryUserPtr> after;
+	CHECK(mine.replay(after) == 1);
+	CHECK(after.size() == 1 && findUser(after, 20));
+	CHECK(mine.bytes() == fileSize(path));
+
+	// 다시 연 파일에 이어 쓰기
+	CHECK(mine.sync(mine.appendDelete(20)));
+	std::vector<GalleryUserPtr> last;
+	CHECK(other.replay(last) == 2);
+	CHECK(last.empty());
+}
+
+// compactAsync: 기반 저장(writeBase) 도중 덧붙인 레코드는 mark 뒤라 새 파일에 남아야 함
+void testCompaction(const std::string& dir)
+{
+	const std::string path = dir + "/compact.journal";
+	const GalleryUserPtr a = makeUser(50, "a", 64, 0, 0.1f);
+	const GalleryUserPtr b = makeUser(51, "b", 64, 2, 0.2f);
+	const GalleryUserPtr c = makeUser(52, "c", 64, 1, 0.3f);
+	const GalleryUserPtr b2 = makeUser(51, "b", 64, 0, 0.4f);
+
+	EmbeddingJournal j(QString::fromStdString(path));
+	CHECK(j.open());
+	CHECK(j.appendUpsert(*a) > 0);
+	CHECK(j.sync(j.appendUpsert(*b)));
+	const qint64 mark = j.bytes();
+
+	std::promise<void> started, release;
+	std::future<void> released = release.get_future();
+	CHECK(j.compactAsync([&] {
+		started.set_value();
+		released.wait();			// 기반 저장 중
+		return true;
+	}));
+	started.get_future().wait();
+	CHECK(j.compacting());
+	CHECK(!j.compactAsync([] { return true; }));	// 이미 압축 중
+
+	// 압축 중 쓰기 (mark 뒤)
+	CHECK(j.appendUpsert(*c) > 0);
+	CHECK(j.appendDelete(50) > 0);
+	CHECK(j.sync(j.appendUpsert(*b2)));
+	const qint64 tail = j.bytes() - mark;
+	release.set_value();
+	j.waitCompaction();
+	CHECK(!j.compacting());
+	CHECK(j.bytes() == fileSize(path));
+	CHECK(j.bytes() == EmbeddingJournal::kHeaderBytes + tail);
+
+	// 다시 열면 mark 뒤 3개만: 기반(a, b) 위에 c 추가, a 삭제, b 갱신
+	EmbeddingJournal k(QString::fromStdString(path));
+	CHECK(k.open());
+	std::vector<GalleryUserPtr> users{ a, b };
+	CHECK(k.replay(users) == 3);
+	CHECK(users.size() == 2);
+	CHECK(findUser(users, 50) == nullptr);
+	CHECK(findUser(users, 51) && sameUser(*findUser(users, 51), *b2));
+	CHECK(findUser(users, 52) && sameUser(*findUser(users, 52), *c));
+
+	// 압축 뒤 이어 쓰기도 같은 파일에
+	CHECK(j.sync(j.appendDelete(52)));
+	std::vector<GalleryUserPtr> again{ a, b };
+	CHECK(k.replay(again) == 4);
+	CHECK(again.size() == 1 && findUser(again, 51));
+
+	// 기반 저장 실패 -> 저널 그대로
+	const qint64 kept = j.bytes();
+	CHECK(j.compactAsync([] { return false; }));
+	j.waitCompaction();
+	CHECK(j.bytes() == kept && fileSize(path) == kept);
+	std::vector<GalleryUserPtr> same{ a, b };
+	CHECK(k.replay(same) == 4);
+}
+
+// deleteUser 경로: 기반 갤러리에서 한 명만 삭제 -> 레코드 하나 (프레임 8 + 헤더만, 임베딩 없음)
+void testDeleteUser(const std::string& dir)
+{
+	const std::string path = dir + "/delete.journal";
+	{
+		EmbeddingJournal j(QString::fromStdString(path));
+		CHECK(j.open());
+		const qint64 before = j.bytes();
+		CHECK(j.sync(j.appendDelete(31)));
+		CHECK(j.bytes() == fileSize(path));
+		CHECK(j.bytes() - before > 8 && j.bytes() - before <= 8 + 32);
+	}
+
+	EmbeddingJournal j(QString::fromStdString(path));
+	CHECK(j.open());
+	std::vector<GalleryUserPtr> users{
+		makeUser(30, "keep", 64, 0, 0.1f),
+		makeUser(31, "gone", 64, 2, 0.2f),
+		makeUser(32, "keep2", 64, 1, 0.3f)
+	};
+	CHECK(j.replay(users) == 1);
+	CHECK(users.size() == 2);
+	CHECK(findUser(users, 30) && findUser(users, 32));
+	CHECK(findUser(users, 31) == nullptr);
+
+	// 없는 사용자 삭제 레코드는 무시
+	std::vector<GalleryUserPtr> other{ makeUser(40, "x", 64, 0, 0.4f) };
+	CHECK(j.replay(other) == 1);
+	CHECK(other.size() == 1 && findUser(other, 40));
+}
+
+} // namespace
+
+int main()
+{
+	const std::string dir = tempDir();
+	if (dir.empty()) {
+		std::fprintf(stderr, "mkdtemp failed\n");
+		return 2;
+	}
+
+	testRoundTrip(dir);
+	testTornTail(dir);
+	testBadRecord(dir);
+	testExternalWriter(dir);
+	testCompaction(dir);
+	testDeleteUser(dir);
+
+	std::string cmd = "rm -rf '" + dir + "'";
+	if (std::system(cmd.c_str()) != 0) std::fprintf(stderr, "cleanup failed: %s\n", dir.c_str());
+
+	if (g_failed) {
+		std::fprintf(stderr, "%d check(s) failed\n", g_failed);
+		return 1;
+	}
+	std::printf("EmbeddingJournalTest: all checks passed\n");
+	return 0;
+}